@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Sparse>
+#include "MeshPartitioner.h"
+
+
+//! @brief Fixed set of worker threads that run parallel loops, the calling thread takes part as thread 0
+//!
+//! Starting threads for every color of every assembly costs more than assembling a small color, the workers
+//! are therefore started once and wait for the next loop.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int numThreads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (int thread = 1; thread < numThreads; ++thread)
+            mWorkers.emplace_back([this, thread] { WorkerLoop(thread); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWake.notify_all();
+        for (auto& worker : mWorkers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const
+    {
+        return mWorkers.size() + 1;
+    }
+
+    //! @brief Calls \a function(i, thread) for all i in [0, numItems), exceptions are passed to the caller
+    //!
+    //! The threads take chunks of \a chunkSize consecutive items until none are left, thread is the index of
+    //! the executing thread in [0, size()), e.g. to select its scratch buffers.
+    template <typename Function>
+    void ParallelFor(int numItems, Function function, int chunkSize = 16)
+    {
+        std::atomic<int> next(0);
+        std::vector<std::exception_ptr> errors(size());
+        auto job = [&](int thread) {
+            try
+            {
+                for (int begin = next.fetch_add(chunkSize); begin < numItems; begin = next.fetch_add(chunkSize))
+                    for (int i = begin; i < std::min(begin + chunkSize, numItems); ++i)
+                        function(i, thread);
+            }
+            catch (...)
+            {
+                errors[thread] = std::current_exception();
+                next = numItems;
+            }
+        };
+
+        if (mWorkers.empty() or numItems <= chunkSize)
+            job(0);
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mJob = job;
+                mNumBusy = mWorkers.size();
+                ++mGeneration;
+            }
+            mWake.notify_all();
+            job(0);
+            std::unique_lock<std::mutex> lock(mMutex);
+            mDone.wait(lock, [this] { return mNumBusy == 0; });
+        }
+
+        for (const auto& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
+
+private:
+    void WorkerLoop(int thread)
+    {
+        long generation = 0;
+        while (true)
+        {
+            std::function<void(int)> job;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWake.wait(lock, [&] { return mStop or mGeneration != generation; });
+                if (mStop)
+                    return;
+                generation = mGeneration;
+                job = mJob;
+            }
+            job(thread);
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (--mNumBusy == 0)
+                    mDone.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    std::function<void(int)> mJob;
+    long mGeneration = 0;
+    int mNumBusy = 0;
+    bool mStop = false;
+};
+
+
+//! @brief Greedy coloring of the elements, elements of the same color share no node
+//!
+//! Like Structure::CalculateMaximumIndependentSets, every element gets the smallest color that none of the
+//! already colored elements at its nodes has. The elements of each color are in ascending order.
+std::vector<std::vector<int>> ElementColors(const ImportContainer& rMesh)
+{
+    const ElementBlock& elements = rMesh.mElementList;
+    const int numElements = elements.size();
+    const std::vector<int> nodeIndices = NodeIndices(rMesh).GlobalToLocal(elements.mNodeIds);
+
+    // colors used at each node, a node has as many colors as elements
+    std::vector<int> nodeOffsets(rMesh.mNodeList.size() + 1, 0);
+    for (const int node : nodeIndices)
+        ++nodeOffsets[node + 1];
+    std::partial_sum(nodeOffsets.begin(), nodeOffsets.end(), nodeOffsets.begin());
+    std::vector<int> nodeColors(nodeIndices.size());
+    std::vector<int> numNodeColors(rMesh.mNodeList.size(), 0);
+
+    std::vector<std::vector<int>> colors;
+    std::vector<int> blockedBy; // element that last blocked a color
+    for (int element = 0; element < numElements; ++element)
+    {
+        for (int i = elements.mOffsets[element]; i < elements.mOffsets[element + 1]; ++i)
+        {
+            const int node = nodeIndices[i];
+            for (int j = nodeOffsets[node]; j < nodeOffsets[node] + numNodeColors[node]; ++j)
+                blockedBy[nodeColors[j]] = element;
+        }
+
+        int color = 0;
+        while (color < static_cast<int>(colors.size()) and blockedBy[color] == element)
+            ++color;
+        if (color == static_cast<int>(colors.size()))
+        {
+            colors.emplace_back();
+            blockedBy.push_back(-1);
+        }
+        colors[color].push_back(element);
+
+        for (int i = elements.mOffsets[element]; i < elements.mOffsets[element + 1]; ++i)
+        {
+            const int node = nodeIndices[i];
+            nodeColors[nodeOffsets[node] + numNodeColors[node]++] = color;
+        }
+    }
+    return colors;
+}
+
+
+//! @brief Assembles a global matrix and vector from element contributions on all threads of a pool, without locks
+//!
+//! The elements are processed color by color, elements of one color share no node and thus no entry of the
+//! global matrix or vector, so the threads add their element contributions directly. The position of every
+//! element matrix entry in the values of the compressed matrix is computed once, each assembly is then a
+//! plain scatter into a fixed sparsity pattern, which also lets a SymbolicReuseSolver skip the analysis.
+//! The summation order of every entry only depends on the colors, the result is therefore bitwise the same for
+//! any number of threads.
+//!
+//! Dofs are numbered node by node, numDofsPerNode per node in the order of the node list. This is the local
+//! assembly of a FETI subdomain as well as the global assembly of a NewmarkDirect structure.
+class ColoredAssembler
+{
+public:
+    ColoredAssembler(const ImportContainer& rMesh, int numDofsPerNode, ThreadPool& rPool)
+        : mPool(rPool)
+        , mColors(ElementColors(rMesh))
+    {
+        const ElementBlock& elements = rMesh.mElementList;
+        const int numElements = elements.size();
+        const int numDofs = numDofsPerNode * rMesh.mNodeList.size();
+        const std::vector<int> nodeIndices = NodeIndices(rMesh).GlobalToLocal(elements.mNodeIds);
+
+        mDofOffsets.reserve(numElements + 1);
+        mDofOffsets.push_back(0);
+        mEntryOffsets.reserve(numElements + 1);
+        mEntryOffsets.push_back(0);
+        for (int element = 0; element < numElements; ++element)
+        {
+            for (int i = elements.mOffsets[element]; i < elements.mOffsets[element + 1]; ++i)
+                for (int dof = 0; dof < numDofsPerNode; ++dof)
+                    mDofs.push_back(numDofsPerNode * nodeIndices[i] + dof);
+            const long numElementDofs = mDofs.size() - mDofOffsets.back();
+            mDofOffsets.push_back(mDofs.size());
+            mEntryOffsets.push_back(mEntryOffsets.back() + numElementDofs * numElementDofs);
+        }
+
+        std::vector<Eigen::Triplet<double>> entries;
+        entries.reserve(mEntryOffsets.back());
+        for (int element = 0; element < numElements; ++element)
+            for (int j = mDofOffsets[element]; j < mDofOffsets[element + 1]; ++j)
+                for (int i = mDofOffsets[element]; i < mDofOffsets[element + 1]; ++i)
+                    entries.emplace_back(mDofs[i], mDofs[j], 0.);
+        mMatrix.resize(numDofs, numDofs);
+        mMatrix.setFromTriplets(entries.begin(), entries.end());
+        mMatrix.makeCompressed();
+        mVector = Eigen::VectorXd::Zero(numDofs);
+
+        // column major positions of the element matrix entries in the values of mMatrix
+        mEntryPositions.resize(mEntryOffsets.back());
+        mPool.ParallelFor(numElements, [&](int element, int) {
+            int* position = &mEntryPositions[mEntryOffsets[element]];
+            for (int j = mDofOffsets[element]; j < mDofOffsets[element + 1]; ++j)
+            {
+                const int* columnBegin = mMatrix.innerIndexPtr() + mMatrix.outerIndexPtr()[mDofs[j]];
+                const int* columnEnd = mMatrix.innerIndexPtr() + mMatrix.outerIndexPtr()[mDofs[j] + 1];
+                for (int i = mDofOffsets[element]; i < mDofOffsets[element + 1]; ++i)
+                    *position++ = std::lower_bound(columnBegin, columnEnd, mDofs[i]) - mMatrix.innerIndexPtr();
+            }
+        });
+    }
+
+    //! @brief Replaces matrix and vector by the sum of all element contributions
+    //!
+    //! \a kernel(element, thread, elementMatrix, elementVector) adds the contributions of an element to the zeroed
+    //! elementMatrix and elementVector, sized to the number of element dofs. Both are scratch buffers of the
+    //! calling thread, the kernel may use thread to select further buffers of its own.
+    template <typename ElementKernel>
+    void Assemble(ElementKernel kernel)
+    {
+        std::fill(mMatrix.valuePtr(), mMatrix.valuePtr() + mMatrix.nonZeros(), 0.);
+        mVector.setZero();
+        mScratch.resize(mPool.size());
+
+        double* values = mMatrix.valuePtr();
+        for (const auto& color : mColors)
+            mPool.ParallelFor(color.size(), [&](int i, int thread) {
+                const int element = color[i];
+                const int numElementDofs = mDofOffsets[element + 1] - mDofOffsets[element];
+                Eigen::MatrixXd& elementMatrix = mScratch[thread].mMatrix;
+                Eigen::VectorXd& elementVector = mScratch[thread].mVector;
+                elementMatrix.setZero(numElementDofs, numElementDofs);
+                elementVector.setZero(numElementDofs);
+
+                kernel(element, thread, elementMatrix, elementVector);
+
+                const int* position = &mEntryPositions[mEntryOffsets[element]];
+                for (int entry = 0; entry < numElementDofs * numElementDofs; ++entry)
+                    values[position[entry]] += elementMatrix.data()[entry];
+                const int* dofs = &mDofs[mDofOffsets[element]];
+                for (int dof = 0; dof < numElementDofs; ++dof)
+                    mVector[dofs[dof]] += elementVector[dof];
+            });
+    }
+
+    //! @brief Replaces the matrix by the sum of given element matrices, the vector is left unchanged
+    //!
+    //! \a elementMatrix(element) returns the matrix of an element, e.g. an ElementMatrixCache for linear elements
+    //! of a structured mesh. No element kernel is evaluated, the assembly is a pure scatter.
+    template <typename ElementMatrixFunction>
+    void AssembleMatrix(ElementMatrixFunction elementMatrix)
+    {
+        std::fill(mMatrix.valuePtr(), mMatrix.valuePtr() + mMatrix.nonZeros(), 0.);
+        double* values = mMatrix.valuePtr();
+        for (const auto& color : mColors)
+            mPool.ParallelFor(color.size(),
+                              [&](int i, int) {
+                                  const int element = color[i];
+                                  const Eigen::MatrixXd& matrix = elementMatrix(element);
+                                  const int* position = &mEntryPositions[mEntryOffsets[element]];
+                                  for (int entry = 0; entry < matrix.size(); ++entry)
+                                      values[position[entry]] += matrix.data()[entry];
+                              },
+                              256);
+    }
+
+    //! @brief Global dofs of an element, the order of the rows of its element matrix
+    std::vector<int> ElementDofs(int element) const
+    {
+        return std::vector<int>(mDofs.begin() + mDofOffsets[element], mDofs.begin() + mDofOffsets[element + 1]);
+    }
+
+    const std::vector<std::vector<int>>& GetColors() const
+    {
+        return mColors;
+    }
+
+    const Eigen::SparseMatrix<double>& GetMatrix() const
+    {
+        return mMatrix;
+    }
+
+    const Eigen::VectorXd& GetVector() const
+    {
+        return mVector;
+    }
+
+private:
+    ThreadPool& mPool;
+    std::vector<std::vector<int>> mColors;
+
+    std::vector<int> mDofOffsets;
+    std::vector<int> mDofs;
+    std::vector<long> mEntryOffsets;
+    std::vector<int> mEntryPositions;
+
+    Eigen::SparseMatrix<double> mMatrix;
+    Eigen::VectorXd mVector;
+
+    //! @brief Element matrix and vector of one thread, padded so that no two threads write to the same cache line
+    struct Scratch
+    {
+        Eigen::MatrixXd mMatrix;
+        Eigen::VectorXd mVector;
+        char mPadding[64];
+    };
+    std::vector<Scratch> mScratch;
+};
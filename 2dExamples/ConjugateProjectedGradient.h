@@ -1,26 +1,155 @@
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/Dense>
 #include <eigen3/Eigen/Sparse>
+#include "../IterationObserver.h"
 
 namespace Eigen
 {
 
+/** \brief Bounded window of previous search directions p_k and their operator products A p_k
+  *
+  * Stores at most \a capacity directions in a ring buffer. New directions are made A-conjugate to all
+  * stored ones by modified Gram-Schmidt. Since the products A p_k are kept, this requires no additional
+  * operator applications. Once the window is full, the oldest direction is overwritten.
+  */
+template <typename _Scalar>
+class SearchDirectionWindow
+{
+public:
+    typedef _Scalar Scalar;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+    typedef Matrix<Scalar, Dynamic, Dynamic> DenseMatrixType;
+    typedef typename VectorType::Index Index;
+
+    SearchDirectionWindow(Index size, Index capacity)
+        : m_directions(size, capacity)
+        , m_products(size, capacity)
+        , m_curvatures(capacity)
+        , m_count(0)
+        , m_next(0)
+    {
+    }
+
+    Index size() const
+    {
+        return m_directions.rows();
+    }
+
+    Index capacity() const
+    {
+        return m_curvatures.size();
+    }
+
+    Index count() const
+    {
+        return m_count;
+    }
+
+    void clear()
+    {
+        m_count = 0;
+        m_next = 0;
+    }
+
+    /** Stores the direction \a p together with \a Ap = A p and the curvature \a pAp = pᵀ A p */
+    template <typename DerivedP, typename DerivedAp>
+    void add(const MatrixBase<DerivedP>& p, const MatrixBase<DerivedAp>& Ap, Scalar pAp)
+    {
+        if (capacity() == 0)
+            return;
+
+        m_directions.col(m_next) = p;
+        m_products.col(m_next) = Ap;
+        m_curvatures[m_next] = pAp;
+
+        m_next = (m_next + 1) % capacity();
+        m_count = std::min(m_count + 1, capacity());
+    }
+
+    /** Makes \a v A-conjugate to all stored directions, oldest first (modified Gram-Schmidt) */
+    template <typename Derived>
+    void orthogonalize(MatrixBase<Derived>& v) const
+    {
+        for (Index k = 0; k < m_count; ++k)
+        {
+            const Index col = (m_next - m_count + k + capacity()) % capacity();
+            v -= (v.dot(m_products.col(col)) / m_curvatures[col]) * m_directions.col(col);
+        }
+    }
+
+    /** Returns the Galerkin correction W (Wᵀ A W)⁻¹ Wᵀ \a r of the residual \a r on the stored directions W.
+      *
+      * Uses the stored products, so no operator is applied. If the operator has changed slightly since the
+      * directions were stored, the result is still a good initial guess.
+      */
+    template <typename Derived>
+    VectorType galerkinCorrection(const MatrixBase<Derived>& r) const
+    {
+        if (m_count == 0)
+            return VectorType::Zero(size());
+
+        const DenseMatrixType WtAW = m_directions.leftCols(m_count).transpose() * m_products.leftCols(m_count);
+        const VectorType Wtr = m_directions.leftCols(m_count).transpose() * r;
+        return m_directions.leftCols(m_count) * WtAW.colPivHouseholderQr().solve(Wtr);
+    }
+
+protected:
+    DenseMatrixType m_directions;
+    DenseMatrixType m_products;
+    VectorType m_curvatures;
+    Index m_count;
+    Index m_next;
+};
+
+
+/** \brief Global sum of the local dot products for serial runs or vectors that are replicated on all ranks
+  *
+  * The pipelined solver starts the reduction of all its dot products at once with \c start and collects the
+  * result with \c wait after the operator application. Distributed runs pass a reduction that performs a
+  * non-blocking all-reduce in between, see MpiNonBlockingSum.
+  */
+class LocalReduction
+{
+public:
+    template <typename Scalar>
+    void start(Scalar*, int)
+    {
+    }
+
+    void wait()
+    {
+    }
+};
+
+
 namespace internal
 {
 
 /** \internal Low-level conjugate gradient algorithm
-  * \param mat The matrix A
+  * \param mat The matrix A, or any linear operator providing \c cols() and \c operator*
   * \param rhs The right hand side vector b
   * \param x On input and initial solution, on output the computed solution.
+  * \param projectionMatrix The projection P, assembled or as a linear operator
   * \param precond A preconditioner being able to efficiently solve for an
   *                approximation of Ax=b (regardless of b)
   * \param iters On input the max number of iteration, on output the number of performed iterations.
   * \param tol_error On input the tolerance error, on output an estimation of the relative error.
+  * \param reorthogonalizationWindow Number of previous search directions each new direction is made
+  *                                  A-conjugate to. 0 gives the plain CG recurrence.
+  * \param recycledDirections If given, the directions stored from a previous solve are used for a Galerkin
+  *                           warm start and then replaced by the directions of this solve. They are kept if
+  *                           the warm start already converges. The window is also used for the
+  *                           reorthogonalization instead of a local one.
+  * \param observer If given, is notified about every iteration and the time spent in each phase
   */
-template <typename MatrixType, typename Rhs, typename Dest, typename Preconditioner>
+template <typename MatrixType, typename ProjectionType, typename Rhs, typename Dest, typename Preconditioner>
 EIGEN_DONT_INLINE void conjugate_projected_gradient(const MatrixType& mat, const Rhs& rhs, Dest& x,
-                                                    const MatrixType& projectionMatrix, const Preconditioner& precond,
-                                                    int& iters, typename Dest::RealScalar& tol_error)
+                                                    const ProjectionType& projectionMatrix,
+                                                    const Preconditioner& precond, int& iters,
+                                                    typename Dest::RealScalar& tol_error,
+                                                    int reorthogonalizationWindow = 0,
+                                                    SearchDirectionWindow<typename Dest::Scalar>* recycledDirections = 0,
+                                                    NuTo::IterationObserver* observer = 0)
 {
 
     using std::sqrt;
@@ -34,8 +163,18 @@ EIGEN_DONT_INLINE void conjugate_projected_gradient(const MatrixType& mat, const
 
     int n = mat.cols();
 
+    if (recycledDirections != 0 and recycledDirections->size() != n)
+        *recycledDirections = SearchDirectionWindow<Scalar>(n, recycledDirections->capacity());
+
     VectorType residual = rhs - mat * x; // initial residual
 
+    if (recycledDirections != 0 and recycledDirections->count() > 0)
+    {
+        // warm start from the directions of the previous solve
+        x += projectionMatrix * recycledDirections->galerkinCorrection(residual);
+        residual = rhs - mat * x;
+    }
+
     RealScalar rhsNorm2 = rhs.squaredNorm();
     if (rhsNorm2 == 0)
     {
@@ -53,61 +192,601 @@ EIGEN_DONT_INLINE void conjugate_projected_gradient(const MatrixType& mat, const
         return;
     }
 
-    VectorType w = projectionMatrix * precond.solve(residual); // initial search direction
-    VectorType p = w;
+    if (observer)
+        observer->StartSolve();
 
-    //  MatrixXd pInitial(p.rows(), maxIters+1);  // test for reorthogonlization
-    //  pInitial.col(0) = w;
+    // the directions of this solve replace the recycled ones, unless the warm start already converged above
+    if (recycledDirections != 0)
+        recycledDirections->clear();
+
+    // the initial search direction, its phases are reported with the first iteration
+    VectorType z(n), tmp(n), w(n);
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+        z = precond.solve(residual);
+    }
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+        w = projectionMatrix * z;
+    }
+    VectorType p = w;
 
+    const bool reorthogonalize = reorthogonalizationWindow > 0;
+    SearchDirectionWindow<Scalar> localWindow(
+            n, recycledDirections != 0 ? 0 : std::min(reorthogonalizationWindow, std::min(maxIters, n)));
+    SearchDirectionWindow<Scalar>& window = recycledDirections != 0 ? *recycledDirections : localWindow;
 
-    VectorType z(n), tmp(n);
-    RealScalar absNew = numext::real(w.dot(w)); // the square of the absolute value of r scaled by invM
+    RealScalar absNew; // the square of the absolute value of r scaled by invM
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+        absNew = numext::real(residual.dot(w));
+    }
     RealScalar wNorm2;
     int i = 0;
     while (i < maxIters)
     {
-        tmp.noalias() = mat * p; // the bottleneck of the algorithm
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+            tmp.noalias() = mat * p; // the bottleneck of the algorithm
+        }
+
+        Scalar pAp;
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            pAp = p.dot(tmp);
+        }
+        window.add(p, tmp, pAp);
 
-        Scalar alpha = absNew / p.dot(tmp); // the amount we travel on dir
+        Scalar alpha; // the amount we travel on dir
+        if (reorthogonalize)
+        {
+            // exact line search, absNew is only the step of the short recurrence, whose residual is orthogonal
+            // to all previous directions
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            alpha = p.dot(residual) / pAp;
+        }
+        else
+            alpha = absNew / pAp;
         x += alpha * p; // update solution
         residual -= alpha * tmp; // update residue
 
-        residualNorm2 = residual.squaredNorm();
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            residualNorm2 = residual.squaredNorm();
+        }
         if (residualNorm2 < threshold)
+        {
+            if (observer)
+                observer->Iteration(i + 1, sqrt(residualNorm2 / rhsNorm2));
             break;
+        }
 
-        w = projectionMatrix * residual;
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+            w = projectionMatrix * residual;
+        }
 
         //   wNorm2 = w.squaredNorm();
         //    if (wNorm2 < threshold)
         //        break;
 
-        z = precond.solve(w); // approximately solve for "A z = residual"
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+            z = precond.solve(w); // approximately solve for "A z = residual"
+        }
 
         RealScalar absOld = absNew;
-        absNew = numext::real(w.dot(z)); // update the absolute value of r
-        RealScalar beta = absNew / absOld; // calculate the Gram-Schmidt value used to create the new search direction
-        p = z + beta * p; // update search direction
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            absNew = numext::real(w.dot(z)); // update the absolute value of r
+        }
+        if (reorthogonalize)
+        {
+            // full reorthogonalization against the window replaces the short recurrence
+            p = z;
+            window.orthogonalize(p);
+        }
+        else
+        {
+            RealScalar beta = absNew / absOld; // calculate the Gram-Schmidt value used to create the new search direction
+            p = z + beta * p; // update search direction
+        }
+
+        // reported after the projection and preconditioner of the next direction, which belong to this iteration
+        if (observer)
+            observer->Iteration(i + 1, sqrt(residualNorm2 / rhsNorm2));
+        i++;
+    }
+    tol_error = sqrt(residualNorm2 / rhsNorm2);
+    iters = i;
+}
+
+
+/** \internal Low-level block conjugate gradient algorithm for multiple right hand sides
+  *
+  * Advances all columns of \a rhs together, so the operator is applied once per iteration to a block of
+  * vectors instead of once per column. The scalar recurrence coefficients of conjugate_projected_gradient
+  * become small dense matrices with one row and column per right hand side.
+  *
+  * \param mat The matrix A, or any linear operator providing \c cols() and \c operator* for blocks of vectors
+  * \param rhs The right hand sides B, one per column
+  * \param x On input and initial solution, on output the computed solution.
+  * \param projectionMatrix The projection P, assembled or as a linear operator
+  * \param precond A preconditioner being able to efficiently solve for an
+  *                approximation of AX=B (regardless of B)
+  * \param iters On input the max number of iteration, on output the number of performed iterations.
+  * \param tol_error On input the tolerance error, on output an estimation of the largest relative error
+  *                  of all columns.
+  */
+template <typename MatrixType, typename ProjectionType, typename Rhs, typename Dest, typename Preconditioner>
+EIGEN_DONT_INLINE void block_conjugate_projected_gradient(const MatrixType& mat, const Rhs& rhs, Dest& x,
+                                                          const ProjectionType& projectionMatrix,
+                                                          const Preconditioner& precond, int& iters,
+                                                          typename Dest::RealScalar& tol_error)
+{
+    using std::sqrt;
+    typedef typename Dest::RealScalar RealScalar;
+    typedef typename Dest::Scalar Scalar;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+    typedef Matrix<Scalar, Dynamic, Dynamic> BlockType;
 
-        //    pInitial.col(i+1) = z;
-        //    std::cout << "bla" << std::endl;
-        //    for(int k = 0; k < i; ++k)
-        //    {
-        //        pInitial.col(i+1) -=
-        //        z.dot(mat*pInitial.col(k))/pInitial.col(k).dot(mat*pInitial.col(k))*pInitial.col(k);
-        //        std::cout << "bla" << std::endl;
-        //    }
-        //    p = pInitial.col(i+1);
+    RealScalar tol = tol_error;
+    int maxIters = iters;
+
+    const int n = mat.cols();
+    const int numRhs = rhs.cols();
+
+    const VectorType rhsNorms2 = rhs.colwise().squaredNorm().transpose();
+    for (int j = 0; j < numRhs; ++j)
+        if (rhsNorms2[j] == 0)
+            x.col(j).setZero();
 
+    BlockType residual = rhs - mat * x; // initial residual
+
+    const VectorType thresholds = tol * tol * rhsNorms2;
+    VectorType residualNorms2 = residual.colwise().squaredNorm().transpose();
+    if ((residualNorms2.array() <= thresholds.array()).all())
+    {
+        iters = 0;
+        tol_error = 0;
+        for (int j = 0; j < numRhs; ++j)
+            if (rhsNorms2[j] > 0)
+                tol_error = std::max(tol_error, RealScalar(sqrt(residualNorms2[j] / rhsNorms2[j])));
+        return;
+    }
+
+    // preconditioners like DiagonalPreconditioner only solve for single vectors
+    BlockType w = projectionMatrix * residual;
+    BlockType z(n, numRhs), tmp(n, numRhs);
+    for (int j = 0; j < numRhs; ++j)
+        z.col(j) = precond.solve(w.col(j));
+
+    BlockType p = z; // initial search directions
+    BlockType absNew = w.transpose() * z;
+    int i = 0;
+    while (i < maxIters)
+    {
+        tmp.noalias() = mat * p; // the bottleneck of the algorithm, one block product for all columns
+
+        const BlockType pAp = p.transpose() * tmp;
+        const BlockType alpha = pAp.colPivHouseholderQr().solve(absNew);
+        x += p * alpha;
+        residual -= tmp * alpha;
+
+        residualNorms2 = residual.colwise().squaredNorm().transpose();
+        if ((residualNorms2.array() <= thresholds.array()).all())
+            break;
+
+        w = projectionMatrix * residual;
+        for (int j = 0; j < numRhs; ++j)
+            z.col(j) = precond.solve(w.col(j));
+
+        const BlockType absOld = absNew;
+        absNew = w.transpose() * z;
+        const BlockType beta = absOld.colPivHouseholderQr().solve(absNew);
+        p = z + p * beta;
 
         i++;
     }
+
+    tol_error = 0;
+    for (int j = 0; j < numRhs; ++j)
+        if (rhsNorms2[j] > 0)
+            tol_error = std::max(tol_error, RealScalar(sqrt(residualNorms2[j] / rhsNorms2[j])));
+    iters = i;
+}
+
+
+/** \internal Low-level pipelined conjugate gradient algorithm (Ghysels and Vanroose)
+  *
+  * Mathematically equivalent to conjugate_projected_gradient with the symmetric preconditioner P M⁻¹ P, but
+  * rearranged such that all dot products of an iteration are reduced together in a single reduction. The
+  * reduction is started before and completed after the operator and preconditioner application, so its
+  * latency is hidden if \a reduction is non-blocking. This costs three additional vectors and one
+  * additional preconditioner application.
+  *
+  * \param mat The matrix A, or any linear operator providing \c cols() and \c operator*
+  * \param rhs The right hand side vector b
+  * \param x On input and initial solution, on output the computed solution.
+  * \param projectionMatrix The projection P, assembled or as a linear operator
+  * \param precond A preconditioner being able to efficiently solve for an
+  *                approximation of Ax=b (regardless of b)
+  * \param reduction Sums the local dot products over all ranks, providing \c start(values, count) and \c wait()
+  * \param iters On input the max number of iteration, on output the number of performed iterations.
+  * \param tol_error On input the tolerance error, on output an estimation of the relative error.
+  * \param observer If given, is notified about every iteration and the time spent in each phase
+  */
+template <typename MatrixType, typename ProjectionType, typename Rhs, typename Dest, typename Preconditioner,
+          typename Reduction>
+EIGEN_DONT_INLINE void pipelined_conjugate_projected_gradient(const MatrixType& mat, const Rhs& rhs, Dest& x,
+                                                              const ProjectionType& projectionMatrix,
+                                                              const Preconditioner& precond, Reduction& reduction,
+                                                              int& iters, typename Dest::RealScalar& tol_error,
+                                                              NuTo::IterationObserver* observer = 0)
+{
+    using std::sqrt;
+    typedef typename Dest::RealScalar RealScalar;
+    typedef typename Dest::Scalar Scalar;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+
+    RealScalar tol = tol_error;
+    int maxIters = iters;
+
+    int n = mat.cols();
+
+    VectorType residual = rhs - mat * x; // initial residual
+
+    Scalar norms[2] = {rhs.squaredNorm(), residual.squaredNorm()};
+    reduction.start(norms, 2);
+    reduction.wait();
+
+    RealScalar rhsNorm2 = numext::real(norms[0]);
+    if (rhsNorm2 == 0)
+    {
+        x.setZero();
+        iters = 0;
+        tol_error = 0;
+        return;
+    }
+    RealScalar threshold = tol * tol * rhsNorm2;
+    RealScalar residualNorm2 = numext::real(norms[1]);
+    if (residualNorm2 < threshold)
+    {
+        iters = 0;
+        tol_error = sqrt(residualNorm2 / rhsNorm2);
+        return;
+    }
+
+    if (observer)
+        observer->StartSolve();
+
+    // preconditioned residual, the phases are reported with the first iteration
+    VectorType u(n), w(n);
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+        w = projectionMatrix * residual;
+    }
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+        u = precond.solve(w);
+    }
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+        u = projectionMatrix * u;
+    }
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+        w = mat * u;
+    }
+
+    VectorType m(n), nn(n);
+    VectorType p = VectorType::Zero(n), s = VectorType::Zero(n), q = VectorType::Zero(n), z = VectorType::Zero(n);
+
+    Scalar gammaOld = 0;
+    Scalar alphaOld = 0;
+    int i = 0;
+    while (i < maxIters)
+    {
+        Scalar dots[3];
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            dots[0] = residual.dot(u);
+            dots[1] = w.dot(u);
+            dots[2] = residual.squaredNorm();
+            reduction.start(dots, 3);
+        }
+
+        // overlaps with the reduction
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+            m = projectionMatrix * w;
+        }
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+            nn = precond.solve(m);
+        }
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+            m = projectionMatrix * nn;
+        }
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+            nn.noalias() = mat * m; // the bottleneck of the algorithm
+        }
+
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            reduction.wait();
+        }
+
+        const Scalar gamma = dots[0];
+        const Scalar delta = dots[1];
+        residualNorm2 = numext::real(dots[2]);
+        if (observer)
+            observer->Iteration(i + 1, sqrt(residualNorm2 / rhsNorm2));
+        if (residualNorm2 < threshold)
+            break;
+
+        Scalar alpha, beta;
+        if (i == 0)
+        {
+            beta = 0;
+            alpha = gamma / delta;
+        }
+        else
+        {
+            beta = gamma / gammaOld;
+            alpha = gamma / (delta - beta * gamma / alphaOld);
+        }
+
+        z = nn + beta * z;
+        q = m + beta * q;
+        s = w + beta * s;
+        p = u + beta * p;
+
+        x += alpha * p; // update solution
+        residual -= alpha * s; // update residue
+        u -= alpha * q;
+        w -= alpha * z;
+
+        gammaOld = gamma;
+        alphaOld = alpha;
+        i++;
+    }
+
+    if (i == maxIters)
+    {
+        Scalar norm = residual.squaredNorm();
+        reduction.start(&norm, 1);
+        reduction.wait();
+        residualNorm2 = numext::real(norm);
+    }
+
+    tol_error = sqrt(residualNorm2 / rhsNorm2);
+    iters = i;
+}
+
+
+/** \internal Mixed precision conjugate gradient with iterative refinement
+  *
+  * The projected CG iterations, i.e. the operator, projection and preconditioner applications, run in the
+  * lower precision of \a matLow, typically float. An outer loop in the precision of \a x computes the true
+  * residual with \a mat and corrects the solution until the requested tolerance is reached, which the inner
+  * solve alone could not reach. The corrections are projected again in working precision, otherwise the
+  * rounding errors of the low precision projection would move the solution out of range(P).
+  *
+  * \param mat The matrix A in working precision, only used for the residual of the refinement
+  * \param matLow The matrix A in low precision, or any linear operator on low precision vectors
+  * \param rhs The right hand side vector b
+  * \param x On input and initial solution, on output the computed solution.
+  * \param projection The projection P in working precision, applied once per refinement step
+  * \param projectionLow The projection P in low precision
+  * \param precondLow A low precision preconditioner
+  * \param iters On input the max number of inner iterations, on output the number of performed inner iterations.
+  * \param tol_error On input the tolerance error, on output an estimation of the relative error.
+  * \param innerTolerance Relative tolerance of each inner solve, above the accuracy of the low precision
+  * \param observer If given, follows the inner solves, each refinement step is reported as a solve of its own
+  */
+template <typename MatrixType, typename LowMatrixType, typename ProjectionType, typename LowProjectionType,
+          typename Rhs, typename Dest, typename LowPreconditioner>
+EIGEN_DONT_INLINE void mixed_precision_conjugate_projected_gradient(
+        const MatrixType& mat, const LowMatrixType& matLow, const Rhs& rhs, Dest& x, const ProjectionType& projection,
+        const LowProjectionType& projectionLow, const LowPreconditioner& precondLow, int& iters,
+        typename Dest::RealScalar& tol_error, typename Dest::RealScalar innerTolerance = 1.e-4,
+        NuTo::IterationObserver* observer = 0)
+{
+    using std::sqrt;
+    typedef typename Dest::RealScalar RealScalar;
+    typedef typename LowMatrixType::Scalar LowScalar;
+    typedef Matrix<typename Dest::Scalar, Dynamic, 1> VectorType;
+    typedef Matrix<LowScalar, Dynamic, 1> LowVectorType;
+
+    RealScalar tol = tol_error;
+    int maxIters = iters;
+
+    RealScalar rhsNorm2 = rhs.squaredNorm();
+    if (rhsNorm2 == 0)
+    {
+        x.setZero();
+        iters = 0;
+        tol_error = 0;
+        return;
+    }
+    RealScalar threshold = tol * tol * rhsNorm2;
+
+    VectorType residual = rhs - mat * x; // residual in working precision
+    RealScalar residualNorm2 = residual.squaredNorm();
+
+    int i = 0;
+    while (residualNorm2 >= threshold and i < maxIters)
+    {
+        // scale to unit norm, the correction must not under- or overflow in low precision
+        const RealScalar residualNorm = sqrt(residualNorm2);
+        const LowVectorType residualLow = (residual / residualNorm).template cast<LowScalar>();
+
+        LowVectorType correction = LowVectorType::Zero(residualLow.rows());
+        int innerIters = maxIters - i;
+        typename NumTraits<LowScalar>::Real innerError = innerTolerance;
+        conjugate_projected_gradient(matLow, residualLow, correction, projectionLow, precondLow, innerIters,
+                                     innerError, 0, 0, observer);
+        if (innerIters == 0)
+            break; // no progress possible in low precision
+
+        x += residualNorm * (projection * correction.template cast<typename Dest::Scalar>());
+        i += innerIters;
+
+        residual = rhs - mat * x;
+        residualNorm2 = residual.squaredNorm();
+    }
+
     tol_error = sqrt(residualNorm2 / rhsNorm2);
     iters = i;
 }
 }
 
 
+/** \brief Linear operator that is only known through its action on a vector
+  *
+  * Wraps a functor \c y = \c f(x) so that it can be passed to the projected Krylov solvers in place of an
+  * assembled matrix. This allows e.g. the FETI interface operator F = B K⁺ Bᵀ to be applied through subdomain
+  * solves without ever forming F.
+  *
+  * \tparam _Functor callable with signature \c VectorType(const VectorType&)
+  * \tparam _Scalar scalar type of the vectors the operator acts on
+  */
+template <typename _Functor, typename _Scalar = double>
+class MatrixFreeOperator
+{
+public:
+    typedef _Scalar Scalar;
+    typedef typename NumTraits<Scalar>::Real RealScalar;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+    typedef typename VectorType::Index Index;
+
+    MatrixFreeOperator(const _Functor& functor, Index size)
+        : m_functor(functor)
+        , m_size(size)
+    {
+    }
+
+    Index rows() const
+    {
+        return m_size;
+    }
+
+    Index cols() const
+    {
+        return m_size;
+    }
+
+    /** Applies the functor to \a x, column by column if \a x is a block of vectors */
+    template <typename Derived>
+    Matrix<Scalar, Dynamic, Derived::ColsAtCompileTime> operator*(const MatrixBase<Derived>& x) const
+    {
+        Matrix<Scalar, Dynamic, Derived::ColsAtCompileTime> result(m_size, x.cols());
+        for (Index j = 0; j < x.cols(); ++j)
+            result.col(j) = m_functor(VectorType(x.col(j)));
+        return result;
+    }
+
+protected:
+    _Functor m_functor;
+    Index m_size;
+};
+
+
+/** Creates a MatrixFreeOperator of dimension \a size from \a functor */
+template <typename Functor>
+MatrixFreeOperator<Functor> makeMatrixFreeOperator(const Functor& functor, VectorXd::Index size)
+{
+    return MatrixFreeOperator<Functor>(functor, size);
+}
+
+
+/** \brief Implicit projection P = I - G (GᵀG)⁻¹ Gᵀ onto the complement of the natural coarse space
+  *
+  * The assembled projection is dense with the size of the interface. This class only stores G and the
+  * factorization of the small matrix GᵀG, whose size is the number of rigid body modes. The factorization is
+  * computed once per operator in compute() and reused for every application.
+  *
+  * \tparam _GMatrixType dense or sparse type of the matrix G, one column per rigid body mode
+  */
+template <typename _GMatrixType>
+class NaturalCoarseSpaceProjector
+{
+public:
+    typedef _GMatrixType GMatrixType;
+    typedef typename GMatrixType::Scalar Scalar;
+    typedef typename GMatrixType::Index Index;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+    typedef Matrix<Scalar, Dynamic, Dynamic> DenseMatrixType;
+
+    NaturalCoarseSpaceProjector()
+    {
+    }
+
+    explicit NaturalCoarseSpaceProjector(const GMatrixType& G)
+    {
+        compute(G);
+    }
+
+    /** Stores \a G and factorizes GᵀG. Call again whenever G changes. */
+    NaturalCoarseSpaceProjector& compute(const GMatrixType& G)
+    {
+        m_G = G;
+        const DenseMatrixType GtG = DenseMatrixType(m_G.transpose() * m_G);
+        m_GtGFactorization.compute(GtG);
+        return *this;
+    }
+
+    Index rows() const
+    {
+        return m_G.rows();
+    }
+
+    Index cols() const
+    {
+        return m_G.rows();
+    }
+
+    /** Number of rigid body modes */
+    Index coarseSize() const
+    {
+        return m_G.cols();
+    }
+
+    /** Returns the coarse correction (GᵀG)⁻¹ Gᵀ \a v, one coefficient per rigid body mode */
+    template <typename Derived>
+    Matrix<Scalar, Dynamic, Derived::ColsAtCompileTime> coarseSolve(const MatrixBase<Derived>& v) const
+    {
+        const Matrix<Scalar, Dynamic, Derived::ColsAtCompileTime> Gtv = m_G.transpose() * v;
+        return m_GtGFactorization.solve(Gtv);
+    }
+
+    /** Returns G (GᵀG)⁻¹ \a e, the initial guess that satisfies the coarse constraint Gᵀλ = \a e */
+    template <typename Derived>
+    VectorType particularSolution(const MatrixBase<Derived>& e) const
+    {
+        const VectorType coefficients = m_GtGFactorization.solve(e);
+        return m_G * coefficients;
+    }
+
+    /** Applies P to a vector or block of vectors */
+    template <typename Derived>
+    Matrix<Scalar, Dynamic, Derived::ColsAtCompileTime> operator*(const MatrixBase<Derived>& v) const
+    {
+        const Matrix<Scalar, Dynamic, Derived::ColsAtCompileTime> coefficients = coarseSolve(v);
+        Matrix<Scalar, Dynamic, Derived::ColsAtCompileTime> result = v;
+        result -= m_G * coefficients;
+        return result;
+    }
+
+protected:
+    GMatrixType m_G;
+    LDLT<DenseMatrixType> m_GtGFactorization;
+};
+
+
 template <typename _MatrixType, int _UpLo = Lower,
           typename _Preconditioner = DiagonalPreconditioner<typename _MatrixType::Scalar>>
 class ConjugateProjectedGradient;
@@ -151,6 +830,9 @@ public:
     /** Default constructor. */
     ConjugateProjectedGradient()
         : Base()
+        , m_reorthogonalizationWindow(0)
+        , m_recycledDirections(0, 0)
+        , m_observer(0)
     {
     }
 
@@ -166,6 +848,9 @@ public:
       */
     ConjugateProjectedGradient(const MatrixType& A)
         : Base(A)
+        , m_reorthogonalizationWindow(0)
+        , m_recycledDirections(0, 0)
+        , m_observer(0)
     {
     }
 
@@ -173,6 +858,49 @@ public:
     {
     }
 
+    /** Keeps the last \a window search directions and makes each new direction A-conjugate to all of them.
+      *
+      * Costs \a window vector pairs of memory but no extra operator applications. Restores conjugacy on
+      * badly conditioned interface problems, e.g. with damaged subdomains. 0 (default) disables it.
+      */
+    ConjugateProjectedGradient& setReorthogonalizationWindow(int window)
+    {
+        m_reorthogonalizationWindow = window;
+        return *this;
+    }
+
+    int reorthogonalizationWindow() const
+    {
+        return m_reorthogonalizationWindow;
+    }
+
+    /** Keeps the last \a capacity search directions of each solve and uses them to warm start the next one.
+      *
+      * Meant for sequences of slightly changing operators, e.g. the interface problems of consecutive Newton
+      * iterations and load steps. The stored directions survive compute(). 0 (default) disables it.
+      */
+    ConjugateProjectedGradient& setRecyclingCapacity(int capacity)
+    {
+        m_recycledDirections = SearchDirectionWindow<Scalar>(0, capacity);
+        return *this;
+    }
+
+    /** Reports every iteration and the time spent in operator, preconditioner, projection and reductions to
+      * \a observer, e.g. a NuTo::IterationLog. The solver does not take ownership. nullptr disables it. With an
+      * observer several right hand sides are solved one after the other instead of by block CG.
+      */
+    ConjugateProjectedGradient& setIterationObserver(NuTo::IterationObserver* observer)
+    {
+        m_observer = observer;
+        return *this;
+    }
+
+    /** Discards the recycled directions, e.g. after the dof numbering changed */
+    void clearRecycledDirections()
+    {
+        m_recycledDirections.clear();
+    }
+
 
     /** \internal */
     template <typename Rhs, typename Dest>
@@ -181,6 +909,16 @@ public:
         m_iterations = Base::maxIterations();
         m_error = Base::m_tolerance;
 
+        if (useBlockSolve(b))
+        {
+            internal::block_conjugate_projected_gradient(mp_matrix->template selfadjointView<UpLo>(), b, x,
+                                                         projectionMatrix.template selfadjointView<UpLo>(),
+                                                         Base::m_preconditioner, m_iterations, m_error);
+            m_isInitialized = true;
+            m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+            return;
+        }
+
         for (int j = 0; j < b.cols(); ++j)
         {
             m_iterations = Base::maxIterations();
@@ -189,7 +927,108 @@ public:
             typename Dest::ColXpr xj(x, j);
             internal::conjugate_projected_gradient(mp_matrix->template selfadjointView<UpLo>(), b.col(j), xj,
                                                    projectionMatrix.template selfadjointView<UpLo>(),
-                                                   Base::m_preconditioner, m_iterations, m_error);
+                                                   Base::m_preconditioner, m_iterations, m_error,
+                                                   m_reorthogonalizationWindow, recycledDirections(), m_observer);
+        }
+
+        m_isInitialized = true;
+        m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+    }
+
+    /** \internal Solves with the implicit natural coarse space projection instead of an assembled one */
+    template <typename Rhs, typename Dest, typename GMatrixType>
+    void _solveWithGuess(const Rhs& b, Dest& x, const NaturalCoarseSpaceProjector<GMatrixType>& projector) const
+    {
+        solveWithOperator(mp_matrix->template selfadjointView<UpLo>(), b, x, projector);
+    }
+
+    /** Solves \c Ax=b with an operator \a op that does not have to be assembled
+      *
+      * \a op and \a projection can be assembled matrices or any linear operator providing \c cols() and
+      * \c operator*, e.g. a MatrixFreeOperator. Since no matrix is attached to the solver, the preconditioner
+      * has to work without one, e.g. \c IdentityPreconditioner.
+      */
+    template <typename OperatorType, typename ProjectionType, typename Rhs, typename Dest>
+    void solveWithOperator(const OperatorType& op, const Rhs& b, Dest& x, const ProjectionType& projection) const
+    {
+        const int maxIterations = Base::m_maxIterations < 0 ? 2 * op.cols() : Base::m_maxIterations;
+
+        if (useBlockSolve(b))
+        {
+            m_iterations = maxIterations;
+            m_error = Base::m_tolerance;
+            internal::block_conjugate_projected_gradient(op, b, x, projection, Base::m_preconditioner, m_iterations,
+                                                         m_error);
+            m_isInitialized = true;
+            m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+            return;
+        }
+
+        for (int j = 0; j < b.cols(); ++j)
+        {
+            m_iterations = maxIterations;
+            m_error = Base::m_tolerance;
+
+            typename Dest::ColXpr xj(x, j);
+            internal::conjugate_projected_gradient(op, b.col(j), xj, projection, Base::m_preconditioner,
+                                                   m_iterations, m_error, m_reorthogonalizationWindow,
+                                                   recycledDirections(), m_observer);
+        }
+
+        m_isInitialized = true;
+        m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+    }
+
+    /** Solves \c Ax=b with the pipelined variant that needs a single reduction per iteration
+      *
+      * Worthwhile when the dot products of a distributed run are latency bound. \a reduction sums the local dot
+      * products over all ranks, e.g. MpiNonBlockingSum, and is overlapped with the application of \a op.
+      * \a op and \a projection follow the rules of solveWithOperator.
+      */
+    template <typename OperatorType, typename ProjectionType, typename Reduction, typename Rhs, typename Dest>
+    void solvePipelined(const OperatorType& op, const Rhs& b, Dest& x, const ProjectionType& projection,
+                        Reduction& reduction) const
+    {
+        const int maxIterations = Base::m_maxIterations < 0 ? 2 * op.cols() : Base::m_maxIterations;
+
+        for (int j = 0; j < b.cols(); ++j)
+        {
+            m_iterations = maxIterations;
+            m_error = Base::m_tolerance;
+
+            typename Dest::ColXpr xj(x, j);
+            internal::pipelined_conjugate_projected_gradient(op, b.col(j), xj, projection, Base::m_preconditioner,
+                                                             reduction, m_iterations, m_error, m_observer);
+        }
+
+        m_isInitialized = true;
+        m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+    }
+
+    /** Solves \c Ax=b with the CG iterations in low precision and iterative refinement in working precision
+      *
+      * \a op is only applied once per refinement step, \a opLow, \a projectionLow and \a precondLow once per
+      * iteration. They act on e.g. float vectors, which halves the memory traffic of the bandwidth bound
+      * interface solve. The refinement still reaches the tolerance of the solver and projects the corrections
+      * with \a projection in working precision.
+      */
+    template <typename OperatorType, typename LowOperatorType, typename ProjectionType, typename LowProjectionType,
+              typename LowPreconditioner, typename Rhs, typename Dest>
+    void solveMixedPrecision(const OperatorType& op, const LowOperatorType& opLow, const Rhs& b, Dest& x,
+                             const ProjectionType& projection, const LowProjectionType& projectionLow,
+                             const LowPreconditioner& precondLow) const
+    {
+        const int maxIterations = Base::m_maxIterations < 0 ? 2 * op.cols() : Base::m_maxIterations;
+
+        for (int j = 0; j < b.cols(); ++j)
+        {
+            m_iterations = maxIterations;
+            m_error = Base::m_tolerance;
+
+            typename Dest::ColXpr xj(x, j);
+            internal::mixed_precision_conjugate_projected_gradient(op, opLow, b.col(j), xj, projection,
+                                                                   projectionLow, precondLow, m_iterations,
+                                                                   m_error, 1.e-4, m_observer);
         }
 
         m_isInitialized = true;
@@ -197,6 +1036,22 @@ public:
     }
 
 protected:
+    /** Multiple right hand sides are solved together by block CG. Reorthogonalization and recycling work on
+      * single search directions and block CG reports no iterations, so they fall back to one solve per column. */
+    template <typename Rhs>
+    bool useBlockSolve(const Rhs& b) const
+    {
+        return b.cols() > 1 and m_reorthogonalizationWindow == 0 and recycledDirections() == 0 and m_observer == 0;
+    }
+
+    SearchDirectionWindow<Scalar>* recycledDirections() const
+    {
+        return m_recycledDirections.capacity() > 0 ? &m_recycledDirections : 0;
+    }
+
+    int m_reorthogonalizationWindow;
+    mutable SearchDirectionWindow<Scalar> m_recycledDirections;
+    NuTo::IterationObserver* m_observer;
 };
 
 
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include <eigen3/Eigen/Core>
+#include "ColoredAssembly.h"
+
+
+//! @brief One element matrix per class of congruent elements
+//!
+//! Structured meshes, e.g. of MeshGenerator::Grid or CreateRectangularMesh2D, consist of translated copies of a
+//! few element shapes. Two elements are congruent if they have the same type (interpolation), the same material
+//! (physical group, i.e. section and constitutive law) and the same node coordinates relative to their first
+//! node, i.e. the same Jacobian at every integration point. The relative coordinates are compared after rounding
+//! to relativeTolerance times the size of the mesh. For linear material every element of a class has the same
+//! matrix, it is computed once for a representative element and assembly becomes a pure scatter, see
+//! ColoredAssembler::AssembleMatrix. Rotated or mirrored copies are different classes, the node order is part of
+//! the shape.
+class ElementMatrixCache
+{
+public:
+    ElementMatrixCache(const ImportContainer& rMesh, int numDofsPerNode, double relativeTolerance = 1.e-9)
+        : mNumDofsPerNode(numDofsPerNode)
+    {
+        const ElementBlock& elements = rMesh.mElementList;
+        const std::vector<int> nodeIndices = NodeIndices(rMesh).GlobalToLocal(elements.mNodeIds);
+
+        Eigen::Vector3d min = Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+        Eigen::Vector3d max = -min;
+        for (const auto& node : rMesh.mNodeList)
+        {
+            min = min.cwiseMin(node.mCoordinates);
+            max = max.cwiseMax(node.mCoordinates);
+        }
+        const double resolution = relativeTolerance * std::max((max - min).maxCoeff(), 1.e-300);
+
+        std::unordered_map<ShapeKey, int, ShapeKeyHash> classes;
+        mClasses.reserve(elements.size());
+        ShapeKey key;
+        for (size_t element = 0; element < elements.size(); ++element)
+        {
+            key.mType = elements.mTypes[element];
+            key.mMaterial = elements.mPhysicalGroups[element];
+            key.mCoordinates.clear();
+            const Eigen::Vector3d& origin = rMesh.mNodeList[nodeIndices[elements.mOffsets[element]]].mCoordinates;
+            for (int i = elements.mOffsets[element] + 1; i < elements.mOffsets[element + 1]; ++i)
+            {
+                const Eigen::Vector3d relative = rMesh.mNodeList[nodeIndices[i]].mCoordinates - origin;
+                for (int direction = 0; direction < 3; ++direction)
+                    key.mCoordinates.push_back(std::llround(relative[direction] / resolution));
+            }
+
+            const auto inserted = classes.emplace(key, mRepresentatives.size());
+            if (inserted.second)
+                mRepresentatives.push_back(element);
+            mClasses.push_back(inserted.first->second);
+        }
+    }
+
+    //! @brief Computes the matrices of all classes with \a kernel(element, thread, elementMatrix, elementVector)
+    //!
+    //! Same kernel as for ColoredAssembler::Assemble, it is called once per class for its representative, the
+    //! element vector is discarded.
+    template <typename ElementKernel>
+    void Compute(ElementKernel kernel, const ImportContainer& rMesh, ThreadPool& rPool)
+    {
+        const ElementBlock& elements = rMesh.mElementList;
+        mMatrices.resize(mRepresentatives.size());
+        std::vector<Eigen::VectorXd> vectors(rPool.size());
+        rPool.ParallelFor(mRepresentatives.size(),
+                          [&](int elementClass, int thread) {
+                              const int element = mRepresentatives[elementClass];
+                              const int numElementDofs =
+                                      mNumDofsPerNode * (elements.mOffsets[element + 1] - elements.mOffsets[element]);
+                              mMatrices[elementClass].setZero(numElementDofs, numElementDofs);
+                              vectors[thread].setZero(numElementDofs);
+                              kernel(element, thread, mMatrices[elementClass], vectors[thread]);
+                          },
+                          1);
+    }
+
+    //! @brief Matrix of the class of \a element, valid after Compute
+    const Eigen::MatrixXd& operator()(int element) const
+    {
+        return mMatrices[mClasses[element]];
+    }
+
+    int NumClasses() const
+    {
+        return mRepresentatives.size();
+    }
+
+    int GetClass(int element) const
+    {
+        return mClasses[element];
+    }
+
+    //! @brief The element whose matrix stands for all elements of \a elementClass
+    int GetRepresentative(int elementClass) const
+    {
+        return mRepresentatives[elementClass];
+    }
+
+private:
+    struct ShapeKey
+    {
+        eElementType mType;
+        int mMaterial;
+        std::vector<long long> mCoordinates; //!< rounded coordinates of the nodes relative to the first one
+
+        bool operator==(const ShapeKey& rOther) const
+        {
+            return mType == rOther.mType and mMaterial == rOther.mMaterial and mCoordinates == rOther.mCoordinates;
+        }
+    };
+
+    struct ShapeKeyHash
+    {
+        size_t operator()(const ShapeKey& rKey) const
+        {
+            size_t hash = std::hash<int>()(static_cast<int>(rKey.mType)) ^ (std::hash<int>()(rKey.mMaterial) << 1);
+            for (const long long coordinate : rKey.mCoordinates)
+                hash ^= std::hash<long long>()(coordinate) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+
+    int mNumDofsPerNode;
+    std::vector<int> mClasses; //!< class of every element
+    std::vector<int> mRepresentatives; //!< first element of every class
+    std::vector<Eigen::MatrixXd> mMatrices; //!< of every class
+};
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <fstream>
 #include <exception>
@@ -5,6 +7,17 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <eigen3/Eigen/Core>
 using namespace std::string_literals;
 
 
@@ -14,29 +27,299 @@ struct Node
     int mId;
 };
 
-struct Element
+enum class eElementType
 {
-    int mId;
+    Unknown,
+    Triangle3,
+    Triangle6,
+    Quad4,
+    Quad8,
+    Quad9,
+    Tetrahedron4,
+    Tetrahedron10,
+    Prism6,
+    Hexahedron8,
+    Hexahedron20,
+    Hexahedron27
+};
+
+//! @brief Element type from the number of nodes of an element in a mesh of the given dimension
+eElementType ElementTypeFromNumNodes(int numNodes, int dimension)
+{
+    if (dimension == 2)
+        switch (numNodes)
+        {
+        case 3:
+            return eElementType::Triangle3;
+        case 4:
+            return eElementType::Quad4;
+        case 6:
+            return eElementType::Triangle6;
+        case 8:
+            return eElementType::Quad8;
+        case 9:
+            return eElementType::Quad9;
+        }
+    else
+        switch (numNodes)
+        {
+        case 4:
+            return eElementType::Tetrahedron4;
+        case 6:
+            return eElementType::Prism6;
+        case 8:
+            return eElementType::Hexahedron8;
+        case 10:
+            return eElementType::Tetrahedron10;
+        case 20:
+            return eElementType::Hexahedron20;
+        case 27:
+            return eElementType::Hexahedron27;
+        }
+    return eElementType::Unknown;
+}
+
+//! @brief Gmsh element type numbers of the supported element types
+const std::vector<std::pair<int, eElementType>>& GmshElementTypes()
+{
+    static const std::vector<std::pair<int, eElementType>> types = {
+            {2, eElementType::Triangle3},     {3, eElementType::Quad4},          {4, eElementType::Tetrahedron4},
+            {5, eElementType::Hexahedron8},   {6, eElementType::Prism6},         {9, eElementType::Triangle6},
+            {10, eElementType::Quad9},        {11, eElementType::Tetrahedron10}, {12, eElementType::Hexahedron27},
+            {16, eElementType::Quad8},        {17, eElementType::Hexahedron20}};
+    return types;
+}
+
+//! @brief Element type of a gmsh element type number, Unknown for points, lines and unsupported types
+eElementType ElementTypeFromGmsh(int gmshType)
+{
+    for (const auto& type : GmshElementTypes())
+        if (type.first == gmshType)
+            return type.second;
+    return eElementType::Unknown;
+}
+
+//! @brief Gmsh element type number of \a type, 0 for Unknown
+int GmshElementType(eElementType type)
+{
+    for (const auto& gmshType : GmshElementTypes())
+        if (gmshType.second == type)
+            return gmshType.first;
+    return 0;
+}
+
+//! @brief Spatial dimension of an element type, 0 for Unknown
+int ElementDimension(eElementType type)
+{
+    switch (type)
+    {
+    case eElementType::Unknown:
+        return 0;
+    case eElementType::Triangle3:
+    case eElementType::Triangle6:
+    case eElementType::Quad4:
+    case eElementType::Quad8:
+    case eElementType::Quad9:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+//! @brief Node ids of one element, points into the connectivity of an ElementBlock
+struct ElementNodes
+{
+    const int* begin() const
+    {
+        return mBegin;
+    }
+
+    const int* end() const
+    {
+        return mEnd;
+    }
+
+    int size() const
+    {
+        return mEnd - mBegin;
+    }
+
+    int operator[](int i) const
+    {
+        return mBegin[i];
+    }
+
+    const int* mBegin;
+    const int* mEnd;
+};
+
+//! @brief Elements of arbitrary types with the connectivity in compressed row storage
+//!
+//! The node ids of element i are mNodeIds[mOffsets[i]] .. mNodeIds[mOffsets[i + 1] - 1], all elements share
+//! one contiguous array.
+struct ElementBlock
+{
+    std::vector<int> mIds;
+    std::vector<eElementType> mTypes;
+    std::vector<int> mPhysicalGroups; //!< physical group of each element, 0 if the file has none
+    std::vector<int> mOffsets = std::vector<int>(1, 0);
     std::vector<int> mNodeIds;
+
+    size_t size() const
+    {
+        return mIds.size();
+    }
+
+    bool empty() const
+    {
+        return mIds.empty();
+    }
+
+    ElementNodes NodeIds(size_t i) const
+    {
+        return {mNodeIds.data() + mOffsets[i], mNodeIds.data() + mOffsets[i + 1]};
+    }
+};
+
+//! @brief Map from global to local node ids stored as a sorted vector of pairs
+//!
+//! Built once in bulk, afterwards lookups are binary searches in contiguous memory. Iterates like a
+//! std::map<int, int>, duplicate global ids keep the first entry like std::map::emplace.
+class FlatIdMap
+{
+public:
+    using value_type = std::pair<int, int>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    FlatIdMap() = default;
+
+    explicit FlatIdMap(std::vector<value_type> pairs)
+    {
+        Assign(std::move(pairs));
+    }
+
+    //! @brief Replaces the content by \a pairs of (global, local) ids in any order
+    void Assign(std::vector<value_type> pairs)
+    {
+        std::stable_sort(pairs.begin(), pairs.end(), CompareGlobal);
+        pairs.erase(std::unique(pairs.begin(), pairs.end(),
+                                [](const value_type& a, const value_type& b) { return a.first == b.first; }),
+                    pairs.end());
+        mPairs = std::move(pairs);
+    }
+
+    const_iterator begin() const
+    {
+        return mPairs.begin();
+    }
+
+    const_iterator end() const
+    {
+        return mPairs.end();
+    }
+
+    size_t size() const
+    {
+        return mPairs.size();
+    }
+
+    bool empty() const
+    {
+        return mPairs.empty();
+    }
+
+    const value_type* data() const
+    {
+        return mPairs.data();
+    }
+
+    const_iterator find(int globalId) const
+    {
+        const auto it = std::lower_bound(mPairs.begin(), mPairs.end(), value_type(globalId, 0), CompareGlobal);
+        return it != mPairs.end() and it->first == globalId ? it : mPairs.end();
+    }
+
+    size_t count(int globalId) const
+    {
+        return find(globalId) != end() ? 1 : 0;
+    }
+
+    int at(int globalId) const
+    {
+        const auto it = find(globalId);
+        if (it == end())
+            throw std::out_of_range("Global node id "s + std::to_string(globalId) + " not in the map");
+        return it->second;
+    }
+
+    //! @brief Translates the global ids [globalBegin, globalEnd) to local ids, throws if one is missing
+    //!
+    //! Ascending input, e.g. the sorted node ids of a boundary, is translated in a single merge-like pass,
+    //! otherwise every id costs a binary search.
+    void GlobalToLocal(const int* globalBegin, const int* globalEnd, int* localIds) const
+    {
+        if (std::is_sorted(globalBegin, globalEnd))
+        {
+            auto it = mPairs.begin();
+            for (const int* globalId = globalBegin; globalId != globalEnd; ++globalId, ++localIds)
+            {
+                while (it != mPairs.end() and it->first < *globalId)
+                    ++it;
+                if (it == mPairs.end() or it->first != *globalId)
+                    throw std::out_of_range("Global node id "s + std::to_string(*globalId) + " not in the map");
+                *localIds = it->second;
+            }
+        }
+        else
+        {
+            for (const int* globalId = globalBegin; globalId != globalEnd; ++globalId, ++localIds)
+                *localIds = at(*globalId);
+        }
+    }
+
+    std::vector<int> GlobalToLocal(const std::vector<int>& rGlobalIds) const
+    {
+        std::vector<int> localIds(rGlobalIds.size());
+        GlobalToLocal(rGlobalIds.data(), rGlobalIds.data() + rGlobalIds.size(), localIds.data());
+        return localIds;
+    }
+
+    bool operator==(const FlatIdMap& rOther) const
+    {
+        return mPairs == rOther.mPairs;
+    }
+
+private:
+    static bool CompareGlobal(const value_type& a, const value_type& b)
+    {
+        return a.first < b.first;
+    }
+
+    std::vector<value_type> mPairs;
 };
 
 struct Boundary
 {
-    std::map<int, int> mNodeIdsMap;
+    FlatIdMap mNodeIdsMap;
     std::vector<int> mValues;
 };
 
 struct Interface
 {
-    std::map<int, int> mNodeIdsMap;
+    FlatIdMap mNodeIdsMap;
     int mValue;
+
+    //! FETI data of JSON subdomain meshes: first global multiplier id and the two neighbouring subdomains
+    int mGlobalStartId = 0;
+    int mMaster = 0;
+    int mSlave = 0;
 };
 
 
 struct ImportContainer
 {
     using NodeList = std::vector<Node>;
-    using ElementList = std::vector<Element>;
+    using ElementList = ElementBlock;
     using BoundaryList = std::vector<Boundary>;
     using InterfaceList = std::vector<Interface>;
 
@@ -44,133 +327,473 @@ struct ImportContainer
     ElementList mElementList;
     BoundaryList mBoundaryList;
     InterfaceList mInterfaceList;
+
+    //! only filled for JSON subdomain meshes
+    std::vector<int> mLocalToGlobalMap;
+    std::vector<int> mNumInterfaceNodes;
 };
 
 
-std::vector<Node> ReadNodeData(std::ifstream& file)
+//! @brief Read-only memory map of a whole file
+class MappedFile
 {
-    std::string line = "initialization";
-    while (std::getline(file, line) and line.compare("Nodes") != 0)
-        ;
+public:
+    explicit MappedFile(const std::string& rFileName)
+    {
+        mFileDescriptor = open(rFileName.c_str(), O_RDONLY);
+        if (mFileDescriptor < 0)
+            throw std::runtime_error("Mesh file "s + rFileName + " did not open. Check path.");
 
-    if (line.compare("Nodes") != 0)
-        throw std::exception();
+        struct stat fileStatus;
+        if (fstat(mFileDescriptor, &fileStatus) != 0)
+        {
+            close(mFileDescriptor);
+            throw std::runtime_error("Could not determine the size of "s + rFileName);
+        }
+        mSize = fileStatus.st_size;
+        if (mSize == 0)
+            return;
 
-    int num_nodes = 0;
-    file >> num_nodes;
+        void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFileDescriptor, 0);
+        if (data == MAP_FAILED)
+        {
+            close(mFileDescriptor);
+            throw std::runtime_error("Could not map "s + rFileName);
+        }
+        madvise(data, mSize, MADV_SEQUENTIAL);
+        mData = static_cast<const char*>(data);
+    }
 
-    std::vector<Node> nodes(num_nodes);
-    for (auto& node : nodes)
-        file >> node.mId >> node.mCoordinates[0] >> node.mCoordinates[1] >> node.mCoordinates[2];
+    ~MappedFile()
+    {
+        if (mData != nullptr)
+            munmap(const_cast<char*>(mData), mSize);
+        close(mFileDescriptor);
+    }
 
-    return nodes;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const
+    {
+        return mData;
+    }
+
+    const char* end() const
+    {
+        return mData + mSize;
+    }
+
+private:
+    int mFileDescriptor = -1;
+    const char* mData = nullptr;
+    size_t mSize = 0;
+};
+
+
+//! @brief Locale independent tokenizer for whitespace separated numbers in [begin, end)
+//!
+//! Works directly on the mapped file and never allocates.
+class MeshTokenizer
+{
+public:
+    MeshTokenizer(const char* rBegin, const char* rEnd)
+        : mPosition(rBegin)
+        , mEnd(rEnd)
+    {
+    }
+
+    const char* Position() const
+    {
+        return mPosition;
+    }
+
+    bool AtEnd()
+    {
+        SkipWhitespace();
+        return mPosition == mEnd;
+    }
+
+    void SkipWhitespace()
+    {
+        while (mPosition != mEnd and IsWhitespace(*mPosition))
+            ++mPosition;
+    }
+
+    //! @brief Moves to the beginning of the next line
+    void SkipLine()
+    {
+        mPosition = std::find(mPosition, mEnd, '\n');
+        if (mPosition != mEnd)
+            ++mPosition;
+    }
+
+    int ReadInt()
+    {
+        SkipWhitespace();
+        const bool negative = ReadSign();
+        if (mPosition == mEnd or not IsDigit(*mPosition))
+            throw std::runtime_error("Expected an integer in the mesh file");
+
+        int value = 0;
+        while (mPosition != mEnd and IsDigit(*mPosition))
+            value = 10 * value + (*mPosition++ - '0');
+        return negative ? -value : value;
+    }
+
+    //! @brief Parses a decimal floating point number
+    //!
+    //! Numbers with up to 15 significant digits and moderate exponents are converted exactly, longer ones are
+    //! evaluated in extended precision.
+    double ReadDouble()
+    {
+        SkipWhitespace();
+        const bool negative = ReadSign();
+
+        std::uint64_t mantissa = 0;
+        int numDigits = 0;
+        int exponent = 0;
+        bool anyDigit = false;
+
+        for (; mPosition != mEnd and IsDigit(*mPosition); ++mPosition, anyDigit = true)
+            AppendDigit(mantissa, numDigits, exponent, *mPosition, false);
+
+        if (mPosition != mEnd and *mPosition == '.')
+            for (++mPosition; mPosition != mEnd and IsDigit(*mPosition); ++mPosition, anyDigit = true)
+                AppendDigit(mantissa, numDigits, exponent, *mPosition, true);
+
+        if (not anyDigit)
+            throw std::runtime_error("Expected a number in the mesh file");
+
+        if (mPosition != mEnd and (*mPosition == 'e' or *mPosition == 'E'))
+        {
+            ++mPosition;
+            exponent += ReadInt();
+        }
+
+        double value;
+        constexpr std::uint64_t maxExactMantissa = std::uint64_t(1) << 53;
+        if (mantissa <= maxExactMantissa and exponent >= -22 and exponent <= 22)
+            value = exponent < 0 ? mantissa / PowerOfTen(-exponent) : mantissa * PowerOfTen(exponent);
+        else
+            value = static_cast<double>(mantissa * std::pow(10.L, exponent));
+
+        return negative ? -value : value;
+    }
+
+private:
+    static bool IsWhitespace(char c)
+    {
+        return c == ' ' or c == '\n' or c == '\r' or c == '\t';
+    }
+
+    static bool IsDigit(char c)
+    {
+        return c >= '0' and c <= '9';
+    }
+
+    bool ReadSign()
+    {
+        if (mPosition != mEnd and (*mPosition == '-' or *mPosition == '+'))
+            return *mPosition++ == '-';
+        return false;
+    }
+
+    //! @brief Accumulates at most 19 significant digits, the remaining ones only shift the exponent
+    static void AppendDigit(std::uint64_t& rMantissa, int& rNumDigits, int& rExponent, char digit, bool fraction)
+    {
+        if (rNumDigits < 19)
+        {
+            rMantissa = 10 * rMantissa + (digit - '0');
+            if (rMantissa != 0)
+                ++rNumDigits;
+            if (fraction)
+                --rExponent;
+        }
+        else if (not fraction)
+            ++rExponent;
+    }
+
+    static double PowerOfTen(int exponent)
+    {
+        static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        return powers[exponent];
+    }
+
+    const char* mPosition;
+    const char* mEnd;
+};
+
+
+//! @brief Returns the beginning of the first line in [begin, end) that reads \a rKeyword
+const char* FindSection(const char* begin, const char* end, const std::string& rKeyword)
+{
+    for (const char* line = begin; line < end;)
+    {
+        const char* lineEnd = std::find(line, end, '\n');
+        const char* trimmedEnd = lineEnd;
+        while (trimmedEnd != line and (trimmedEnd[-1] == '\r' or trimmedEnd[-1] == ' ' or trimmedEnd[-1] == '\t'))
+            --trimmedEnd;
+        if (static_cast<size_t>(trimmedEnd - line) == rKeyword.size() and
+            std::equal(rKeyword.begin(), rKeyword.end(), line))
+            return line;
+        line = lineEnd == end ? end : lineEnd + 1;
+    }
+    throw std::runtime_error("Section "s + rKeyword + " not found in the mesh file");
 }
 
-std::vector<Element> ReadElementData(std::ifstream& file)
+
+//! @brief Line aligned chunks of a block of records, one record per non-blank line
+//!
+//! Blocks are read in two parallel passes, one thread per chunk: the first counts the records (and their
+//! entries) per chunk, the second parses them directly into their final position.
+class LineChunks
 {
-    std::string line = "initialization";
-    while (std::getline(file, line) and line.compare("Elements") != 0)
-        ;
+public:
+    LineChunks(const char* begin, const char* end)
+        : mEnd(end)
+    {
+        constexpr size_t minChunkSize = 1 << 18;
+        const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+        const size_t numChunks = std::max<size_t>(1, std::min(numThreads, (end - begin) / minChunkSize));
 
-    if (line.compare("Elements") != 0)
-        throw std::exception();
+        mChunkBegin.assign(numChunks + 1, end);
+        mChunkBegin[0] = begin;
+        for (size_t i = 1; i < numChunks; ++i)
+        {
+            const char* position = std::find(begin + i * (end - begin) / numChunks, end, '\n');
+            mChunkBegin[i] = position == end ? end : position + 1;
+        }
+    }
 
-    int num_elements = 0;
-    file >> num_elements;
+    size_t size() const
+    {
+        return mChunkBegin.size() - 1;
+    }
 
-    std::vector<Element> elements(num_elements);
-    for (auto& element : elements)
+    //! @brief Calls \a function(chunk) for all chunks in parallel, exceptions are passed to the caller
+    template <typename Function>
+    void Run(Function function) const
     {
-        file >> element.mId;
+        std::vector<std::exception_ptr> errors(size());
+        auto runChunk = [&](size_t chunk) {
+            try
+            {
+                function(chunk);
+            }
+            catch (...)
+            {
+                errors[chunk] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t chunk = 1; chunk < size(); ++chunk)
+            threads.emplace_back(runChunk, chunk);
+        runChunk(0);
+        for (auto& thread : threads)
+            thread.join();
+
+        for (const auto& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
 
-        element.mNodeIds.resize(4);
+    //! @brief Calls \a function(tokenizer) for every non-blank line starting in \a chunk
+    template <typename Function>
+    void ForEachLine(size_t chunk, Function function) const
+    {
+        for (const char* line = mChunkBegin[chunk]; line < mChunkBegin[chunk + 1];)
+        {
+            const char* lineEnd = std::find(line, mEnd, '\n');
+            MeshTokenizer tokenizer(line, lineEnd);
+            if (not tokenizer.AtEnd())
+                function(tokenizer);
+            line = lineEnd == mEnd ? mEnd : lineEnd + 1;
+        }
+    }
 
-        for (auto& nodeId : element.mNodeIds)
-            file >> nodeId;
+private:
+    const char* mEnd;
+    std::vector<const char*> mChunkBegin;
+};
+
+
+//! @brief Exclusive prefix sum in place, returns the total
+size_t PrefixSum(std::vector<size_t>& rCounts)
+{
+    size_t total = 0;
+    for (auto& count : rCounts)
+    {
+        const size_t current = count;
+        count = total;
+        total += current;
     }
+    return total;
+}
 
-    return elements;
+
+void CheckNumRecords(size_t expected, size_t found)
+{
+    if (expected != found)
+        throw std::runtime_error("Expected "s + std::to_string(expected) + " records in the mesh file, found " +
+                                 std::to_string(found));
+}
+
+
+//! @brief Reads the section starting at \a begin, the next section starts at \a end
+std::vector<Node> ReadNodeData(const char* begin, const char* end)
+{
+    MeshTokenizer tokenizer(begin, end);
+    tokenizer.SkipLine();
+    const int num_nodes = tokenizer.ReadInt();
+    tokenizer.SkipLine();
+
+    const LineChunks chunks(tokenizer.Position(), end);
+    std::vector<size_t> offsets(chunks.size(), 0);
+    chunks.Run([&](size_t chunk) { chunks.ForEachLine(chunk, [&](MeshTokenizer&) { ++offsets[chunk]; }); });
+    CheckNumRecords(num_nodes, PrefixSum(offsets));
+
+    std::vector<Node> nodes(num_nodes);
+    chunks.Run([&](size_t chunk) {
+        Node* node = nodes.data() + offsets[chunk];
+        chunks.ForEachLine(chunk, [&](MeshTokenizer& line) {
+            node->mId = line.ReadInt();
+            node->mCoordinates[0] = line.ReadDouble();
+            node->mCoordinates[1] = line.ReadDouble();
+            node->mCoordinates[2] = line.ReadDouble();
+            ++node;
+        });
+    });
+
+    return nodes;
 }
 
-std::vector<Boundary> ReadBoundaryData(std::ifstream& file)
+//! @brief Reads elements with any number of nodes, the type is derived from the number of nodes and \a dimension
+ElementBlock ReadElementData(const char* begin, const char* end, int dimension)
 {
-    std::string line = "initialization";
-    while (std::getline(file, line) and line.compare("Boundaries") != 0)
-        ;
+    MeshTokenizer tokenizer(begin, end);
+    tokenizer.SkipLine();
+    const int num_elements = tokenizer.ReadInt();
+    tokenizer.SkipLine();
+
+    // count elements and node ids per chunk
+    const LineChunks chunks(tokenizer.Position(), end);
+    std::vector<size_t> elementOffsets(chunks.size(), 0);
+    std::vector<size_t> nodeIdOffsets(chunks.size(), 0);
+    chunks.Run([&](size_t chunk) {
+        chunks.ForEachLine(chunk, [&](MeshTokenizer& line) {
+            ++elementOffsets[chunk];
+            line.ReadInt();
+            while (not line.AtEnd())
+            {
+                line.ReadInt();
+                ++nodeIdOffsets[chunk];
+            }
+        });
+    });
+    CheckNumRecords(num_elements, PrefixSum(elementOffsets));
+    const size_t num_node_ids = PrefixSum(nodeIdOffsets);
+
+    ElementBlock elements;
+    elements.mIds.resize(num_elements);
+    elements.mTypes.resize(num_elements);
+    elements.mPhysicalGroups.assign(num_elements, 0);
+    elements.mOffsets.resize(num_elements + 1);
+    elements.mOffsets[num_elements] = num_node_ids;
+    elements.mNodeIds.resize(num_node_ids);
+
+    chunks.Run([&](size_t chunk) {
+        size_t element = elementOffsets[chunk];
+        size_t nodeId = nodeIdOffsets[chunk];
+        chunks.ForEachLine(chunk, [&](MeshTokenizer& line) {
+            elements.mIds[element] = line.ReadInt();
+            elements.mOffsets[element] = nodeId;
+            while (not line.AtEnd())
+                elements.mNodeIds[nodeId++] = line.ReadInt();
+            elements.mTypes[element] = ElementTypeFromNumNodes(nodeId - elements.mOffsets[element], dimension);
+            ++element;
+        });
+    });
 
-    if (line.compare("Boundaries") != 0)
-        throw std::exception();
+    return elements;
+}
 
-    int num_boundaries = 0;
-    file >> num_boundaries;
+std::vector<Boundary> ReadBoundaryData(const char* begin, const char* end)
+{
+    MeshTokenizer tokenizer(begin, end);
+    tokenizer.SkipLine();
+    const int num_boundaries = tokenizer.ReadInt();
 
     std::vector<Boundary> boundaries(num_boundaries);
     for (auto& boundary : boundaries)
     {
-        int num_nodes = 0;
-        file >> num_nodes;
+        const int num_nodes = tokenizer.ReadInt();
 
-        for (int i = 0; i < num_nodes; ++i)
+        std::vector<FlatIdMap::value_type> nodeIds(num_nodes);
+        for (auto& ids : nodeIds)
         {
-            int globalId = 0;
-            int localId = 0;
-            file >> globalId >> localId;
-            boundary.mNodeIdsMap.emplace(globalId, localId);
+            ids.first = tokenizer.ReadInt();
+            ids.second = tokenizer.ReadInt();
         }
+        boundary.mNodeIdsMap.Assign(std::move(nodeIds));
+
+        // skip the rest of the line and the line with the prescribed values
+        tokenizer.SkipLine();
+        tokenizer.SkipLine();
     }
 
     return boundaries;
 }
 
-std::vector<Interface> ReadInterfaceData(std::ifstream& file)
+std::vector<Interface> ReadInterfaceData(const char* begin, const char* end)
 {
-    std::string line = "initialization";
-    while (std::getline(file, line) and line.compare("Interfaces") != 0)
-        ;
-
-    if (line.compare("Interfaces") != 0)
-        throw std::exception();
-
-    int num_interfaces = 0;
-    file >> num_interfaces;
+    MeshTokenizer tokenizer(begin, end);
+    tokenizer.SkipLine();
+    const int num_interfaces = tokenizer.ReadInt();
 
     std::vector<Interface> interfaces(num_interfaces);
     for (auto& interface : interfaces)
     {
-        int num_nodes = 0;
-        file >> num_nodes;
+        const int num_nodes = tokenizer.ReadInt();
 
-        for (int i = 0; i < num_nodes; ++i)
+        std::vector<FlatIdMap::value_type> nodeIds(num_nodes);
+        for (auto& ids : nodeIds)
         {
-            int globalId = 0;
-            int localId = 0;
-            file >> globalId >> localId;
-            interface.mNodeIdsMap.emplace(globalId, localId);
+            ids.first = tokenizer.ReadInt();
+            ids.second = tokenizer.ReadInt();
         }
+        interface.mNodeIdsMap.Assign(std::move(nodeIds));
 
-        file >> interface.mValue;
+        interface.mValue = tokenizer.ReadInt();
     }
 
     return interfaces;
 }
 
 
+//! @brief Imports a mesh file with the sections Nodes, Elements, Boundaries and Interfaces
+//!
+//! The file is memory mapped and the node and element blocks are parsed in parallel. Elements may have any
+//! number of nodes, meshes whose nodes all have z = 0 are treated as two dimensional.
 ImportContainer ImportMeshFile(const std::string& rFileName)
 {
+    const MappedFile file(rFileName);
 
-    std::ifstream file(rFileName.c_str(), std::ios::in);
-    if (not file.is_open())
-        std::cout << "Mesh file did not open. Check path." << std::endl;
+    const char* nodesSection = FindSection(file.begin(), file.end(), "Nodes");
+    const char* elementsSection = FindSection(nodesSection, file.end(), "Elements");
+    const char* boundariesSection = FindSection(elementsSection, file.end(), "Boundaries");
+    const char* interfacesSection = FindSection(boundariesSection, file.end(), "Interfaces");
 
     ImportContainer importContainer;
 
-    importContainer.mNodeList = ReadNodeData(file);
-    importContainer.mElementList = ReadElementData(file);
-    importContainer.mBoundaryList = ReadBoundaryData(file);
-    importContainer.mInterfaceList = ReadInterfaceData(file);
-
-
-    file.close();
+    importContainer.mNodeList = ReadNodeData(nodesSection, elementsSection);
+    const bool isPlanar = std::all_of(importContainer.mNodeList.begin(), importContainer.mNodeList.end(),
+                                      [](const Node& node) { return node.mCoordinates[2] == 0.; });
+    importContainer.mElementList = ReadElementData(elementsSection, boundariesSection, isPlanar ? 2 : 3);
+    importContainer.mBoundaryList = ReadBoundaryData(boundariesSection, interfacesSection);
+    importContainer.mInterfaceList = ReadInterfaceData(interfacesSection, file.end());
 
     return importContainer;
 }
@@ -0,0 +1,460 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ImportMesh.h"
+
+
+//! @brief Event based JSON parser, reports every value to a handler instead of building a document tree
+//!
+//! The handler provides StartObject(), EndObject(), StartArray(), EndArray(), Key(const std::string&),
+//! Number(double), String(const std::string&), Bool(bool) and Null(). Numbers are parsed with the
+//! MeshTokenizer, strings are decoded into one reused buffer.
+template <typename Handler>
+class JsonSaxParser
+{
+public:
+    JsonSaxParser(const char* begin, const char* end, Handler& rHandler)
+        : mTokenizer(begin, end)
+        , mEnd(end)
+        , mHandler(rHandler)
+    {
+    }
+
+    void Parse()
+    {
+        ParseValue(0);
+        if (not mTokenizer.AtEnd())
+            Error("unexpected characters after the document");
+    }
+
+private:
+    static constexpr int maxDepth = 64;
+
+    void ParseValue(int depth)
+    {
+        if (depth > maxDepth)
+            Error("nested too deeply");
+
+        switch (Peek())
+        {
+        case '{':
+            ParseObject(depth);
+            break;
+        case '[':
+            ParseArray(depth);
+            break;
+        case '"':
+            ParseString();
+            mHandler.String(mString);
+            break;
+        case 't':
+            ExpectLiteral("true");
+            mHandler.Bool(true);
+            break;
+        case 'f':
+            ExpectLiteral("false");
+            mHandler.Bool(false);
+            break;
+        case 'n':
+            ExpectLiteral("null");
+            mHandler.Null();
+            break;
+        default:
+            mHandler.Number(mTokenizer.ReadDouble());
+        }
+    }
+
+    void ParseObject(int depth)
+    {
+        Advance();
+        mHandler.StartObject();
+        if (Peek() == '}')
+        {
+            Advance();
+            mHandler.EndObject();
+            return;
+        }
+        while (true)
+        {
+            if (Peek() != '"')
+                Error("expected a key");
+            ParseString();
+            mHandler.Key(mString);
+            if (Peek() != ':')
+                Error("expected ':'");
+            Advance();
+            ParseValue(depth + 1);
+
+            const char next = Peek();
+            Advance();
+            if (next == '}')
+                break;
+            if (next != ',')
+                Error("expected ',' or '}'");
+        }
+        mHandler.EndObject();
+    }
+
+    void ParseArray(int depth)
+    {
+        Advance();
+        mHandler.StartArray();
+        if (Peek() == ']')
+        {
+            Advance();
+            mHandler.EndArray();
+            return;
+        }
+        while (true)
+        {
+            ParseValue(depth + 1);
+
+            const char next = Peek();
+            Advance();
+            if (next == ']')
+                break;
+            if (next != ',')
+                Error("expected ',' or ']'");
+        }
+        mHandler.EndArray();
+    }
+
+    //! @brief Decodes the string at the current position into mString, \uXXXX escapes are kept verbatim
+    void ParseString()
+    {
+        const char* position = mTokenizer.Position() + 1;
+        mString.clear();
+        while (position != mEnd and *position != '"')
+        {
+            if (*position == '\\' and position + 1 != mEnd)
+            {
+                ++position;
+                switch (*position)
+                {
+                case 'n':
+                    mString += '\n';
+                    break;
+                case 't':
+                    mString += '\t';
+                    break;
+                case 'r':
+                    mString += '\r';
+                    break;
+                case 'b':
+                    mString += '\b';
+                    break;
+                case 'f':
+                    mString += '\f';
+                    break;
+                case 'u':
+                    mString += "\\u";
+                    break;
+                default:
+                    mString += *position;
+                }
+            }
+            else
+                mString += *position;
+            ++position;
+        }
+        if (position == mEnd)
+            Error("unterminated string");
+        mTokenizer = MeshTokenizer(position + 1, mEnd);
+    }
+
+    void ExpectLiteral(const std::string& rLiteral)
+    {
+        const char* position = mTokenizer.Position();
+        if (static_cast<size_t>(mEnd - position) < rLiteral.size() or
+            not std::equal(rLiteral.begin(), rLiteral.end(), position))
+            Error("invalid literal");
+        mTokenizer = MeshTokenizer(position + rLiteral.size(), mEnd);
+    }
+
+    //! @brief Next non-whitespace character, 0 at the end of the document
+    char Peek()
+    {
+        return mTokenizer.AtEnd() ? 0 : *mTokenizer.Position();
+    }
+
+    void Advance()
+    {
+        mTokenizer = MeshTokenizer(mTokenizer.Position() + 1, mEnd);
+    }
+
+    [[noreturn]] void Error(const std::string& rMessage) const
+    {
+        throw std::runtime_error("Invalid JSON: "s + rMessage);
+    }
+
+    MeshTokenizer mTokenizer;
+    const char* mEnd;
+    Handler& mHandler;
+    std::string mString;
+};
+
+
+//! @brief Writes the events of a JSON subdomain mesh (.meshN) directly into an ImportContainer
+//!
+//! Expected layout:
+//!   Nodes:            [{Coordinates: [[x, y, z], ...], Indices: [...]}, ...]
+//!   Elements:         [{Indices: [...], Name: "", NodalConnectivity: [[...], ...], Type: gmsh type}, ...]
+//!   Interface:        [{GlobalStartId: [...], Master: [...], NodeIds: [[...], ...], Slave: [...], Value: [...]}]
+//!   LocalToGlobalMap: [...]
+//!   NumInterfaceNodes: [...]
+//! Every element group becomes a physical group, numbered from 1. Unknown keys are ignored. Older files with
+//! Nodes as a plain list of coordinates and without element Indices are numbered consecutively from 0.
+class SubdomainMeshJsonHandler
+{
+public:
+    explicit SubdomainMeshJsonHandler(ImportContainer& rContainer)
+        : mContainer(rContainer)
+    {
+    }
+
+    void StartObject()
+    {
+        StartContainer();
+        if (mDepth == 3)
+            StartGroup();
+    }
+
+    void EndObject()
+    {
+        if (mDepth == 3)
+            EndGroup();
+        EndContainer();
+    }
+
+    void StartArray()
+    {
+        StartContainer();
+        // a new interface node list
+        if (mDepth == 5 and mSection == eSection::Interface and mKeys[3] == "NodeIds")
+            mInterfaceNodeIds.clear();
+    }
+
+    void EndArray()
+    {
+        if (mDepth == 5 and mSection == eSection::Elements and mKeys[3] == "NodalConnectivity")
+        {
+            const int element = mGroupStart + mIndex[4];
+            if (element + 1 >= static_cast<int>(mContainer.mElementList.mOffsets.size()))
+                mContainer.mElementList.mOffsets.resize(element + 2, 0);
+            mContainer.mElementList.mOffsets[element + 1] = mContainer.mElementList.mNodeIds.size();
+        }
+        if (mDepth == 5 and mSection == eSection::Interface and mKeys[3] == "NodeIds")
+            InterfaceAt(mIndex[4]).mNodeIdsMap.Assign(std::move(mInterfaceNodeIds));
+        EndContainer();
+    }
+
+    void Key(const std::string& rKey)
+    {
+        if (mDepth < maxDepth)
+            mKeys[mDepth] = rKey;
+        if (mDepth == 1)
+            mSection = SectionFromKey(rKey);
+    }
+
+    void Number(double value)
+    {
+        const int intValue = static_cast<int>(value);
+        switch (mSection)
+        {
+        case eSection::Nodes:
+            if (mDepth == 5 and mKeys[3] == "Coordinates" and mIndex[5] < 3)
+                NodeAt(mIndex[4]).mCoordinates[mIndex[5]] = value;
+            else if (mDepth == 4 and mKeys[3] == "Indices")
+                NodeAt(mIndex[4]).mId = intValue;
+            else if (mDepth == 3 and mIndex[3] < 3)
+            {
+                // older files: plain list of coordinates, numbered consecutively
+                Node& node = NodeAt(mIndex[2]);
+                node.mId = mIndex[2];
+                node.mCoordinates[mIndex[3]] = value;
+            }
+            break;
+        case eSection::Elements:
+            if (mDepth == 5 and mKeys[3] == "NodalConnectivity")
+                mContainer.mElementList.mNodeIds.push_back(intValue);
+            else if (mDepth == 4 and mKeys[3] == "Indices")
+                ElementIdAt(mIndex[4]) = intValue;
+            else if (mDepth == 3 and mKeys[3] == "Type")
+                mGroupType = intValue;
+            break;
+        case eSection::Interface:
+            if (mDepth == 5 and mKeys[3] == "NodeIds")
+                mInterfaceNodeIds.emplace_back(intValue, mIndex[5]);
+            else if (mDepth == 4 and mKeys[3] == "GlobalStartId")
+                InterfaceAt(mIndex[4]).mGlobalStartId = intValue;
+            else if (mDepth == 4 and mKeys[3] == "Master")
+                InterfaceAt(mIndex[4]).mMaster = intValue;
+            else if (mDepth == 4 and mKeys[3] == "Slave")
+                InterfaceAt(mIndex[4]).mSlave = intValue;
+            else if (mDepth == 4 and mKeys[3] == "Value")
+                InterfaceAt(mIndex[4]).mValue = intValue;
+            break;
+        case eSection::LocalToGlobalMap:
+            if (mDepth == 2)
+                mContainer.mLocalToGlobalMap.push_back(intValue);
+            break;
+        case eSection::NumInterfaceNodes:
+            if (mDepth == 2)
+                mContainer.mNumInterfaceNodes.push_back(intValue);
+            break;
+        case eSection::Other:
+            break;
+        }
+        EndValue();
+    }
+
+    void String(const std::string&)
+    {
+        EndValue();
+    }
+
+    void Bool(bool)
+    {
+        EndValue();
+    }
+
+    void Null()
+    {
+        EndValue();
+    }
+
+private:
+    enum class eSection
+    {
+        Nodes,
+        Elements,
+        Interface,
+        LocalToGlobalMap,
+        NumInterfaceNodes,
+        Other
+    };
+
+    static constexpr int maxDepth = 8;
+
+    static eSection SectionFromKey(const std::string& rKey)
+    {
+        if (rKey == "Nodes")
+            return eSection::Nodes;
+        if (rKey == "Elements")
+            return eSection::Elements;
+        if (rKey == "Interface")
+            return eSection::Interface;
+        if (rKey == "LocalToGlobalMap")
+            return eSection::LocalToGlobalMap;
+        if (rKey == "NumInterfaceNodes")
+            return eSection::NumInterfaceNodes;
+        return eSection::Other;
+    }
+
+    void StartContainer()
+    {
+        ++mDepth;
+        if (mDepth < maxDepth)
+        {
+            mIndex[mDepth] = 0;
+            mKeys[mDepth].clear();
+        }
+    }
+
+    void EndContainer()
+    {
+        --mDepth;
+        EndValue();
+    }
+
+    //! @brief Advances the index of the enclosing array
+    void EndValue()
+    {
+        if (mDepth < maxDepth)
+            ++mIndex[mDepth];
+    }
+
+    void StartGroup()
+    {
+        switch (mSection)
+        {
+        case eSection::Nodes:
+            mGroupStart = mContainer.mNodeList.size();
+            break;
+        case eSection::Elements:
+            mGroupStart = mContainer.mElementList.mIds.size();
+            mGroupType = 0;
+            break;
+        case eSection::Interface:
+            mGroupStart = mContainer.mInterfaceList.size();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void EndGroup()
+    {
+        if (mSection != eSection::Elements)
+            return;
+
+        // the type is a property of the whole group and may follow the connectivity
+        auto& elements = mContainer.mElementList;
+        const size_t numElements = std::max(elements.mIds.size(), elements.mOffsets.size() - 1);
+        for (size_t element = elements.mIds.size(); element < numElements; ++element)
+            elements.mIds.push_back(element); // older files have no element ids
+        elements.mOffsets.resize(numElements + 1, elements.mNodeIds.size());
+        elements.mTypes.resize(numElements, ElementTypeFromGmsh(mGroupType));
+        elements.mPhysicalGroups.resize(numElements, mIndex[2] + 1);
+    }
+
+    Node& NodeAt(int index)
+    {
+        auto& nodes = mContainer.mNodeList;
+        if (mGroupStart + index >= static_cast<int>(nodes.size()))
+            nodes.resize(mGroupStart + index + 1, Node{Eigen::Vector3d::Zero(), 0});
+        return nodes[mGroupStart + index];
+    }
+
+    int& ElementIdAt(int index)
+    {
+        auto& ids = mContainer.mElementList.mIds;
+        if (mGroupStart + index >= static_cast<int>(ids.size()))
+            ids.resize(mGroupStart + index + 1, 0);
+        return ids[mGroupStart + index];
+    }
+
+    Interface& InterfaceAt(int index)
+    {
+        auto& interfaces = mContainer.mInterfaceList;
+        if (mGroupStart + index >= static_cast<int>(interfaces.size()))
+            interfaces.resize(mGroupStart + index + 1, Interface{FlatIdMap(), 0});
+        return interfaces[mGroupStart + index];
+    }
+
+    ImportContainer& mContainer;
+    int mDepth = 0;
+    std::string mKeys[maxDepth];
+    int mIndex[maxDepth] = {};
+    eSection mSection = eSection::Other;
+    int mGroupStart = 0;
+    int mGroupType = 0;
+    std::vector<FlatIdMap::value_type> mInterfaceNodeIds; //!< (node id, position) of the current interface
+};
+
+
+//! @brief Imports a JSON subdomain mesh (.meshN) without building a JSON document
+//!
+//! The file is memory mapped and parsed in one pass, the values are written straight into the arrays of the
+//! ImportContainer. Interface node ids are stored as (node id, position in the interface) pairs, the global
+//! multiplier id of a node is mGlobalStartId + position.
+ImportContainer ImportMeshJsonFile(const std::string& rFileName)
+{
+    const MappedFile file(rFileName);
+
+    ImportContainer container;
+    SubdomainMeshJsonHandler handler(container);
+    JsonSaxParser<SubdomainMeshJsonHandler>(file.begin(), file.end(), handler).Parse();
+    return container;
+}
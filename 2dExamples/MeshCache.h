@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ImportMesh.h"
+
+
+//! @brief Size and modification time of a mesh file, a cache is only valid for the file it was written for
+struct MeshSourceStamp
+{
+    std::uint64_t mSize = 0;
+    std::int64_t mModificationTime = 0; //!< nanoseconds since epoch
+
+    static MeshSourceStamp Of(const std::string& rFileName)
+    {
+        struct stat fileStatus;
+        if (stat(rFileName.c_str(), &fileStatus) != 0)
+            throw std::runtime_error("Mesh file "s + rFileName + " did not open. Check path.");
+
+        MeshSourceStamp stamp;
+        stamp.mSize = fileStatus.st_size;
+        stamp.mModificationTime =
+                std::int64_t(fileStatus.st_mtim.tv_sec) * 1000000000 + std::int64_t(fileStatus.st_mtim.tv_nsec);
+        return stamp;
+    }
+};
+
+
+//! @brief Fixed size header of a binary mesh snapshot
+//!
+//! The header is followed by 8 byte aligned arrays in this order: node ids, node coordinates (x, y, z per
+//! node), element ids, types, physical groups, offsets and node ids, then for each boundary the number of
+//! pairs and values, the (global, local) pairs and the values, for each interface the number of pairs, the
+//! value, global start id, master, slave and the pairs, and finally the local to global map and the numbers of
+//! interface nodes. All data is stored in native byte order.
+struct MeshCacheHeader
+{
+    static constexpr std::uint32_t currentVersion = 2;
+    static constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+    char mMagic[8] = {'N', 'U', 'T', 'O', 'M', 'E', 'S', 'H'};
+    std::uint32_t mVersion = currentVersion;
+    std::uint32_t mByteOrder = byteOrderMark;
+    MeshSourceStamp mSource;
+    std::uint64_t mNumNodes = 0;
+    std::uint64_t mNumElements = 0;
+    std::uint64_t mNumElementNodeIds = 0;
+    std::uint64_t mNumBoundaries = 0;
+    std::uint64_t mNumInterfaces = 0;
+    std::uint64_t mLocalToGlobalMapSize = 0;
+    std::uint64_t mNumInterfaceNodesSize = 0;
+
+    bool IsValidFor(const MeshSourceStamp& rSource) const
+    {
+        const MeshCacheHeader reference;
+        return std::equal(mMagic, mMagic + 8, reference.mMagic) and mVersion == currentVersion and
+               mByteOrder == byteOrderMark and mSource.mSize == rSource.mSize and
+               mSource.mModificationTime == rSource.mModificationTime;
+    }
+};
+
+
+//! @brief Name of the snapshot next to a mesh file
+std::string MeshCacheFileName(const std::string& rFileName)
+{
+    return rFileName + ".cache";
+}
+
+
+//! @brief Appends 8 byte aligned arrays to a binary file
+class MeshCacheWriter
+{
+public:
+    explicit MeshCacheWriter(const std::string& rFileName)
+        : mFile(rFileName, std::ios::binary)
+    {
+        if (not mFile)
+            throw std::runtime_error("Could not write the mesh cache "s + rFileName);
+    }
+
+    template <typename T>
+    void Write(const T* data, size_t count)
+    {
+        mFile.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+        static const char padding[8] = {};
+        mFile.write(padding, (8 - (count * sizeof(T)) % 8) % 8);
+    }
+
+    template <typename T>
+    void Write(const std::vector<T>& rData)
+    {
+        Write(rData.data(), rData.size());
+    }
+
+    template <typename T>
+    void Write(const T& rValue)
+    {
+        Write(&rValue, 1);
+    }
+
+    void Close()
+    {
+        mFile.close();
+        if (not mFile)
+            throw std::runtime_error("Could not write the mesh cache");
+    }
+
+private:
+    std::ofstream mFile;
+};
+
+
+//! @brief Reads the arrays written by MeshCacheWriter from mapped memory, throws if the snapshot is truncated
+class MeshCacheReader
+{
+public:
+    MeshCacheReader(const char* begin, const char* end)
+        : mPosition(begin)
+        , mEnd(end)
+    {
+    }
+
+    template <typename T>
+    void Read(T* data, size_t count)
+    {
+        CheckAvailable<T>(count);
+        const size_t numBytes = count * sizeof(T);
+        std::copy(mPosition, mPosition + numBytes, reinterpret_cast<char*>(data));
+        mPosition += std::min<size_t>(mEnd - mPosition, numBytes + (8 - numBytes % 8) % 8);
+    }
+
+    template <typename T>
+    void Read(std::vector<T>& rData, size_t count)
+    {
+        CheckAvailable<T>(count);
+        rData.resize(count);
+        Read(rData.data(), count);
+    }
+
+    template <typename T>
+    T Read()
+    {
+        T value;
+        Read(&value, 1);
+        return value;
+    }
+
+private:
+    //! @brief Throws before \a count elements are allocated that the snapshot cannot contain
+    template <typename T>
+    void CheckAvailable(size_t count) const
+    {
+        if (count > static_cast<size_t>(mEnd - mPosition) / sizeof(T))
+            throw std::runtime_error("Truncated mesh cache");
+    }
+
+    const char* mPosition;
+    const char* mEnd;
+};
+
+
+void WriteMeshCache(const ImportContainer& rContainer, const std::string& rCacheFileName,
+                    const MeshSourceStamp& rSource)
+{
+    // write to a temporary file first, other processes may read the cache at the same time
+    const std::string temporaryFileName = rCacheFileName + "." + std::to_string(getpid());
+    {
+        MeshCacheWriter writer(temporaryFileName);
+
+        const auto& nodes = rContainer.mNodeList;
+        const auto& elements = rContainer.mElementList;
+
+        MeshCacheHeader header;
+        header.mSource = rSource;
+        header.mNumNodes = nodes.size();
+        header.mNumElements = elements.size();
+        header.mNumElementNodeIds = elements.mNodeIds.size();
+        header.mNumBoundaries = rContainer.mBoundaryList.size();
+        header.mNumInterfaces = rContainer.mInterfaceList.size();
+        header.mLocalToGlobalMapSize = rContainer.mLocalToGlobalMap.size();
+        header.mNumInterfaceNodesSize = rContainer.mNumInterfaceNodes.size();
+        writer.Write(header);
+
+        std::vector<int> nodeIds(nodes.size());
+        std::vector<double> coordinates(3 * nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            nodeIds[i] = nodes[i].mId;
+            for (int j = 0; j < 3; ++j)
+                coordinates[3 * i + j] = nodes[i].mCoordinates[j];
+        }
+        writer.Write(nodeIds);
+        writer.Write(coordinates);
+
+        writer.Write(elements.mIds);
+        writer.Write(elements.mTypes);
+        writer.Write(elements.mPhysicalGroups);
+        writer.Write(elements.mOffsets);
+        writer.Write(elements.mNodeIds);
+
+        for (const auto& boundary : rContainer.mBoundaryList)
+        {
+            writer.Write(std::uint64_t(boundary.mNodeIdsMap.size()));
+            writer.Write(std::uint64_t(boundary.mValues.size()));
+            writer.Write(boundary.mNodeIdsMap.data(), boundary.mNodeIdsMap.size());
+            writer.Write(boundary.mValues);
+        }
+
+        for (const auto& interface : rContainer.mInterfaceList)
+        {
+            writer.Write(std::uint64_t(interface.mNodeIdsMap.size()));
+            const std::int32_t values[4] = {interface.mValue, interface.mGlobalStartId, interface.mMaster,
+                                            interface.mSlave};
+            writer.Write(values, 4);
+            writer.Write(interface.mNodeIdsMap.data(), interface.mNodeIdsMap.size());
+        }
+
+        writer.Write(rContainer.mLocalToGlobalMap);
+        writer.Write(rContainer.mNumInterfaceNodes);
+        writer.Close();
+    }
+
+    if (std::rename(temporaryFileName.c_str(), rCacheFileName.c_str()) != 0)
+    {
+        std::remove(temporaryFileName.c_str());
+        throw std::runtime_error("Could not write the mesh cache "s + rCacheFileName);
+    }
+}
+
+
+//! @brief Reads the snapshot \a rCacheFileName, returns false if it is missing, stale or damaged
+bool ReadMeshCache(const std::string& rCacheFileName, const MeshSourceStamp& rSource, ImportContainer& rContainer)
+{
+    struct stat fileStatus;
+    if (stat(rCacheFileName.c_str(), &fileStatus) != 0)
+        return false;
+
+    try
+    {
+        const MappedFile file(rCacheFileName);
+        MeshCacheReader reader(file.begin(), file.end());
+
+        const auto header = reader.Read<MeshCacheHeader>();
+        if (not header.IsValidFor(rSource))
+            return false;
+
+        ImportContainer container;
+
+        std::vector<int> nodeIds;
+        std::vector<double> coordinates;
+        reader.Read(nodeIds, header.mNumNodes);
+        reader.Read(coordinates, 3 * header.mNumNodes);
+        container.mNodeList.resize(header.mNumNodes);
+        for (size_t i = 0; i < header.mNumNodes; ++i)
+        {
+            container.mNodeList[i].mId = nodeIds[i];
+            container.mNodeList[i].mCoordinates = Eigen::Vector3d::Map(&coordinates[3 * i]);
+        }
+
+        auto& elements = container.mElementList;
+        reader.Read(elements.mIds, header.mNumElements);
+        reader.Read(elements.mTypes, header.mNumElements);
+        reader.Read(elements.mPhysicalGroups, header.mNumElements);
+        reader.Read(elements.mOffsets, header.mNumElements + 1);
+        reader.Read(elements.mNodeIds, header.mNumElementNodeIds);
+        if (elements.mOffsets.front() != 0 or
+            static_cast<std::uint64_t>(elements.mOffsets.back()) != header.mNumElementNodeIds or
+            not std::is_sorted(elements.mOffsets.begin(), elements.mOffsets.end()))
+            throw std::runtime_error("Inconsistent element offsets in the mesh cache");
+
+        container.mBoundaryList.resize(header.mNumBoundaries);
+        for (auto& boundary : container.mBoundaryList)
+        {
+            const auto numPairs = reader.Read<std::uint64_t>();
+            const auto numValues = reader.Read<std::uint64_t>();
+            std::vector<FlatIdMap::value_type> pairs;
+            reader.Read(pairs, numPairs);
+            boundary.mNodeIdsMap.Assign(std::move(pairs));
+            reader.Read(boundary.mValues, numValues);
+        }
+
+        container.mInterfaceList.resize(header.mNumInterfaces);
+        for (auto& interface : container.mInterfaceList)
+        {
+            const auto numPairs = reader.Read<std::uint64_t>();
+            std::int32_t values[4];
+            reader.Read(values, 4);
+            interface.mValue = values[0];
+            interface.mGlobalStartId = values[1];
+            interface.mMaster = values[2];
+            interface.mSlave = values[3];
+            std::vector<FlatIdMap::value_type> pairs;
+            reader.Read(pairs, numPairs);
+            interface.mNodeIdsMap.Assign(std::move(pairs));
+        }
+
+        reader.Read(container.mLocalToGlobalMap, header.mLocalToGlobalMapSize);
+        reader.Read(container.mNumInterfaceNodes, header.mNumInterfaceNodesSize);
+
+        rContainer = std::move(container);
+        return true;
+    }
+    catch (std::runtime_error&)
+    {
+        return false;
+    }
+}
+
+
+//! @brief Imports \a rFileName with \a importer, or from its binary snapshot if that is up to date
+//!
+//! The snapshot is written next to the mesh file after the first import. Later imports map it instead of
+//! parsing the mesh again. If the directory is not writable, the mesh is simply imported without caching.
+template <typename Importer>
+ImportContainer CachedImport(const std::string& rFileName, Importer importer)
+{
+    const MeshSourceStamp source = MeshSourceStamp::Of(rFileName);
+    const std::string cacheFileName = MeshCacheFileName(rFileName);
+
+    ImportContainer container;
+    if (ReadMeshCache(cacheFileName, source, container))
+        return container;
+
+    container = importer(rFileName);
+    try
+    {
+        WriteMeshCache(container, cacheFileName, source);
+    }
+    catch (std::runtime_error& e)
+    {
+        std::cout << e.what() << ", continuing without cache." << std::endl;
+    }
+    return container;
+}
+
+
+//! @brief ImportMeshFile with a binary snapshot next to the mesh file
+ImportContainer ImportMeshFileCached(const std::string& rFileName)
+{
+    return CachedImport(rFileName, ImportMeshFile);
+}
@@ -0,0 +1,936 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "ImportMesh.h"
+
+
+//! @brief Reads the elements of a gmsh section [begin, end), only elements of the highest dimension are kept
+//!
+//! Lines and points (boundary elements of the gmsh file) are skipped. The first tag is stored as physical group.
+ElementBlock ReadGmshElementData(const char* begin, const char* end)
+{
+    MeshTokenizer tokenizer(begin, end);
+    tokenizer.SkipLine();
+    const int num_elements = tokenizer.ReadInt();
+    tokenizer.SkipLine();
+
+    // count elements and node ids per chunk and dimension, index 0 is two, index 1 three dimensional
+    const LineChunks chunks(tokenizer.Position(), end);
+    std::vector<size_t> elementOffsets[2] = {std::vector<size_t>(chunks.size(), 0),
+                                             std::vector<size_t>(chunks.size(), 0)};
+    std::vector<size_t> nodeIdOffsets[2] = {std::vector<size_t>(chunks.size(), 0),
+                                            std::vector<size_t>(chunks.size(), 0)};
+    std::vector<size_t> numRecords(chunks.size(), 0);
+    chunks.Run([&](size_t chunk) {
+        chunks.ForEachLine(chunk, [&](MeshTokenizer& line) {
+            ++numRecords[chunk];
+            line.ReadInt();
+            const int dimension = ElementDimension(ElementTypeFromGmsh(line.ReadInt()));
+            if (dimension < 2)
+                return;
+            for (int numTags = line.ReadInt(); numTags > 0; --numTags)
+                line.ReadInt();
+            ++elementOffsets[dimension - 2][chunk];
+            while (not line.AtEnd())
+            {
+                line.ReadInt();
+                ++nodeIdOffsets[dimension - 2][chunk];
+            }
+        });
+    });
+    CheckNumRecords(num_elements, PrefixSum(numRecords));
+
+    const size_t num_solid_elements[2] = {PrefixSum(elementOffsets[0]), PrefixSum(elementOffsets[1])};
+    const int dimension = num_solid_elements[1] > 0 ? 3 : 2;
+    if (num_solid_elements[dimension - 2] == 0)
+        throw std::runtime_error("The gmsh file contains no two or three dimensional elements");
+
+    const size_t numElements = num_solid_elements[dimension - 2];
+    const size_t numNodeIds = PrefixSum(nodeIdOffsets[dimension - 2]);
+
+    ElementBlock elements;
+    elements.mIds.resize(numElements);
+    elements.mTypes.resize(numElements);
+    elements.mPhysicalGroups.resize(numElements);
+    elements.mOffsets.resize(numElements + 1);
+    elements.mOffsets[numElements] = numNodeIds;
+    elements.mNodeIds.resize(numNodeIds);
+
+    chunks.Run([&](size_t chunk) {
+        size_t element = elementOffsets[dimension - 2][chunk];
+        size_t nodeId = nodeIdOffsets[dimension - 2][chunk];
+        chunks.ForEachLine(chunk, [&](MeshTokenizer& line) {
+            const int id = line.ReadInt();
+            const eElementType type = ElementTypeFromGmsh(line.ReadInt());
+            if (ElementDimension(type) != dimension)
+                return;
+            const int numTags = line.ReadInt();
+            elements.mPhysicalGroups[element] = numTags > 0 ? line.ReadInt() : 0;
+            for (int tag = 1; tag < numTags; ++tag)
+                line.ReadInt();
+
+            elements.mIds[element] = id;
+            elements.mTypes[element] = type;
+            elements.mOffsets[element] = nodeId;
+            while (not line.AtEnd())
+                elements.mNodeIds[nodeId++] = line.ReadInt();
+            ++element;
+        });
+    });
+
+    return elements;
+}
+
+
+//! @brief Imports the nodes and the elements of highest dimension of an ASCII gmsh file, version 2
+ImportContainer ReadGmshFile(const std::string& rFileName)
+{
+    const MappedFile file(rFileName);
+
+    MeshTokenizer format(FindSection(file.begin(), file.end(), "$MeshFormat"), file.end());
+    format.SkipLine();
+    const double version = format.ReadDouble();
+    const int fileType = format.ReadInt();
+    if (version < 2. or version >= 3. or fileType != 0)
+        throw std::runtime_error("Only ASCII gmsh files of version 2 are supported, "s + rFileName + " is not");
+
+    const char* nodesSection = FindSection(file.begin(), file.end(), "$Nodes");
+    const char* nodesEnd = FindSection(nodesSection, file.end(), "$EndNodes");
+    const char* elementsSection = FindSection(nodesEnd, file.end(), "$Elements");
+    const char* elementsEnd = FindSection(elementsSection, file.end(), "$EndElements");
+
+    ImportContainer importContainer;
+    importContainer.mNodeList = ReadNodeData(nodesSection, nodesEnd);
+    importContainer.mElementList = ReadGmshElementData(elementsSection, elementsEnd);
+    return importContainer;
+}
+
+
+//! @brief Names of the physical groups of a gmsh file, empty if the file has none
+std::map<int, std::string> ReadGmshPhysicalNames(const std::string& rFileName)
+{
+    const MappedFile file(rFileName);
+    std::map<int, std::string> names;
+
+    const char* section;
+    try
+    {
+        section = FindSection(file.begin(), file.end(), "$PhysicalNames");
+    }
+    catch (std::runtime_error&)
+    {
+        return names;
+    }
+
+    MeshTokenizer tokenizer(section, file.end());
+    tokenizer.SkipLine();
+    for (int num_names = tokenizer.ReadInt(); num_names > 0; --num_names)
+    {
+        tokenizer.ReadInt();
+        const int tag = tokenizer.ReadInt();
+        const char* nameBegin = std::find(tokenizer.Position(), file.end(), '"') + 1;
+        const char* nameEnd = std::find(nameBegin, file.end(), '"');
+        names[tag] = std::string(nameBegin, nameEnd);
+        tokenizer.SkipLine();
+    }
+    return names;
+}
+
+
+//! @brief Undirected graph with vertex and edge weights in compressed row storage
+struct Graph
+{
+    std::vector<int> mOffsets = std::vector<int>(1, 0);
+    std::vector<int> mAdjacency;
+    std::vector<int> mEdgeWeights;
+    std::vector<int> mVertexWeights;
+
+    int size() const
+    {
+        return mVertexWeights.size();
+    }
+
+    long TotalVertexWeight() const
+    {
+        return std::accumulate(mVertexWeights.begin(), mVertexWeights.end(), 0L);
+    }
+};
+
+
+//! @brief Maps the node ids of a mesh to their position in the node list
+FlatIdMap NodeIndices(const ImportContainer& rMesh)
+{
+    std::vector<FlatIdMap::value_type> indices(rMesh.mNodeList.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = {rMesh.mNodeList[i].mId, static_cast<int>(i)};
+    return FlatIdMap(std::move(indices));
+}
+
+
+//! @brief Dual graph of the elements, two elements are connected if they share a facet
+//!
+//! Elements sharing at least as many nodes as the mesh dimension count as neighbours. The edge weight is the
+//! number of shared nodes, the cut weight of a partition therefore approximates the number of interface nodes.
+//! All vertex weights are one.
+Graph ElementDualGraph(const ImportContainer& rMesh)
+{
+    const ElementBlock& elements = rMesh.mElementList;
+    const int numElements = elements.size();
+    const int numNodes = rMesh.mNodeList.size();
+
+    int dimension = 2;
+    for (const auto type : elements.mTypes)
+        dimension = std::max(dimension, ElementDimension(type));
+
+    // elements of each node in compressed row storage
+    const std::vector<int> nodeIndices = NodeIndices(rMesh).GlobalToLocal(elements.mNodeIds);
+    std::vector<int> nodeOffsets(numNodes + 1, 0);
+    for (const int node : nodeIndices)
+        ++nodeOffsets[node + 1];
+    std::partial_sum(nodeOffsets.begin(), nodeOffsets.end(), nodeOffsets.begin());
+    std::vector<int> nodeElements(nodeIndices.size());
+    {
+        std::vector<int> position(nodeOffsets.begin(), nodeOffsets.end() - 1);
+        for (int element = 0; element < numElements; ++element)
+            for (int i = elements.mOffsets[element]; i < elements.mOffsets[element + 1]; ++i)
+                nodeElements[position[nodeIndices[i]]++] = element;
+    }
+
+    Graph graph;
+    graph.mOffsets.reserve(numElements + 1);
+    graph.mVertexWeights.assign(numElements, 1);
+
+    std::vector<int> numSharedNodes(numElements, 0);
+    std::vector<int> neighbours;
+    for (int element = 0; element < numElements; ++element)
+    {
+        for (int i = elements.mOffsets[element]; i < elements.mOffsets[element + 1]; ++i)
+            for (int j = nodeOffsets[nodeIndices[i]]; j < nodeOffsets[nodeIndices[i] + 1]; ++j)
+            {
+                const int other = nodeElements[j];
+                if (other != element and numSharedNodes[other]++ == 0)
+                    neighbours.push_back(other);
+            }
+
+        std::sort(neighbours.begin(), neighbours.end());
+        for (const int other : neighbours)
+        {
+            if (numSharedNodes[other] >= dimension)
+            {
+                graph.mAdjacency.push_back(other);
+                graph.mEdgeWeights.push_back(numSharedNodes[other]);
+            }
+            numSharedNodes[other] = 0;
+        }
+        neighbours.clear();
+        graph.mOffsets.push_back(graph.mAdjacency.size());
+    }
+    return graph;
+}
+
+
+//! @brief Sum of the weights of all edges between different parts
+long EdgeCut(const Graph& rGraph, const std::vector<int>& rPartition)
+{
+    long cut = 0;
+    for (int v = 0; v < rGraph.size(); ++v)
+        for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+            if (rPartition[v] != rPartition[rGraph.mAdjacency[i]])
+                cut += rGraph.mEdgeWeights[i];
+    return cut / 2;
+}
+
+
+//! @brief Max priority queue of vertices by gain with lazy deletion, equal gains are served last in first out
+//!
+//! LIFO order keeps the moves of a FM pass local, which lets a jagged cut straighten out.
+class GainQueue
+{
+public:
+    void Push(int vertex, int gain)
+    {
+        mEntries.emplace(gain, mNumPushes++, vertex);
+    }
+
+    //! @brief Vertex of highest gain for which isValid(vertex, gain) holds, -1 if there is none
+    template <typename Predicate>
+    int Top(Predicate isValid)
+    {
+        while (not mEntries.empty() and not isValid(std::get<2>(mEntries.top()), std::get<0>(mEntries.top())))
+            mEntries.pop();
+        return mEntries.empty() ? -1 : std::get<2>(mEntries.top());
+    }
+
+private:
+    std::priority_queue<std::tuple<int, long, int>> mEntries;
+    long mNumPushes = 0;
+};
+
+
+struct PartitionOptions
+{
+    double mImbalance = 1.03; //!< maximum ratio of the heaviest part to the average part weight
+    int mCoarsestSize = 100; //!< coarsening stops below this number of vertices
+    int mNumInitialTrials = 8; //!< number of grown bisections of the coarsest graph, the best one is kept
+    int mNumRefinementPasses = 8; //!< maximum number of FM passes per level
+    unsigned mSeed = 1;
+};
+
+
+//! @brief Multilevel recursive bisection of a weighted graph
+//!
+//! Each bisection coarsens the graph by heavy edge matching, bisects the coarsest graph by greedy graph
+//! growing and refines the bisection with Fiduccia-Mattheyses (a linear time variant of Kernighan-Lin) on every
+//! level while projecting it back. Finally, parts that fell apart into several components are made connected,
+//! a floating piece would add rigid body modes to a FETI subdomain.
+class GraphPartitioner
+{
+public:
+    explicit GraphPartitioner(PartitionOptions options = PartitionOptions())
+        : mOptions(options)
+        , mRandom(options.mSeed)
+    {
+    }
+
+    //! @brief Part of every vertex, parts are numbered from 0 to numParts - 1
+    std::vector<int> Partition(const Graph& rGraph, int numParts)
+    {
+        if (numParts < 1)
+            throw std::runtime_error("The number of parts has to be positive");
+
+        std::vector<int> partition(rGraph.size(), 0);
+        std::vector<int> vertices(rGraph.size());
+        std::iota(vertices.begin(), vertices.end(), 0);
+
+        // every bisection may use its share of the imbalance
+        const double numLevels = std::max(1., std::ceil(std::log2(numParts)));
+        mBisectionImbalance = std::pow(mOptions.mImbalance, 1. / numLevels);
+
+        RecursiveBisection(rGraph, vertices, numParts, 0, partition);
+        MakePartsConnected(rGraph, numParts, partition);
+        return partition;
+    }
+
+private:
+    void RecursiveBisection(const Graph& rGraph, const std::vector<int>& rVertices, int numParts, int firstPart,
+                            std::vector<int>& rPartition)
+    {
+        if (numParts == 1 or rGraph.size() == 0)
+        {
+            for (const int vertex : rVertices)
+                rPartition[vertex] = firstPart;
+            return;
+        }
+
+        const int numParts0 = numParts / 2;
+        const std::vector<int> side = Bisection(rGraph, double(numParts0) / numParts);
+
+        for (int s = 0; s < 2; ++s)
+        {
+            std::vector<int> subVertices;
+            const Graph subGraph = SubGraph(rGraph, side, s, rVertices, subVertices);
+            RecursiveBisection(subGraph, subVertices, s == 0 ? numParts0 : numParts - numParts0,
+                               s == 0 ? firstPart : firstPart + numParts0, rPartition);
+        }
+    }
+
+    //! @brief Multilevel bisection, \a fraction is the target weight of side 0 relative to the total weight
+    std::vector<int> Bisection(const Graph& rGraph, double fraction)
+    {
+        std::vector<Graph> levels;
+        std::vector<std::vector<int>> coarseVertices;
+        const Graph* graph = &rGraph;
+        while (graph->size() > mOptions.mCoarsestSize)
+        {
+            std::vector<int> coarseVertex;
+            Graph coarse = Coarsen(*graph, coarseVertex);
+            if (coarse.size() > 0.95 * graph->size())
+                break;
+            levels.push_back(std::move(coarse));
+            coarseVertices.push_back(std::move(coarseVertex));
+            graph = &levels.back();
+        }
+
+        const long totalWeight = rGraph.TotalVertexWeight();
+        const long target[2] = {std::lround(fraction * totalWeight), totalWeight - std::lround(fraction * totalWeight)};
+
+        std::vector<int> side = InitialBisection(*graph, target);
+        for (int level = levels.size() - 1; level >= 0; --level)
+        {
+            const Graph& fine = level == 0 ? rGraph : levels[level - 1];
+            std::vector<int> fineSide(fine.size());
+            for (int v = 0; v < fine.size(); ++v)
+                fineSide[v] = side[coarseVertices[level][v]];
+            side = std::move(fineSide);
+            Refine(fine, target, side);
+        }
+        return side;
+    }
+
+    //! @brief Heavy edge matching, every vertex is merged with its unmatched neighbour of heaviest connection
+    Graph Coarsen(const Graph& rGraph, std::vector<int>& rCoarseVertex)
+    {
+        const int n = rGraph.size();
+        const long maxVertexWeight = 1 + 1.5 * rGraph.TotalVertexWeight() / mOptions.mCoarsestSize;
+
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), mRandom);
+
+        std::vector<int> match(n, -1);
+        for (const int v : order)
+        {
+            if (match[v] != -1)
+                continue;
+            int best = v;
+            int bestWeight = 0;
+            for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+            {
+                const int u = rGraph.mAdjacency[i];
+                if (match[u] == -1 and rGraph.mEdgeWeights[i] > bestWeight and
+                    rGraph.mVertexWeights[v] + rGraph.mVertexWeights[u] <= maxVertexWeight)
+                {
+                    best = u;
+                    bestWeight = rGraph.mEdgeWeights[i];
+                }
+            }
+            match[v] = best;
+            match[best] = v;
+        }
+
+        // coarse vertices are numbered in the order of the fine ones, which keeps neighbours close in memory
+        rCoarseVertex.assign(n, -1);
+        std::vector<int> fineVertices; // the one or two fine vertices of every coarse vertex
+        for (int v = 0; v < n; ++v)
+            if (rCoarseVertex[v] == -1)
+            {
+                rCoarseVertex[v] = rCoarseVertex[match[v]] = fineVertices.size() / 2;
+                fineVertices.push_back(v);
+                fineVertices.push_back(match[v]);
+            }
+
+        Graph coarse;
+        const int numCoarse = fineVertices.size() / 2;
+        coarse.mVertexWeights.resize(numCoarse);
+        coarse.mOffsets.reserve(numCoarse + 1);
+        std::vector<int> position(numCoarse, -1);
+        for (int c = 0; c < numCoarse; ++c)
+        {
+            const int first = fineVertices[2 * c];
+            const int second = fineVertices[2 * c + 1];
+            coarse.mVertexWeights[c] =
+                    rGraph.mVertexWeights[first] + (second != first ? rGraph.mVertexWeights[second] : 0);
+
+            const int rowBegin = coarse.mAdjacency.size();
+            for (const int v : {first, second})
+            {
+                for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                {
+                    const int u = rCoarseVertex[rGraph.mAdjacency[i]];
+                    if (u == c)
+                        continue;
+                    if (position[u] == -1)
+                    {
+                        position[u] = coarse.mAdjacency.size();
+                        coarse.mAdjacency.push_back(u);
+                        coarse.mEdgeWeights.push_back(0);
+                    }
+                    coarse.mEdgeWeights[position[u]] += rGraph.mEdgeWeights[i];
+                }
+                if (second == first)
+                    break;
+            }
+            for (size_t i = rowBegin; i < coarse.mAdjacency.size(); ++i)
+                position[coarse.mAdjacency[i]] = -1;
+            coarse.mOffsets.push_back(coarse.mAdjacency.size());
+        }
+        return coarse;
+    }
+
+    //! @brief Best of several greedy graph growing bisections, each refined by FM
+    std::vector<int> InitialBisection(const Graph& rGraph, const long target[2])
+    {
+        const int n = rGraph.size();
+        std::vector<int> best;
+        long bestCut = 0;
+        long bestViolation = 0;
+
+        std::uniform_int_distribution<int> randomVertex(0, std::max(0, n - 1));
+        for (int trial = 0; trial < mOptions.mNumInitialTrials; ++trial)
+        {
+            // grow side 0 from a random seed, always adding the vertex that increases the cut least
+            std::vector<int> side(n, 1);
+            std::vector<int> gain(n, 0);
+            GainQueue queue;
+            long weight0 = 0;
+            while (weight0 < target[0])
+            {
+                int v = queue.Top([&](int u, int g) { return side[u] == 1 and gain[u] == g; });
+                if (v == -1)
+                {
+                    // start a new region, also used if the graph is not connected
+                    const int start = randomVertex(mRandom);
+                    for (int i = 0; i < n and v == -1; ++i)
+                        if (side[(start + i) % n] == 1)
+                            v = (start + i) % n;
+                }
+                if (v == -1 or weight0 + rGraph.mVertexWeights[v] / 2 > target[0])
+                    break;
+
+                side[v] = 0;
+                weight0 += rGraph.mVertexWeights[v];
+                for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                {
+                    const int u = rGraph.mAdjacency[i];
+                    if (side[u] == 1)
+                    {
+                        gain[u] += 2 * rGraph.mEdgeWeights[i];
+                        queue.Push(u, gain[u]);
+                    }
+                }
+            }
+
+            Refine(rGraph, target, side);
+
+            const long cut = EdgeCut(rGraph, side);
+            const long violation = Violation(rGraph, target, side);
+            if (best.empty() or violation < bestViolation or (violation == bestViolation and cut < bestCut))
+            {
+                best = side;
+                bestCut = cut;
+                bestViolation = violation;
+            }
+        }
+        return best;
+    }
+
+    //! @brief Largest allowed weight of each side
+    void MaxWeights(const Graph& rGraph, const long target[2], long maxWeight[2]) const
+    {
+        const long maxVertexWeight = *std::max_element(rGraph.mVertexWeights.begin(), rGraph.mVertexWeights.end());
+        for (int s = 0; s < 2; ++s)
+            maxWeight[s] = std::max<long>(mBisectionImbalance * target[s], target[s] + maxVertexWeight);
+    }
+
+    //! @brief Weight by which the sides exceed their allowed weight
+    long Violation(const Graph& rGraph, const long target[2], const std::vector<int>& rSide) const
+    {
+        long maxWeight[2];
+        MaxWeights(rGraph, target, maxWeight);
+        long weight[2] = {0, 0};
+        for (int v = 0; v < rGraph.size(); ++v)
+            weight[rSide[v]] += rGraph.mVertexWeights[v];
+        return std::max(0L, weight[0] - maxWeight[0]) + std::max(0L, weight[1] - maxWeight[1]);
+    }
+
+    //! @brief Fiduccia-Mattheyses refinement of a bisection
+    //!
+    //! Every pass moves boundary vertices one by one to the other side, always the one of highest gain whose
+    //! move keeps the balance, and locks it, until no vertex can be moved. Moves that increase the cut are
+    //! allowed, which lets the pass climb out of local minima. Afterwards the pass is rolled back to the best
+    //! balanced state it went through.
+    void Refine(const Graph& rGraph, const long target[2], std::vector<int>& rSide)
+    {
+        const int n = rGraph.size();
+        if (n == 0)
+            return;
+
+        long maxWeight[2];
+        MaxWeights(rGraph, target, maxWeight);
+
+        std::vector<int> gain(n);
+        std::vector<char> locked(n);
+        std::vector<int> moves;
+
+        for (int pass = 0; pass < mOptions.mNumRefinementPasses; ++pass)
+        {
+            long weight[2] = {0, 0};
+            long cut = 0;
+            GainQueue queues[2];
+            for (int v = 0; v < n; ++v)
+            {
+                weight[rSide[v]] += rGraph.mVertexWeights[v];
+                int external = 0;
+                int internal = 0;
+                for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                    (rSide[rGraph.mAdjacency[i]] == rSide[v] ? internal : external) += rGraph.mEdgeWeights[i];
+                gain[v] = external - internal;
+                cut += external;
+                if (external > 0)
+                    queues[rSide[v]].Push(v, gain[v]);
+            }
+            cut /= 2;
+            std::fill(locked.begin(), locked.end(), 0);
+
+            auto violation = [&]() {
+                return std::max(0L, weight[0] - maxWeight[0]) + std::max(0L, weight[1] - maxWeight[1]);
+            };
+            auto topOf = [&](int s) {
+                return queues[s].Top([&](int v, int g) { return not locked[v] and gain[v] == g and rSide[v] == s; });
+            };
+
+            const long initialCut = cut;
+            const long initialViolation = violation();
+            long bestCut = cut;
+            long bestViolation = initialViolation;
+            const int maxNonImprovingMoves = std::max(2000, n / 100);
+            size_t bestNumMoves = 0;
+            moves.clear();
+
+            while (static_cast<int>(moves.size() - bestNumMoves) < maxNonImprovingMoves)
+            {
+                // an overweight side has to give vertices away, otherwise take the better feasible move
+                int from = -1;
+                for (int s = 0; s < 2; ++s)
+                    if (weight[s] > maxWeight[s])
+                        from = s;
+                if (from != -1 and topOf(from) == -1)
+                    for (int v = 0; v < n; ++v)
+                        if (rSide[v] == from and not locked[v])
+                            queues[from].Push(v, gain[v]);
+
+                int v = -1;
+                for (int s = 0; s < 2; ++s)
+                {
+                    if (from != -1 and s != from)
+                        continue;
+                    const int candidate = topOf(s);
+                    if (candidate == -1)
+                        continue;
+                    if (from == -1 and weight[1 - s] + rGraph.mVertexWeights[candidate] > maxWeight[1 - s])
+                        continue;
+                    if (v == -1 or gain[candidate] > gain[v])
+                        v = candidate;
+                }
+                if (v == -1)
+                    break;
+
+                const int s = rSide[v];
+                rSide[v] = 1 - s;
+                locked[v] = 1;
+                weight[s] -= rGraph.mVertexWeights[v];
+                weight[1 - s] += rGraph.mVertexWeights[v];
+                cut -= gain[v];
+                moves.push_back(v);
+
+                for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                {
+                    const int u = rGraph.mAdjacency[i];
+                    if (locked[u])
+                        continue;
+                    gain[u] += rSide[u] == s ? 2 * rGraph.mEdgeWeights[i] : -2 * rGraph.mEdgeWeights[i];
+                    queues[rSide[u]].Push(u, gain[u]);
+                }
+
+                const long currentViolation = violation();
+                if (currentViolation < bestViolation or (currentViolation == bestViolation and cut < bestCut))
+                {
+                    bestCut = cut;
+                    bestViolation = currentViolation;
+                    bestNumMoves = moves.size();
+                }
+            }
+
+            for (size_t i = moves.size(); i > bestNumMoves; --i)
+                rSide[moves[i - 1]] = 1 - rSide[moves[i - 1]];
+
+            if (bestCut == initialCut and bestViolation == initialViolation)
+                break;
+        }
+    }
+
+    //! @brief Subgraph induced by the vertices of \a side, \a rSubVertices receives their original numbers
+    static Graph SubGraph(const Graph& rGraph, const std::vector<int>& rSide, int side,
+                          const std::vector<int>& rVertices, std::vector<int>& rSubVertices)
+    {
+        std::vector<int> subVertex(rGraph.size(), -1);
+        for (int v = 0; v < rGraph.size(); ++v)
+            if (rSide[v] == side)
+            {
+                subVertex[v] = rSubVertices.size();
+                rSubVertices.push_back(rVertices[v]);
+            }
+
+        Graph subGraph;
+        subGraph.mOffsets.reserve(rSubVertices.size() + 1);
+        subGraph.mVertexWeights.reserve(rSubVertices.size());
+        for (int v = 0; v < rGraph.size(); ++v)
+        {
+            if (rSide[v] != side)
+                continue;
+            for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                if (subVertex[rGraph.mAdjacency[i]] != -1)
+                {
+                    subGraph.mAdjacency.push_back(subVertex[rGraph.mAdjacency[i]]);
+                    subGraph.mEdgeWeights.push_back(rGraph.mEdgeWeights[i]);
+                }
+            subGraph.mOffsets.push_back(subGraph.mAdjacency.size());
+            subGraph.mVertexWeights.push_back(rGraph.mVertexWeights[v]);
+        }
+        return subGraph;
+    }
+
+    //! @brief Keeps the heaviest component of every part, the other components join their best connected neighbour
+    static void MakePartsConnected(const Graph& rGraph, int numParts, std::vector<int>& rPartition)
+    {
+        const int n = rGraph.size();
+        std::vector<int> component(n, -1);
+        std::vector<long> componentWeight;
+        std::vector<int> componentPart;
+        std::vector<int> stack;
+        for (int start = 0; start < n; ++start)
+        {
+            if (component[start] != -1)
+                continue;
+            const int c = componentWeight.size();
+            componentWeight.push_back(0);
+            componentPart.push_back(rPartition[start]);
+            component[start] = c;
+            stack.push_back(start);
+            while (not stack.empty())
+            {
+                const int v = stack.back();
+                stack.pop_back();
+                componentWeight[c] += rGraph.mVertexWeights[v];
+                for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                {
+                    const int u = rGraph.mAdjacency[i];
+                    if (component[u] == -1 and rPartition[u] == rPartition[v])
+                    {
+                        component[u] = c;
+                        stack.push_back(u);
+                    }
+                }
+            }
+        }
+
+        std::vector<int> mainComponent(numParts, -1);
+        for (size_t c = 0; c < componentWeight.size(); ++c)
+        {
+            int& main = mainComponent[componentPart[c]];
+            if (main == -1 or componentWeight[c] > componentWeight[main])
+                main = c;
+        }
+
+        // pieces are moved to the part they share the most edge weight with, isolated pieces stay
+        std::vector<long> connection(numParts, 0);
+        for (size_t c = 0; c < componentWeight.size(); ++c)
+        {
+            if (mainComponent[componentPart[c]] == static_cast<int>(c))
+                continue;
+            std::fill(connection.begin(), connection.end(), 0);
+            for (int v = 0; v < n; ++v)
+                if (component[v] == static_cast<int>(c))
+                    for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                        if (rPartition[rGraph.mAdjacency[i]] != componentPart[c])
+                            connection[rPartition[rGraph.mAdjacency[i]]] += rGraph.mEdgeWeights[i];
+            const int newPart = std::max_element(connection.begin(), connection.end()) - connection.begin();
+            if (connection[newPart] == 0)
+                continue;
+            for (int v = 0; v < n; ++v)
+                if (component[v] == static_cast<int>(c))
+                    rPartition[v] = newPart;
+        }
+    }
+
+    PartitionOptions mOptions;
+    std::mt19937 mRandom;
+    double mBisectionImbalance = 1.;
+};
+
+
+//! @brief FETI interface between two subdomains, one Lagrange multiplier per node
+struct SubdomainInterface
+{
+    int mMaster; //!< lower subdomain number
+    int mSlave; //!< higher subdomain number
+    int mGlobalStartId; //!< global id of the multiplier of the first node
+    std::vector<int> mNodeIds; //!< sorted
+};
+
+
+//! @brief Writes the subdomains of a partitioned mesh in the JSON format read by ImportMeshJson
+//!
+//! Every pair of subdomains sharing nodes gets an interface, a node shared by more than two subdomains belongs
+//! to all their pairwise interfaces. Subdomain numbers start at 0, in the files master and slave are counted
+//! from 1 like in the files written by the gmsh reader. The master side of an interface has the value 1, the
+//! slave side -1.
+class SubdomainWriter
+{
+public:
+    SubdomainWriter(const ImportContainer& rMesh, std::vector<int> partition, int numSubdomains,
+                    std::map<int, std::string> physicalNames = std::map<int, std::string>())
+        : mMesh(rMesh)
+        , mPartition(std::move(partition))
+        , mNumSubdomains(numSubdomains)
+        , mPhysicalNames(std::move(physicalNames))
+        , mNodeIndices(NodeIndices(rMesh))
+    {
+        const ElementBlock& elements = mMesh.mElementList;
+        if (mPartition.size() != elements.size())
+            throw std::runtime_error("The partition does not match the number of elements");
+        for (const int subdomain : mPartition)
+            if (subdomain < 0 or subdomain >= mNumSubdomains)
+                throw std::runtime_error("Subdomain "s + std::to_string(subdomain) + " out of range");
+
+        // (node, subdomain) pairs, each node once per subdomain
+        std::vector<std::pair<int, int>> nodeSubdomains;
+        nodeSubdomains.reserve(elements.mNodeIds.size());
+        for (size_t element = 0; element < elements.size(); ++element)
+            for (const int nodeId : elements.NodeIds(element))
+                nodeSubdomains.emplace_back(nodeId, mPartition[element]);
+        std::sort(nodeSubdomains.begin(), nodeSubdomains.end());
+        nodeSubdomains.erase(std::unique(nodeSubdomains.begin(), nodeSubdomains.end()), nodeSubdomains.end());
+
+        // (master, slave, node) for every pair of subdomains of a node
+        std::vector<std::array<int, 3>> interfaceNodes;
+        for (size_t begin = 0, end = 0; begin < nodeSubdomains.size(); begin = end)
+        {
+            while (end < nodeSubdomains.size() and nodeSubdomains[end].first == nodeSubdomains[begin].first)
+                ++end;
+            for (size_t i = begin; i < end; ++i)
+                for (size_t j = i + 1; j < end; ++j)
+                    interfaceNodes.push_back(
+                            {{nodeSubdomains[i].second, nodeSubdomains[j].second, nodeSubdomains[i].first}});
+        }
+        std::sort(interfaceNodes.begin(), interfaceNodes.end());
+
+        for (const auto& node : interfaceNodes)
+        {
+            if (mInterfaces.empty() or mInterfaces.back().mMaster != node[0] or mInterfaces.back().mSlave != node[1])
+                mInterfaces.push_back({node[0], node[1], static_cast<int>(interfaceNodes.size()), {}});
+            mInterfaces.back().mNodeIds.push_back(node[2]);
+        }
+        int globalStartId = 0;
+        for (auto& interface : mInterfaces)
+        {
+            interface.mGlobalStartId = globalStartId;
+            globalStartId += interface.mNodeIds.size();
+        }
+    }
+
+    const std::vector<SubdomainInterface>& Interfaces() const
+    {
+        return mInterfaces;
+    }
+
+    //! @brief Total number of Lagrange multipliers
+    int NumInterfaceNodes() const
+    {
+        return mInterfaces.empty() ? 0 : mInterfaces.back().mGlobalStartId + mInterfaces.back().mNodeIds.size();
+    }
+
+    void Write(int subdomain, const std::string& rFileName) const
+    {
+        std::ofstream file(rFileName);
+        if (not file)
+            throw std::runtime_error("Could not write the subdomain mesh "s + rFileName);
+        Write(subdomain, file);
+        if (not file)
+            throw std::runtime_error("Could not write the subdomain mesh "s + rFileName);
+    }
+
+    void Write(int subdomain, std::ostream& rOut) const
+    {
+        const ElementBlock& elements = mMesh.mElementList;
+
+        // elements grouped by physical group and type
+        std::vector<int> subdomainElements;
+        for (size_t element = 0; element < elements.size(); ++element)
+            if (mPartition[element] == subdomain)
+                subdomainElements.push_back(element);
+        std::stable_sort(subdomainElements.begin(), subdomainElements.end(), [&](int a, int b) {
+            return std::make_pair(elements.mPhysicalGroups[a], elements.mTypes[a]) <
+                   std::make_pair(elements.mPhysicalGroups[b], elements.mTypes[b]);
+        });
+
+        std::vector<int> nodeIds;
+        for (const int element : subdomainElements)
+            nodeIds.insert(nodeIds.end(), elements.NodeIds(element).begin(), elements.NodeIds(element).end());
+        std::sort(nodeIds.begin(), nodeIds.end());
+        nodeIds.erase(std::unique(nodeIds.begin(), nodeIds.end()), nodeIds.end());
+
+        rOut << std::setprecision(17);
+        rOut << "{\n   \"Elements\" : [";
+        for (size_t begin = 0, end = 0; begin < subdomainElements.size(); begin = end)
+        {
+            const int group = elements.mPhysicalGroups[subdomainElements[begin]];
+            const eElementType type = elements.mTypes[subdomainElements[begin]];
+            while (end < subdomainElements.size() and elements.mPhysicalGroups[subdomainElements[end]] == group and
+                   elements.mTypes[subdomainElements[end]] == type)
+                ++end;
+
+            const auto name = mPhysicalNames.find(group);
+            rOut << (begin == 0 ? "\n" : ",\n") << "      {\n         \"Indices\" : [";
+            for (size_t i = begin; i < end; ++i)
+                rOut << (i == begin ? "" : ", ") << elements.mIds[subdomainElements[i]];
+            rOut << "],\n         \"Name\" : \"" << (name == mPhysicalNames.end() ? "" : name->second) << "\",\n"
+                 << "         \"NodalConnectivity\" : [";
+            for (size_t i = begin; i < end; ++i)
+            {
+                rOut << (i == begin ? "\n" : ",\n") << "            ";
+                WriteArray(rOut, elements.NodeIds(subdomainElements[i]).begin(),
+                           elements.NodeIds(subdomainElements[i]).end());
+            }
+            rOut << "\n         ],\n         \"Type\" : " << GmshElementType(type) << "\n      }";
+        }
+        rOut << "\n   ],\n   \"Interface\" : [";
+
+        bool first = true;
+        for (const auto& interface : mInterfaces)
+        {
+            if (interface.mMaster != subdomain and interface.mSlave != subdomain)
+                continue;
+            rOut << (first ? "\n" : ",\n") << "      {\n"
+                 << "         \"GlobalStartId\" : [" << interface.mGlobalStartId << "],\n"
+                 << "         \"Master\" : [" << interface.mMaster + 1 << "],\n"
+                 << "         \"NodeIds\" : [";
+            WriteArray(rOut, interface.mNodeIds.begin(), interface.mNodeIds.end());
+            rOut << "],\n"
+                 << "         \"Slave\" : [" << interface.mSlave + 1 << "],\n"
+                 << "         \"Value\" : [" << (interface.mMaster == subdomain ? 1 : -1) << "]\n      }";
+            first = false;
+        }
+
+        rOut << "\n   ],\n   \"LocalToGlobalMap\" : ";
+        WriteArray(rOut, nodeIds.begin(), nodeIds.end());
+        rOut << ",\n   \"Nodes\" : [\n      {\n         \"Coordinates\" : [";
+        for (size_t i = 0; i < nodeIds.size(); ++i)
+        {
+            const Eigen::Vector3d& coordinates = mMesh.mNodeList[mNodeIndices.at(nodeIds[i])].mCoordinates;
+            rOut << (i == 0 ? "\n" : ",\n") << "            [" << coordinates[0] << ", " << coordinates[1] << ", "
+                 << coordinates[2] << "]";
+        }
+        rOut << "\n         ],\n         \"Indices\" : ";
+        WriteArray(rOut, nodeIds.begin(), nodeIds.end());
+        rOut << "\n      }\n   ],\n   \"NumInterfaceNodes\" : [" << NumInterfaceNodes() << "]\n}\n";
+    }
+
+private:
+    template <typename Iterator>
+    static void WriteArray(std::ostream& rOut, Iterator begin, Iterator end)
+    {
+        rOut << "[";
+        for (Iterator it = begin; it != end; ++it)
+            rOut << (it == begin ? "" : ", ") << *it;
+        rOut << "]";
+    }
+
+    const ImportContainer& mMesh;
+    std::vector<int> mPartition;
+    int mNumSubdomains;
+    std::map<int, std::string> mPhysicalNames;
+    FlatIdMap mNodeIndices;
+    std::vector<SubdomainInterface> mInterfaces;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Sparse>
+
+namespace Eigen
+{
+
+/** \brief Sparse direct solver with the factorization stored in low precision and refined in double precision
+  *
+  * Drop-in replacement for the \c EigenSolver of \c NuTo::NewmarkFeti and \c NuTo::SolverEigen. The matrix is
+  * kept in double precision, the factors of \a _LowPrecisionSolver, e.g.
+  * \c SparseLU<SparseMatrix<float>>, in low precision. That halves the factor storage and the memory traffic of
+  * the forward and backward substitutions. The full double copy of A for the residuals stays, so the total
+  * memory shrinks by less than half. Each solve is followed by iterative refinement with the double precision
+  * residual until \c tolerance() is reached, so the results keep double precision accuracy as long as the matrix
+  * is not too ill conditioned for the low precision factorization. Otherwise the refinement stops after
+  * \c maxRefinements() steps, and \c info() reports \c NoConvergence until the next factorization or a solve that
+  * reaches the tolerance again. \c error() is the worst relative residual of the last solve.
+  */
+template <typename _LowPrecisionSolver>
+class MixedPrecisionSolver
+{
+public:
+    typedef _LowPrecisionSolver LowPrecisionSolver;
+    typedef typename LowPrecisionSolver::MatrixType LowMatrixType;
+    typedef typename LowMatrixType::Scalar LowScalar;
+    typedef double Scalar;
+    typedef SparseMatrix<Scalar> MatrixType;
+    typedef typename MatrixType::Index Index;
+
+    MixedPrecisionSolver()
+        : m_tolerance(1.e-12)
+        , m_maxRefinements(10)
+        , m_info(Success)
+        , m_error(0)
+    {
+    }
+
+    explicit MixedPrecisionSolver(const MatrixType& A)
+        : MixedPrecisionSolver()
+    {
+        compute(A);
+    }
+
+    void analyzePattern(const MatrixType& A)
+    {
+        m_lowPrecisionSolver.analyzePattern(A.template cast<LowScalar>());
+        m_info = Success;
+    }
+
+    void factorize(const MatrixType& A)
+    {
+        m_matrix = A;
+        m_lowPrecisionSolver.factorize(m_matrix.template cast<LowScalar>());
+        m_info = m_lowPrecisionSolver.info();
+        m_error = 0;
+    }
+
+    MixedPrecisionSolver& compute(const MatrixType& A)
+    {
+        analyzePattern(A);
+        factorize(A);
+        return *this;
+    }
+
+    /** Solves for each column of \a b, refining until the relative residual drops below tolerance() */
+    template <typename Rhs>
+    Matrix<Scalar, Dynamic, Rhs::ColsAtCompileTime> solve(const MatrixBase<Rhs>& b) const
+    {
+        typedef Matrix<Scalar, Dynamic, 1> VectorType;
+        typedef Matrix<LowScalar, Dynamic, 1> LowVectorType;
+
+        Matrix<Scalar, Dynamic, Rhs::ColsAtCompileTime> x(b.rows(), b.cols());
+        m_error = 0;
+        for (Index j = 0; j < b.cols(); ++j)
+        {
+            const VectorType bj = b.col(j);
+            const Scalar bNorm = bj.norm();
+            if (bNorm == 0)
+            {
+                x.col(j).setZero();
+                continue;
+            }
+
+            VectorType xj = VectorType::Zero(bj.rows());
+            VectorType residual = bj;
+            for (int refinement = 0; refinement <= m_maxRefinements; ++refinement)
+            {
+                const Scalar residualNorm = residual.norm();
+                if (residualNorm <= m_tolerance * bNorm)
+                    break;
+
+                // scale to unit norm, the correction must not under- or overflow in low precision
+                const LowVectorType residualLow = (residual / residualNorm).template cast<LowScalar>();
+                const LowVectorType correction = m_lowPrecisionSolver.solve(residualLow);
+                xj += residualNorm * correction.template cast<Scalar>();
+                residual = bj - m_matrix * xj;
+            }
+            x.col(j) = xj;
+
+            // written such that a NaN residual counts as not converged
+            const Scalar error = residual.norm() / bNorm;
+            if (not(error <= m_error))
+                m_error = error;
+        }
+        return x;
+    }
+
+    /** NoConvergence if the last solve did not reach tolerance() for every column */
+    ComputationInfo info() const
+    {
+        if (m_info != Success)
+            return m_info;
+        return m_error <= m_tolerance ? Success : NoConvergence;
+    }
+
+    /** Worst relative residual over the columns of the last solve */
+    Scalar error() const
+    {
+        return m_error;
+    }
+
+    Index rows() const
+    {
+        return m_matrix.rows();
+    }
+
+    Index cols() const
+    {
+        return m_matrix.cols();
+    }
+
+    /** Relative residual at which the refinement stops */
+    MixedPrecisionSolver& setTolerance(Scalar tolerance)
+    {
+        m_tolerance = tolerance;
+        return *this;
+    }
+
+    Scalar tolerance() const
+    {
+        return m_tolerance;
+    }
+
+    MixedPrecisionSolver& setMaxRefinements(int maxRefinements)
+    {
+        m_maxRefinements = maxRefinements;
+        return *this;
+    }
+
+    int maxRefinements() const
+    {
+        return m_maxRefinements;
+    }
+
+protected:
+    LowPrecisionSolver m_lowPrecisionSolver;
+    MatrixType m_matrix;
+    Scalar m_tolerance;
+    int m_maxRefinements;
+    ComputationInfo m_info; //!< of the factorization
+    mutable Scalar m_error;
+};
+
+} // end namespace Eigen
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include "Repartitioning.h"
+
+
+//! @brief Sends the state of every local element to its new rank, returns the state of the elements owned now
+//!
+//! \a rNewRank holds the new rank of each element of \a rLocal. The received elements are ordered by the rank
+//! they come from, elements staying on this rank come first in their old order. Two MPI_Alltoallv exchange the
+//! ids and the values, every rank has to call it.
+ElementState MigrateElementState(const ElementState& rLocal, const std::vector<int>& rNewRank,
+                                 MPI_Comm communicator = MPI_COMM_WORLD)
+{
+    int rank = 0;
+    int numRanks = 1;
+    MPI_Comm_rank(communicator, &rank);
+    MPI_Comm_size(communicator, &numRanks);
+
+    // own rank first, the remaining ones in increasing order
+    std::vector<int> sendCounts(numRanks, 0);
+    for (const int newRank : rNewRank)
+        ++sendCounts[newRank];
+    std::vector<int> sendOffsets(numRanks, 0);
+    for (int i = 1, target = (rank + 1) % numRanks, previous = rank; i < numRanks; ++i)
+    {
+        sendOffsets[target] = sendOffsets[previous] + sendCounts[previous];
+        previous = target;
+        target = (target + 1) % numRanks;
+    }
+
+    const int n = rLocal.mValuesPerElement;
+    std::vector<int> sendIds(rLocal.size());
+    std::vector<double> sendValues(rLocal.mValues.size());
+    {
+        std::vector<int> position = sendOffsets;
+        for (size_t i = 0; i < rLocal.size(); ++i)
+        {
+            const int j = position[rNewRank[i]]++;
+            sendIds[j] = rLocal.mIds[i];
+            std::copy_n(rLocal.mValues.data() + i * n, n, sendValues.data() + j * n);
+        }
+    }
+
+    std::vector<int> receiveCounts(numRanks);
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, receiveCounts.data(), 1, MPI_INT, communicator);
+    std::vector<int> receiveOffsets(numRanks, 0);
+    for (int i = 1, source = (rank + 1) % numRanks, previous = rank; i < numRanks; ++i)
+    {
+        receiveOffsets[source] = receiveOffsets[previous] + receiveCounts[previous];
+        previous = source;
+        source = (source + 1) % numRanks;
+    }
+
+    ElementState received;
+    received.mValuesPerElement = n;
+    received.mIds.resize(std::accumulate(receiveCounts.begin(), receiveCounts.end(), 0));
+    received.mValues.resize(received.mIds.size() * n);
+    MPI_Alltoallv(sendIds.data(), sendCounts.data(), sendOffsets.data(), MPI_INT, received.mIds.data(),
+                  receiveCounts.data(), receiveOffsets.data(), MPI_INT, communicator);
+
+    for (int i = 0; i < numRanks; ++i)
+    {
+        sendCounts[i] *= n;
+        sendOffsets[i] *= n;
+        receiveCounts[i] *= n;
+        receiveOffsets[i] *= n;
+    }
+    MPI_Alltoallv(sendValues.data(), sendCounts.data(), sendOffsets.data(), MPI_DOUBLE, received.mValues.data(),
+                  receiveCounts.data(), receiveOffsets.data(), MPI_DOUBLE, communicator);
+    return received;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <mpi.h>
+
+namespace Eigen
+{
+
+/** \brief Non-blocking global sum of the local dot products of the pipelined projected CG
+  *
+  * \c start posts an in-place \c MPI_Iallreduce, \c wait completes it. In between, the solver applies the
+  * operator and the preconditioner, which hides the latency of the reduction.
+  */
+class MpiNonBlockingSum
+{
+public:
+    explicit MpiNonBlockingSum(MPI_Comm communicator = MPI_COMM_WORLD)
+        : m_communicator(communicator)
+        , m_request(MPI_REQUEST_NULL)
+    {
+    }
+
+    void start(double* values, int count)
+    {
+        MPI_Iallreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM, m_communicator, &m_request);
+    }
+
+    void wait()
+    {
+        MPI_Wait(&m_request, MPI_STATUS_IGNORE);
+    }
+
+protected:
+    MPI_Comm m_communicator;
+    MPI_Request m_request;
+};
+
+} // end namespace Eigen
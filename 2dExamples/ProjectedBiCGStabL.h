@@ -0,0 +1,343 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
+#include "../IterationObserver.h"
+
+namespace Eigen
+{
+
+namespace internal
+{
+
+/** \internal Low-level projected BiCGStab(l) algorithm (Sleijpen and Fokkema)
+  *
+  * Replaces the one dimensional minimal residual step of BiCGStab by a polynomial of degree l, which avoids the
+  * stagnation of BiCGStab for operators with strongly complex eigenvalues. The algorithm iterates on the right
+  * preconditioned system A P M⁻¹ y = r0 and recovers x = x0 + P M⁻¹ y at the end.
+  *
+  * \param mat The matrix A, or any linear operator providing \c cols() and \c operator*
+  * \param rhs The right hand side vector b
+  * \param x On input and initial solution, on output the computed solution.
+  * \param projectionMatrix The projection P, assembled or as a linear operator
+  * \param precond A preconditioner being able to efficiently solve for an
+  *                approximation of Ax=b (regardless of b)
+  * \param iters On input the max number of operator applications, on output the number of performed ones.
+  * \param tol_error On input the tolerance error, on output an estimation of the relative error.
+  * \param l Degree of the minimal residual polynomial, 2l operator applications per cycle
+  * \param observer If given, is notified about every iteration and the time spent in each phase
+  */
+template <typename MatrixType, typename ProjectionType, typename Rhs, typename Dest, typename Preconditioner>
+EIGEN_DONT_INLINE void projected_bicgstabl(const MatrixType& mat, const Rhs& rhs, Dest& x,
+                                           const ProjectionType& projectionMatrix, const Preconditioner& precond,
+                                           int& iters, typename Dest::RealScalar& tol_error, int l = 2,
+                                           NuTo::IterationObserver* observer = 0)
+{
+    using std::sqrt;
+    typedef typename Dest::RealScalar RealScalar;
+    typedef typename Dest::Scalar Scalar;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+    typedef Matrix<Scalar, Dynamic, Dynamic> DenseMatrixType;
+
+    RealScalar tol = tol_error;
+    int maxIters = iters;
+
+    int n = mat.cols();
+    l = std::max(1, l);
+
+    VectorType r0 = rhs - mat * x; // initial residual
+
+    RealScalar rhsNorm2 = rhs.squaredNorm();
+    if (rhsNorm2 == 0)
+    {
+        x.setZero();
+        iters = 0;
+        tol_error = 0;
+        return;
+    }
+    RealScalar threshold = tol * tol * rhsNorm2;
+    RealScalar residualNorm2 = r0.squaredNorm();
+    if (residualNorm2 < threshold)
+    {
+        iters = 0;
+        tol_error = sqrt(residualNorm2 / rhsNorm2);
+        return;
+    }
+
+    if (observer)
+        observer->StartSolve();
+
+    // application of the preconditioned operator A P M⁻¹
+    auto applyOperator = [&](const VectorType& v) -> VectorType {
+        VectorType t;
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+            t = precond.solve(v);
+        }
+        VectorType pt;
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+            pt = projectionMatrix * t;
+        }
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+        return mat * pt;
+    };
+
+    const VectorType shadow = r0;
+    DenseMatrixType r = DenseMatrixType::Zero(n, l + 1); // residuals r̂_0 .. r̂_l
+    DenseMatrixType u = DenseMatrixType::Zero(n, l + 1); // search directions û_0 .. û_l
+    r.col(0) = r0;
+    VectorType y = VectorType::Zero(n);
+
+    DenseMatrixType tau = DenseMatrixType::Zero(l + 1, l + 1);
+    VectorType sigma(l + 1), gamma(l + 1), gammaPrime(l + 1), gammaDoublePrime(l + 1);
+
+    Scalar rho0 = 1, alpha = 0, omega = 1;
+
+    int i = 0;
+    bool converged = false;
+    bool breakdown = false;
+    while (not converged and not breakdown and i < maxIters)
+    {
+        rho0 = -omega * rho0;
+
+        // BiCG part
+        for (int j = 0; j < l; ++j)
+        {
+            Scalar rho1;
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+                rho1 = r.col(j).dot(shadow);
+            }
+            if (rho0 == Scalar(0))
+            {
+                breakdown = true;
+                break;
+            }
+            const Scalar beta = alpha * rho1 / rho0;
+            rho0 = rho1;
+            for (int k = 0; k <= j; ++k)
+                u.col(k) = r.col(k) - beta * u.col(k);
+            u.col(j + 1) = applyOperator(u.col(j));
+            ++i;
+
+            Scalar gammaBiCG;
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+                gammaBiCG = u.col(j + 1).dot(shadow);
+            }
+            if (gammaBiCG == Scalar(0))
+            {
+                breakdown = true;
+                break;
+            }
+            alpha = rho0 / gammaBiCG;
+            for (int k = 0; k <= j; ++k)
+                r.col(k) -= alpha * u.col(k + 1);
+            r.col(j + 1) = applyOperator(r.col(j));
+            ++i;
+            y += alpha * u.col(0);
+
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+                residualNorm2 = r.col(0).squaredNorm();
+            }
+            converged = residualNorm2 < threshold;
+            // the last step of a cycle is reported with the residual after the MR update
+            if (observer and (converged or j + 1 < l))
+                observer->Iteration(i, sqrt(residualNorm2 / rhsNorm2));
+            if (converged)
+                break;
+        }
+        if (converged or breakdown)
+            break;
+
+        // MR part, modified Gram-Schmidt on the residuals r̂_1 .. r̂_l
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            for (int j = 1; j <= l; ++j)
+            {
+                for (int k = 1; k < j; ++k)
+                {
+                    tau(k, j) = r.col(j).dot(r.col(k)) / sigma[k];
+                    r.col(j) -= tau(k, j) * r.col(k);
+                }
+                sigma[j] = r.col(j).squaredNorm();
+                if (sigma[j] == Scalar(0))
+                {
+                    breakdown = true;
+                    break;
+                }
+                gammaPrime[j] = r.col(0).dot(r.col(j)) / sigma[j];
+            }
+        }
+        if (breakdown)
+        {
+            if (observer)
+                observer->Iteration(i, sqrt(residualNorm2 / rhsNorm2));
+            break;
+        }
+
+        gamma[l] = gammaPrime[l];
+        omega = gamma[l];
+        for (int j = l - 1; j >= 1; --j)
+        {
+            gamma[j] = gammaPrime[j];
+            for (int k = j + 1; k <= l; ++k)
+                gamma[j] -= tau(j, k) * gamma[k];
+        }
+        for (int j = 1; j < l; ++j)
+        {
+            gammaDoublePrime[j] = gamma[j + 1];
+            for (int k = j + 1; k < l; ++k)
+                gammaDoublePrime[j] += tau(j, k) * gamma[k + 1];
+        }
+
+        y += gamma[1] * r.col(0);
+        r.col(0) -= gammaPrime[l] * r.col(l);
+        u.col(0) -= gamma[l] * u.col(l);
+        for (int j = 1; j < l; ++j)
+        {
+            u.col(0) -= gamma[j] * u.col(j);
+            y += gammaDoublePrime[j] * r.col(j);
+            r.col(0) -= gammaPrime[j] * r.col(j);
+        }
+
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+            residualNorm2 = r.col(0).squaredNorm();
+        }
+        converged = residualNorm2 < threshold;
+        if (observer)
+            observer->Iteration(i, sqrt(residualNorm2 / rhsNorm2));
+    }
+
+    // x = x0 + P M⁻¹ y
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+        r0 = precond.solve(y);
+    }
+    {
+        NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+        x += projectionMatrix * r0;
+    }
+
+    tol_error = sqrt(residualNorm2 / rhsNorm2);
+    iters = i;
+}
+}
+
+
+template <typename _MatrixType, typename _Preconditioner = DiagonalPreconditioner<typename _MatrixType::Scalar>>
+class ProjectedBiCGStabL;
+
+namespace internal
+{
+
+template <typename _MatrixType, typename _Preconditioner>
+struct traits<ProjectedBiCGStabL<_MatrixType, _Preconditioner>>
+{
+    typedef _MatrixType MatrixType;
+    typedef _Preconditioner Preconditioner;
+};
+}
+
+
+/** \brief Projected BiCGStab(l) solver for non-symmetric systems, e.g. phase-field tangents
+  *
+  * Used like ConjugateProjectedGradient. l = 2 is usually enough to cure the stagnation of BiCGStab, l = 1 is
+  * BiCGStab. iterations() counts operator applications.
+  */
+template <typename _MatrixType, typename _Preconditioner>
+class ProjectedBiCGStabL : public IterativeSolverBase<ProjectedBiCGStabL<_MatrixType, _Preconditioner>>
+{
+    typedef IterativeSolverBase<ProjectedBiCGStabL> Base;
+    using Base::mp_matrix;
+    using Base::m_error;
+    using Base::m_iterations;
+    using Base::m_info;
+    using Base::m_isInitialized;
+
+public:
+    typedef _MatrixType MatrixType;
+    typedef typename MatrixType::Scalar Scalar;
+    typedef typename MatrixType::Index Index;
+    typedef typename MatrixType::RealScalar RealScalar;
+    typedef _Preconditioner Preconditioner;
+
+public:
+    /** Default constructor. */
+    ProjectedBiCGStabL()
+        : Base()
+        , m_l(2)
+        , m_observer(0)
+    {
+    }
+
+    /** Initialize the solver with matrix \a A for further \c Ax=b solving. */
+    ProjectedBiCGStabL(const MatrixType& A)
+        : Base(A)
+        , m_l(2)
+        , m_observer(0)
+    {
+    }
+
+    ~ProjectedBiCGStabL()
+    {
+    }
+
+    /** Sets the degree of the minimal residual polynomial, default 2 */
+    ProjectedBiCGStabL& setL(int l)
+    {
+        m_l = l;
+        return *this;
+    }
+
+    int l() const
+    {
+        return m_l;
+    }
+
+    /** Reports every iteration to \a observer, nullptr disables it */
+    ProjectedBiCGStabL& setIterationObserver(NuTo::IterationObserver* observer)
+    {
+        m_observer = observer;
+        return *this;
+    }
+
+    /** \internal */
+    template <typename Rhs, typename Dest, typename ProjectionType>
+    void _solveWithGuess(const Rhs& b, Dest& x, const ProjectionType& projection) const
+    {
+        solveWithOperator(*mp_matrix, b, x, projection);
+    }
+
+    /** Solves \c Ax=b with an operator \a op that does not have to be assembled, see
+      * ConjugateProjectedGradient::solveWithOperator */
+    template <typename OperatorType, typename ProjectionType, typename Rhs, typename Dest>
+    void solveWithOperator(const OperatorType& op, const Rhs& b, Dest& x, const ProjectionType& projection) const
+    {
+        const int maxIterations = Base::m_maxIterations < 0 ? 2 * op.cols() : Base::m_maxIterations;
+
+        for (int j = 0; j < b.cols(); ++j)
+        {
+            m_iterations = maxIterations;
+            m_error = Base::m_tolerance;
+
+            typename Dest::ColXpr xj(x, j);
+            internal::projected_bicgstabl(op, b.col(j), xj, projection, Base::m_preconditioner, m_iterations,
+                                          m_error, m_l, m_observer);
+        }
+
+        m_isInitialized = true;
+        m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+    }
+
+protected:
+    int m_l;
+    NuTo::IterationObserver* m_observer;
+};
+
+
+} // end namespace Eigen
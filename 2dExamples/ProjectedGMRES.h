@@ -0,0 +1,283 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
+#include "../IterationObserver.h"
+
+namespace Eigen
+{
+
+namespace internal
+{
+
+/** \internal Low-level projected, flexible and restarted GMRES algorithm
+  *
+  * Minimizes the projected residual P (b - A x) over x0 + range(P). The preconditioned basis vectors
+  * z_k = P M⁻¹ v_k are stored (flexible GMRES), so the preconditioner may change from one application to the
+  * next, e.g. an inner iterative solve. The Hessenberg least squares problem is updated with Givens rotations,
+  * which gives the residual norm of every iteration without additional operator applications.
+  *
+  * \param mat The matrix A, or any linear operator providing \c cols() and \c operator*
+  * \param rhs The right hand side vector b
+  * \param x On input and initial solution, on output the computed solution.
+  * \param projectionMatrix The projection P, assembled or as a linear operator
+  * \param precond A preconditioner being able to efficiently solve for an
+  *                approximation of Ax=b (regardless of b)
+  * \param iters On input the max number of iteration, on output the number of performed iterations.
+  * \param tol_error On input the tolerance error, on output an estimation of the relative error.
+  * \param restart Number of iterations after which the Krylov basis is discarded
+  * \param observer If given, is notified about every iteration and the time spent in each phase
+  */
+template <typename MatrixType, typename ProjectionType, typename Rhs, typename Dest, typename Preconditioner>
+EIGEN_DONT_INLINE void projected_fgmres(const MatrixType& mat, const Rhs& rhs, Dest& x,
+                                        const ProjectionType& projectionMatrix, const Preconditioner& precond,
+                                        int& iters, typename Dest::RealScalar& tol_error, int restart = 30,
+                                        NuTo::IterationObserver* observer = 0)
+{
+    using std::sqrt;
+    using std::abs;
+    typedef typename Dest::RealScalar RealScalar;
+    typedef typename Dest::Scalar Scalar;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+    typedef Matrix<Scalar, Dynamic, Dynamic> DenseMatrixType;
+
+    RealScalar tol = tol_error;
+    int maxIters = iters;
+
+    int n = mat.cols();
+    restart = std::max(1, std::min(restart, n));
+
+    VectorType residual = projectionMatrix * (rhs - mat * x); // initial residual
+
+    RealScalar rhsNorm2 = rhs.squaredNorm();
+    if (rhsNorm2 == 0)
+    {
+        x.setZero();
+        iters = 0;
+        tol_error = 0;
+        return;
+    }
+    RealScalar threshold = tol * tol * rhsNorm2;
+    RealScalar residualNorm2 = residual.squaredNorm();
+    if (residualNorm2 < threshold)
+    {
+        iters = 0;
+        tol_error = sqrt(residualNorm2 / rhsNorm2);
+        return;
+    }
+
+    if (observer)
+        observer->StartSolve();
+
+    DenseMatrixType V(n, restart + 1); // orthonormal Krylov basis
+    DenseMatrixType Z(n, restart); // preconditioned basis vectors
+    DenseMatrixType H = DenseMatrixType::Zero(restart + 1, restart); // Hessenberg matrix, reduced to R in place
+    VectorType cs(restart), sn(restart), g(restart + 1);
+    VectorType w(n), t(n);
+
+    int i = 0;
+    while (i < maxIters)
+    {
+        const RealScalar beta = sqrt(residualNorm2);
+        V.col(0) = residual / beta;
+        g.setZero();
+        g[0] = beta;
+
+        int k = 0;
+        while (k < restart and i < maxIters)
+        {
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+                t = precond.solve(V.col(k));
+            }
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+                Z.col(k) = projectionMatrix * t;
+            }
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+                t.noalias() = mat * Z.col(k);
+            }
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+                w = projectionMatrix * t;
+            }
+
+            // Arnoldi step with modified Gram-Schmidt
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Reduction);
+                for (int j = 0; j <= k; ++j)
+                {
+                    H(j, k) = V.col(j).dot(w);
+                    w -= H(j, k) * V.col(j);
+                }
+                H(k + 1, k) = w.norm();
+            }
+            const bool happyBreakdown = H(k + 1, k) == RealScalar(0);
+            if (not happyBreakdown)
+                V.col(k + 1) = w / H(k + 1, k);
+
+            // apply the previous rotations to the new column
+            for (int j = 0; j < k; ++j)
+            {
+                const Scalar tmp = cs[j] * H(j, k) + sn[j] * H(j + 1, k);
+                H(j + 1, k) = -sn[j] * H(j, k) + cs[j] * H(j + 1, k);
+                H(j, k) = tmp;
+            }
+
+            // eliminate H(k+1, k)
+            const RealScalar denominator = sqrt(H(k, k) * H(k, k) + H(k + 1, k) * H(k + 1, k));
+            cs[k] = H(k, k) / denominator;
+            sn[k] = H(k + 1, k) / denominator;
+            H(k, k) = denominator;
+            H(k + 1, k) = 0;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+
+            ++k;
+            ++i;
+
+            residualNorm2 = g[k] * g[k];
+            if (observer)
+                observer->Iteration(i, sqrt(residualNorm2 / rhsNorm2));
+            if (residualNorm2 < threshold or happyBreakdown)
+                break;
+        }
+
+        // x += Z y with R y = g
+        const VectorType y = H.topLeftCorner(k, k).template triangularView<Upper>().solve(g.head(k));
+        x += Z.leftCols(k) * y;
+
+        // recompute the residual, the estimate from the rotations drifts for long cycles
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+            t.noalias() = mat * x;
+        }
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+            residual = projectionMatrix * (rhs - t);
+        }
+        residualNorm2 = residual.squaredNorm();
+        if (residualNorm2 < threshold)
+            break;
+    }
+
+    tol_error = sqrt(residualNorm2 / rhsNorm2);
+    iters = i;
+}
+}
+
+
+template <typename _MatrixType, typename _Preconditioner = DiagonalPreconditioner<typename _MatrixType::Scalar>>
+class ProjectedGMRES;
+
+namespace internal
+{
+
+template <typename _MatrixType, typename _Preconditioner>
+struct traits<ProjectedGMRES<_MatrixType, _Preconditioner>>
+{
+    typedef _MatrixType MatrixType;
+    typedef _Preconditioner Preconditioner;
+};
+}
+
+
+/** \brief Projected flexible GMRES solver with restarts
+  *
+  * Used like ConjugateProjectedGradient, but does not require a symmetric operator. Every iteration stores two
+  * vectors, the memory therefore grows with the restart length (default 30).
+  */
+template <typename _MatrixType, typename _Preconditioner>
+class ProjectedGMRES : public IterativeSolverBase<ProjectedGMRES<_MatrixType, _Preconditioner>>
+{
+    typedef IterativeSolverBase<ProjectedGMRES> Base;
+    using Base::mp_matrix;
+    using Base::m_error;
+    using Base::m_iterations;
+    using Base::m_info;
+    using Base::m_isInitialized;
+
+public:
+    typedef _MatrixType MatrixType;
+    typedef typename MatrixType::Scalar Scalar;
+    typedef typename MatrixType::Index Index;
+    typedef typename MatrixType::RealScalar RealScalar;
+    typedef _Preconditioner Preconditioner;
+
+public:
+    /** Default constructor. */
+    ProjectedGMRES()
+        : Base()
+        , m_restart(30)
+        , m_observer(0)
+    {
+    }
+
+    /** Initialize the solver with matrix \a A for further \c Ax=b solving. */
+    ProjectedGMRES(const MatrixType& A)
+        : Base(A)
+        , m_restart(30)
+        , m_observer(0)
+    {
+    }
+
+    ~ProjectedGMRES()
+    {
+    }
+
+    /** Sets the number of iterations after which the solver restarts, default 30 */
+    ProjectedGMRES& setRestart(int restart)
+    {
+        m_restart = restart;
+        return *this;
+    }
+
+    int restart() const
+    {
+        return m_restart;
+    }
+
+    /** Reports every iteration to \a observer, nullptr disables it */
+    ProjectedGMRES& setIterationObserver(NuTo::IterationObserver* observer)
+    {
+        m_observer = observer;
+        return *this;
+    }
+
+    /** \internal */
+    template <typename Rhs, typename Dest, typename ProjectionType>
+    void _solveWithGuess(const Rhs& b, Dest& x, const ProjectionType& projection) const
+    {
+        solveWithOperator(*mp_matrix, b, x, projection);
+    }
+
+    /** Solves \c Ax=b with an operator \a op that does not have to be assembled, see
+      * ConjugateProjectedGradient::solveWithOperator */
+    template <typename OperatorType, typename ProjectionType, typename Rhs, typename Dest>
+    void solveWithOperator(const OperatorType& op, const Rhs& b, Dest& x, const ProjectionType& projection) const
+    {
+        const int maxIterations = Base::m_maxIterations < 0 ? 2 * op.cols() : Base::m_maxIterations;
+
+        for (int j = 0; j < b.cols(); ++j)
+        {
+            m_iterations = maxIterations;
+            m_error = Base::m_tolerance;
+
+            typename Dest::ColXpr xj(x, j);
+            internal::projected_fgmres(op, b.col(j), xj, projection, Base::m_preconditioner, m_iterations, m_error,
+                                       m_restart, m_observer);
+        }
+
+        m_isInitialized = true;
+        m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+    }
+
+protected:
+    int m_restart;
+    NuTo::IterationObserver* m_observer;
+};
+
+
+} // end namespace Eigen
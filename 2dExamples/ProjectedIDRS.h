@@ -0,0 +1,296 @@
+#pragma once
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Dense>
+#include <eigen3/Eigen/Sparse>
+#include "../IterationObserver.h"
+
+namespace Eigen
+{
+
+namespace internal
+{
+
+/** \internal Low-level projected IDR(s) algorithm with bi-orthogonalization (van Gijzen and Sonneveld)
+  *
+  * Solves non-symmetric systems with short recurrences. Each cycle of s+1 operator applications reduces the
+  * residual into a shrinking sequence of subspaces, which usually needs far fewer operator applications than
+  * BiCGStab (the special case s = 1). The preconditioner is applied from the right together with the
+  * projection, i.e. as P M⁻¹.
+  *
+  * \param mat The matrix A, or any linear operator providing \c cols() and \c operator*
+  * \param rhs The right hand side vector b
+  * \param x On input and initial solution, on output the computed solution.
+  * \param projectionMatrix The projection P, assembled or as a linear operator
+  * \param precond A preconditioner being able to efficiently solve for an
+  *                approximation of Ax=b (regardless of b)
+  * \param iters On input the max number of operator applications, on output the number of performed ones.
+  * \param tol_error On input the tolerance error, on output an estimation of the relative error.
+  * \param s Dimension of the shadow space
+  * \param observer If given, is notified about every iteration and the time spent in each phase
+  */
+template <typename MatrixType, typename ProjectionType, typename Rhs, typename Dest, typename Preconditioner>
+EIGEN_DONT_INLINE void projected_idrs(const MatrixType& mat, const Rhs& rhs, Dest& x,
+                                      const ProjectionType& projectionMatrix, const Preconditioner& precond,
+                                      int& iters, typename Dest::RealScalar& tol_error, int s = 4,
+                                      NuTo::IterationObserver* observer = 0)
+{
+    using std::sqrt;
+    using std::abs;
+    typedef typename Dest::RealScalar RealScalar;
+    typedef typename Dest::Scalar Scalar;
+    typedef Matrix<Scalar, Dynamic, 1> VectorType;
+    typedef Matrix<Scalar, Dynamic, Dynamic> DenseMatrixType;
+
+    const RealScalar kappa = 0.7; // minimal angle for the residual reduction step
+
+    RealScalar tol = tol_error;
+    int maxIters = iters;
+
+    int n = mat.cols();
+    s = std::max(1, std::min(s, n));
+
+    VectorType residual = rhs - mat * x; // initial residual
+
+    RealScalar rhsNorm2 = rhs.squaredNorm();
+    if (rhsNorm2 == 0)
+    {
+        x.setZero();
+        iters = 0;
+        tol_error = 0;
+        return;
+    }
+    RealScalar threshold = tol * tol * rhsNorm2;
+    RealScalar residualNorm2 = residual.squaredNorm();
+    if (residualNorm2 < threshold)
+    {
+        iters = 0;
+        tol_error = sqrt(residualNorm2 / rhsNorm2);
+        return;
+    }
+
+    if (observer)
+        observer->StartSolve();
+
+    // orthonormal random shadow space
+    const HouseholderQR<DenseMatrixType> qr(DenseMatrixType::Random(n, s));
+    const DenseMatrixType shadow = qr.householderQ() * DenseMatrixType::Identity(n, s);
+
+    DenseMatrixType G = DenseMatrixType::Zero(n, s);
+    DenseMatrixType U = DenseMatrixType::Zero(n, s);
+    DenseMatrixType M = DenseMatrixType::Identity(s, s);
+    VectorType f(s), v(n), t(n);
+    Scalar omega = 1;
+
+    int i = 0;
+    bool converged = false;
+    while (not converged and i < maxIters)
+    {
+        f = shadow.transpose() * residual;
+
+        for (int k = 0; k < s and i < maxIters; ++k)
+        {
+            // solve the lower triangular system M(k:s, k:s) c = f(k:s)
+            const VectorType c =
+                    M.block(k, k, s - k, s - k).template triangularView<Lower>().solve(f.segment(k, s - k));
+            v = residual - G.rightCols(s - k) * c;
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+                t = precond.solve(v);
+            }
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+                v = projectionMatrix * t;
+            }
+            U.col(k) = U.rightCols(s - k) * c + omega * v;
+            {
+                NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+                G.col(k) = mat * U.col(k);
+            }
+            ++i;
+
+            // bi-orthogonalize the new basis vectors against the shadow space
+            for (int j = 0; j < k; ++j)
+            {
+                const Scalar alpha = shadow.col(j).dot(G.col(k)) / M(j, j);
+                G.col(k) -= alpha * G.col(j);
+                U.col(k) -= alpha * U.col(j);
+            }
+            M.col(k).tail(s - k) = shadow.rightCols(s - k).transpose() * G.col(k);
+            if (M(k, k) == Scalar(0))
+                break; // breakdown, continue with a residual reduction step
+
+            const Scalar beta = f[k] / M(k, k);
+            residual -= beta * G.col(k);
+            x += beta * U.col(k);
+
+            residualNorm2 = residual.squaredNorm();
+            if (observer)
+                observer->Iteration(i, sqrt(residualNorm2 / rhsNorm2));
+            if (residualNorm2 < threshold)
+            {
+                converged = true;
+                break;
+            }
+
+            if (k + 1 < s)
+                f.tail(s - k - 1) -= beta * M.col(k).tail(s - k - 1);
+        }
+
+        if (converged or i >= maxIters)
+            break;
+
+        // residual reduction step, moves the residual into the next, smaller subspace
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Preconditioner);
+            t = precond.solve(residual);
+        }
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Projection);
+            v = projectionMatrix * t;
+        }
+        {
+            NuTo::ScopedSolverPhase phase(observer, NuTo::eSolverPhase::Operator);
+            t.noalias() = mat * v;
+        }
+        ++i;
+
+        const RealScalar tNorm = t.norm();
+        if (tNorm == RealScalar(0))
+            break;
+        const Scalar tr = t.dot(residual);
+        omega = tr / (tNorm * tNorm);
+        const RealScalar rho = abs(tr) / (tNorm * sqrt(residualNorm2));
+        if (rho < kappa)
+            omega *= kappa / rho;
+        if (omega == Scalar(0))
+            break;
+
+        residual -= omega * t;
+        x += omega * v;
+
+        residualNorm2 = residual.squaredNorm();
+        if (observer)
+            observer->Iteration(i, sqrt(residualNorm2 / rhsNorm2));
+        converged = residualNorm2 < threshold;
+    }
+
+    tol_error = sqrt(residualNorm2 / rhsNorm2);
+    iters = i;
+}
+}
+
+
+template <typename _MatrixType, typename _Preconditioner = DiagonalPreconditioner<typename _MatrixType::Scalar>>
+class ProjectedIDRS;
+
+namespace internal
+{
+
+template <typename _MatrixType, typename _Preconditioner>
+struct traits<ProjectedIDRS<_MatrixType, _Preconditioner>>
+{
+    typedef _MatrixType MatrixType;
+    typedef _Preconditioner Preconditioner;
+};
+}
+
+
+/** \brief Projected IDR(s) solver for non-symmetric systems, e.g. phase-field tangents
+  *
+  * Used like ConjugateProjectedGradient. The shadow space dimension s trades memory (2s vectors) against the
+  * number of operator applications; s = 4 is a good default, s = 1 is mathematically equivalent to BiCGStab.
+  * iterations() counts operator applications.
+  */
+template <typename _MatrixType, typename _Preconditioner>
+class ProjectedIDRS : public IterativeSolverBase<ProjectedIDRS<_MatrixType, _Preconditioner>>
+{
+    typedef IterativeSolverBase<ProjectedIDRS> Base;
+    using Base::mp_matrix;
+    using Base::m_error;
+    using Base::m_iterations;
+    using Base::m_info;
+    using Base::m_isInitialized;
+
+public:
+    typedef _MatrixType MatrixType;
+    typedef typename MatrixType::Scalar Scalar;
+    typedef typename MatrixType::Index Index;
+    typedef typename MatrixType::RealScalar RealScalar;
+    typedef _Preconditioner Preconditioner;
+
+public:
+    /** Default constructor. */
+    ProjectedIDRS()
+        : Base()
+        , m_s(4)
+        , m_observer(0)
+    {
+    }
+
+    /** Initialize the solver with matrix \a A for further \c Ax=b solving. */
+    ProjectedIDRS(const MatrixType& A)
+        : Base(A)
+        , m_s(4)
+        , m_observer(0)
+    {
+    }
+
+    ~ProjectedIDRS()
+    {
+    }
+
+    /** Sets the dimension of the shadow space, default 4 */
+    ProjectedIDRS& setS(int s)
+    {
+        m_s = s;
+        return *this;
+    }
+
+    int s() const
+    {
+        return m_s;
+    }
+
+    /** Reports every iteration to \a observer, nullptr disables it */
+    ProjectedIDRS& setIterationObserver(NuTo::IterationObserver* observer)
+    {
+        m_observer = observer;
+        return *this;
+    }
+
+    /** \internal */
+    template <typename Rhs, typename Dest, typename ProjectionType>
+    void _solveWithGuess(const Rhs& b, Dest& x, const ProjectionType& projection) const
+    {
+        solveWithOperator(*mp_matrix, b, x, projection);
+    }
+
+    /** Solves \c Ax=b with an operator \a op that does not have to be assembled, see
+      * ConjugateProjectedGradient::solveWithOperator */
+    template <typename OperatorType, typename ProjectionType, typename Rhs, typename Dest>
+    void solveWithOperator(const OperatorType& op, const Rhs& b, Dest& x, const ProjectionType& projection) const
+    {
+        const int maxIterations = Base::m_maxIterations < 0 ? 2 * op.cols() : Base::m_maxIterations;
+
+        for (int j = 0; j < b.cols(); ++j)
+        {
+            m_iterations = maxIterations;
+            m_error = Base::m_tolerance;
+
+            typename Dest::ColXpr xj(x, j);
+            internal::projected_idrs(op, b.col(j), xj, projection, Base::m_preconditioner, m_iterations, m_error,
+                                     m_s, m_observer);
+        }
+
+        m_isInitialized = true;
+        m_info = m_error <= Base::m_tolerance ? Success : NoConvergence;
+    }
+
+protected:
+    int m_s;
+    NuTo::IterationObserver* m_observer;
+};
+
+
+} // end namespace Eigen
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <eigen3/Eigen/Dense>
+#include "MeshCache.h"
+#include "MeshPartitioner.h"
+
+
+//! @brief Cost of an element per load step, fitted to the measured times of all ranks
+//!
+//! Damage localizes in a few elements, which then need more Newton iterations and line searches. The time
+//! of rank r for a load step is modelled as
+//!     t_r = mCostPerElement * numElements_r + mCostPerActiveElement * numActiveElements_r,
+//! where active elements are those whose damage grew during the step. The two costs are the least squares fit
+//! over all ranks, so they reflect what was actually measured instead of a fixed guess.
+struct ElementCostModel
+{
+    double mCostPerElement = 1.;
+    double mCostPerActiveElement = 0.;
+
+    //! @brief Fits the model to the times, numbers of elements and numbers of active elements of all ranks
+    static ElementCostModel Fit(const std::vector<double>& rTimes, const std::vector<int>& rNumElements,
+                                const std::vector<int>& rNumActiveElements)
+    {
+        const int numRanks = rTimes.size();
+        Eigen::MatrixXd A(numRanks, 2);
+        Eigen::VectorXd t(numRanks);
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            A(rank, 0) = rNumElements[rank];
+            A(rank, 1) = rNumActiveElements[rank];
+            t[rank] = rTimes[rank];
+        }
+
+        ElementCostModel model;
+        const Eigen::Vector2d costs = A.colPivHouseholderQr().solve(t);
+        if (A.col(1).isZero() or costs[1] < 0. or costs[0] <= 0.)
+        {
+            // no or inconsistent information about the active elements, fall back to the mean cost per element
+            model.mCostPerElement = t.sum() / std::max(1., A.col(0).sum());
+            model.mCostPerActiveElement = 0.;
+        }
+        else
+        {
+            model.mCostPerElement = costs[0];
+            model.mCostPerActiveElement = costs[1];
+        }
+        return model;
+    }
+
+    double Cost(bool isActive) const
+    {
+        return mCostPerElement + (isActive ? mCostPerActiveElement : 0.);
+    }
+};
+
+
+//! @brief Integer vertex weights proportional to \a rCosts, the cheapest element gets \a resolution
+std::vector<int> CostWeights(const std::vector<double>& rCosts, int resolution = 10)
+{
+    std::vector<int> weights(rCosts.size(), 1);
+    if (rCosts.empty())
+        return weights;
+
+    const double minCost = *std::min_element(rCosts.begin(), rCosts.end());
+    if (minCost <= 0.)
+        throw std::runtime_error("Element costs have to be positive");
+    for (size_t i = 0; i < rCosts.size(); ++i)
+        weights[i] = std::max(1L, std::lround(resolution * rCosts[i] / minCost));
+    return weights;
+}
+
+
+//! @brief Ratio of the heaviest part to the average part weight
+double Imbalance(const std::vector<int>& rPartition, const std::vector<double>& rCosts, int numParts)
+{
+    std::vector<double> load(numParts, 0.);
+    for (size_t i = 0; i < rPartition.size(); ++i)
+        load[rPartition[i]] += rCosts[i];
+    const double total = std::accumulate(load.begin(), load.end(), 0.);
+    return total > 0. ? *std::max_element(load.begin(), load.end()) * numParts / total : 1.;
+}
+
+
+//! @brief Renumbers the parts of \a rNewPartition such that as many elements as possible keep their part
+//!
+//! Greedy assignment on the overlap of old and new parts, the pairs of largest overlap are matched first.
+void MatchPartLabels(const std::vector<int>& rOldPartition, std::vector<int>& rNewPartition, int numParts)
+{
+    std::vector<long> overlap(numParts * numParts, 0);
+    for (size_t i = 0; i < rNewPartition.size(); ++i)
+        ++overlap[rNewPartition[i] * numParts + rOldPartition[i]];
+
+    std::vector<std::tuple<long, int, int>> pairs;
+    for (int newPart = 0; newPart < numParts; ++newPart)
+        for (int oldPart = 0; oldPart < numParts; ++oldPart)
+            pairs.emplace_back(overlap[newPart * numParts + oldPart], newPart, oldPart);
+    std::sort(pairs.begin(), pairs.end(), std::greater<std::tuple<long, int, int>>());
+
+    std::vector<int> label(numParts, -1);
+    std::vector<char> taken(numParts, 0);
+    for (const auto& pair : pairs)
+    {
+        const int newPart = std::get<1>(pair);
+        const int oldPart = std::get<2>(pair);
+        if (label[newPart] == -1 and not taken[oldPart])
+        {
+            label[newPart] = oldPart;
+            taken[oldPart] = 1;
+        }
+    }
+
+    for (auto& part : rNewPartition)
+        part = label[part];
+}
+
+
+struct RepartitionResult
+{
+    std::vector<int> mPartition;
+    double mImbalanceBefore = 1.;
+    double mImbalanceAfter = 1.;
+    long mNumMigratedElements = 0;
+};
+
+
+//! @brief Repartitions the dual graph \a rGraph by the element costs, keeping the old ranks where possible
+//!
+//! The old partition is kept if its imbalance does not exceed \a maxImbalance, moving elements, nodes and
+//! integration point data costs more than a small imbalance.
+RepartitionResult Repartition(const Graph& rGraph, const std::vector<int>& rOldPartition,
+                              const std::vector<double>& rCosts, int numParts, double maxImbalance = 1.1,
+                              PartitionOptions options = PartitionOptions())
+{
+    RepartitionResult result;
+    result.mImbalanceBefore = Imbalance(rOldPartition, rCosts, numParts);
+    result.mPartition = rOldPartition;
+    result.mImbalanceAfter = result.mImbalanceBefore;
+    if (result.mImbalanceBefore <= maxImbalance)
+        return result;
+
+    Graph weighted = rGraph;
+    weighted.mVertexWeights = CostWeights(rCosts);
+    std::vector<int> partition = GraphPartitioner(options).Partition(weighted, numParts);
+    MatchPartLabels(rOldPartition, partition, numParts);
+
+    const double imbalance = Imbalance(partition, rCosts, numParts);
+    if (imbalance >= result.mImbalanceBefore)
+        return result;
+
+    result.mPartition = std::move(partition);
+    result.mImbalanceAfter = imbalance;
+    for (size_t i = 0; i < rOldPartition.size(); ++i)
+        result.mNumMigratedElements += rOldPartition[i] != result.mPartition[i];
+    return result;
+}
+
+
+//! @brief Integration point history of a set of elements, a fixed number of values per element
+struct ElementState
+{
+    int mValuesPerElement = 0;
+    std::vector<int> mIds;
+    std::vector<double> mValues; //!< values of element i at [i * mValuesPerElement, (i + 1) * mValuesPerElement)
+
+    size_t size() const
+    {
+        return mIds.size();
+    }
+};
+
+
+//! @brief Writes \a rState to a binary restart file, one file per rank
+void WriteElementState(const ElementState& rState, const std::string& rFileName)
+{
+    const std::string temporaryFileName = rFileName + "." + std::to_string(getpid());
+    {
+        MeshCacheWriter writer(temporaryFileName);
+        const char magic[8] = {'N', 'U', 'T', 'O', 'S', 'T', 'A', 'T'};
+        writer.Write(magic, 8);
+        writer.Write(std::uint64_t(rState.mIds.size()));
+        writer.Write(std::int32_t(rState.mValuesPerElement));
+        writer.Write(rState.mIds);
+        writer.Write(rState.mValues);
+        writer.Close();
+    }
+    if (std::rename(temporaryFileName.c_str(), rFileName.c_str()) != 0)
+    {
+        std::remove(temporaryFileName.c_str());
+        throw std::runtime_error("Could not write the restart file "s + rFileName);
+    }
+}
+
+
+//! @brief Reads a restart file written by WriteElementState, throws if it is missing or damaged
+ElementState ReadElementState(const std::string& rFileName)
+{
+    const MappedFile file(rFileName);
+    MeshCacheReader reader(file.begin(), file.end());
+
+    char magic[8];
+    reader.Read(magic, 8);
+    if (std::string(magic, 8) != "NUTOSTAT")
+        throw std::runtime_error("Not a restart file: "s + rFileName);
+
+    ElementState state;
+    const auto numElements = reader.Read<std::uint64_t>();
+    state.mValuesPerElement = reader.Read<std::int32_t>();
+    reader.Read(state.mIds, numElements);
+    reader.Read(state.mValues, numElements * state.mValuesPerElement);
+    return state;
+}
+
+
+//! @brief Collects the state of the elements \a rElementIds from the restart files of all old ranks
+//!
+//! Used to restart on a new partition: every rank reads the files prefix0 ... prefix<numOldRanks - 1> and keeps
+//! its own elements, in the order of \a rElementIds. Throws if an element is missing.
+ElementState ReadElementState(const std::string& rPrefix, int numOldRanks, const std::vector<int>& rElementIds)
+{
+    std::vector<FlatIdMap::value_type> position(rElementIds.size());
+    for (size_t i = 0; i < rElementIds.size(); ++i)
+        position[i] = {rElementIds[i], static_cast<int>(i)};
+    const FlatIdMap positions(std::move(position));
+
+    ElementState state;
+    state.mIds = rElementIds;
+    std::vector<char> found(rElementIds.size(), 0);
+    for (int rank = 0; rank < numOldRanks; ++rank)
+    {
+        const ElementState old = ReadElementState(rPrefix + std::to_string(rank));
+        if (rank == 0)
+        {
+            state.mValuesPerElement = old.mValuesPerElement;
+            state.mValues.resize(rElementIds.size() * old.mValuesPerElement);
+        }
+        if (old.mValuesPerElement != state.mValuesPerElement)
+            throw std::runtime_error("The restart files store different numbers of values per element");
+
+        for (size_t i = 0; i < old.size(); ++i)
+        {
+            const auto it = positions.find(old.mIds[i]);
+            if (it == positions.end())
+                continue;
+            std::copy_n(old.mValues.data() + i * old.mValuesPerElement, old.mValuesPerElement,
+                        state.mValues.data() + it->second * state.mValuesPerElement);
+            found[it->second] = 1;
+        }
+    }
+
+    const auto missing = std::find(found.begin(), found.end(), 0);
+    if (missing != found.end())
+        throw std::runtime_error("Element "s + std::to_string(rElementIds[missing - found.begin()]) +
+                                 " is in none of the restart files");
+    return state;
+}
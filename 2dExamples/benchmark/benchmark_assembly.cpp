@@ -0,0 +1,314 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Dense>
+#include "../ElementMatrixCache.h"
+
+// Thread scaling of the colored element assembly, linear elastic stiffness matrix and internal forces.
+//
+// usage: ./benchmark_assembly <mesh.msh> [<max threads>]
+//        ./benchmark_assembly grid <numX> <numY> [<max threads>]
+//   e.g. ./benchmark_assembly ../../meshFiles/3d/3d_uniaxial_matrix.msh 32
+//        ./benchmark_assembly grid 2560 25600
+//
+// Supports the linear elements Triangle3, Quad4, Tetrahedron4 and Hexahedron8 (plane stress in 2d). Every thread
+// count from 1 doubles up to the maximum, default is the number of hardware threads. The speedup is relative to
+// one thread, which runs the same colored loop without any synchronization. The grid is the 100 x 10 quad mesh of
+// 2d_benchmark_solvers. The column "cached" is the scatter of the matrices of an ElementMatrixCache, one per class
+// of congruent elements, which is all a linear elastic assembly needs on a grid.
+
+constexpr double youngsModulus = 4.0e4;
+constexpr double poissonsRatio = 0.2;
+constexpr int numRepetitions = 5;
+
+
+//! @brief Derivatives of the shape functions with respect to the natural coordinates at the integration points
+struct IntegrationRule
+{
+    std::vector<Eigen::MatrixXd> mDerivatives; //!< numNodes x dimension per integration point
+    std::vector<double> mWeights;
+};
+
+
+IntegrationRule LinearIntegrationRule(eElementType type)
+{
+    IntegrationRule rule;
+    const double g = 1. / std::sqrt(3.);
+    switch (type)
+    {
+    case eElementType::Triangle3:
+        rule.mDerivatives.push_back((Eigen::MatrixXd(3, 2) << -1, -1, 1, 0, 0, 1).finished());
+        rule.mWeights.push_back(0.5);
+        break;
+    case eElementType::Tetrahedron4:
+        rule.mDerivatives.push_back((Eigen::MatrixXd(4, 3) << -1, -1, -1, 1, 0, 0, 0, 1, 0, 0, 0, 1).finished());
+        rule.mWeights.push_back(1. / 6.);
+        break;
+    case eElementType::Quad4:
+    {
+        const double corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+        for (const double xi : {-g, g})
+            for (const double eta : {-g, g})
+            {
+                Eigen::MatrixXd derivatives(4, 2);
+                for (int node = 0; node < 4; ++node)
+                {
+                    const double a = corners[node][0], b = corners[node][1];
+                    derivatives(node, 0) = 0.25 * a * (1 + b * eta);
+                    derivatives(node, 1) = 0.25 * b * (1 + a * xi);
+                }
+                rule.mDerivatives.push_back(derivatives);
+                rule.mWeights.push_back(1.);
+            }
+        break;
+    }
+    case eElementType::Hexahedron8:
+    {
+        const double corners[8][3] = {{-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1},
+                                      {-1, -1, 1},  {1, -1, 1},  {1, 1, 1},  {-1, 1, 1}};
+        for (const double xi : {-g, g})
+            for (const double eta : {-g, g})
+                for (const double zeta : {-g, g})
+                {
+                    Eigen::MatrixXd derivatives(8, 3);
+                    for (int node = 0; node < 8; ++node)
+                    {
+                        const double a = corners[node][0], b = corners[node][1], c = corners[node][2];
+                        derivatives(node, 0) = 0.125 * a * (1 + b * eta) * (1 + c * zeta);
+                        derivatives(node, 1) = 0.125 * b * (1 + a * xi) * (1 + c * zeta);
+                        derivatives(node, 2) = 0.125 * c * (1 + a * xi) * (1 + b * eta);
+                    }
+                    rule.mDerivatives.push_back(derivatives);
+                    rule.mWeights.push_back(1.);
+                }
+        break;
+    }
+    default:
+        throw std::runtime_error("benchmark_assembly supports linear elements only");
+    }
+    return rule;
+}
+
+
+Eigen::MatrixXd ElasticityTensor(int dimension)
+{
+    const double E = youngsModulus, nu = poissonsRatio;
+    if (dimension == 2)
+        return E / (1 - nu * nu) * (Eigen::MatrixXd(3, 3) << 1, nu, 0, nu, 1, 0, 0, 0, 0.5 * (1 - nu)).finished();
+
+    const double lambda = E * nu / ((1 + nu) * (1 - 2 * nu)), mu = E / (2 * (1 + nu));
+    Eigen::MatrixXd C = Eigen::MatrixXd::Zero(6, 6);
+    C.topLeftCorner(3, 3).setConstant(lambda);
+    C.diagonal() << Eigen::Vector3d::Constant(lambda + 2 * mu), Eigen::Vector3d::Constant(mu);
+    return C;
+}
+
+
+//! @brief Element stiffness and internal forces K u of linear elastic elements
+class ElasticityKernel
+{
+public:
+    ElasticityKernel(const ImportContainer& rMesh, int dimension, int numThreads)
+        : mMesh(rMesh)
+        , mDimension(dimension)
+        , mC(ElasticityTensor(dimension))
+        , mNodeIndices(NodeIndices(rMesh).GlobalToLocal(rMesh.mElementList.mNodeIds))
+        , mScratch(numThreads)
+    {
+        for (const auto type : {eElementType::Triangle3, eElementType::Quad4, eElementType::Tetrahedron4,
+                                eElementType::Hexahedron8})
+            if (ElementDimension(type) == dimension)
+                mRules[type] = LinearIntegrationRule(type);
+
+        // a small affine displacement field, the internal forces are then those of a homogeneous strain
+        mDisplacements.resize(dimension * rMesh.mNodeList.size());
+        for (size_t node = 0; node < rMesh.mNodeList.size(); ++node)
+            for (int direction = 0; direction < dimension; ++direction)
+                mDisplacements[dimension * node + direction] =
+                        1.e-3 * rMesh.mNodeList[node].mCoordinates[(direction + 1) % dimension];
+    }
+
+    void operator()(int element, int thread, Eigen::MatrixXd& rMatrix, Eigen::VectorXd& rVector)
+    {
+        const ElementBlock& elements = mMesh.mElementList;
+        const IntegrationRule& rule = mRules.at(elements.mTypes[element]);
+        const int* nodes = &mNodeIndices[elements.mOffsets[element]];
+        const int numNodes = elements.mOffsets[element + 1] - elements.mOffsets[element];
+        const int numStrains = mC.rows();
+
+        Scratch& scratch = mScratch[thread];
+        scratch.mCoordinates.resize(numNodes, mDimension);
+        scratch.mDisplacements.resize(mDimension * numNodes);
+        for (int node = 0; node < numNodes; ++node)
+        {
+            scratch.mCoordinates.row(node) = mMesh.mNodeList[nodes[node]].mCoordinates.head(mDimension).transpose();
+            scratch.mDisplacements.segment(mDimension * node, mDimension) =
+                    mDisplacements.segment(mDimension * nodes[node], mDimension);
+        }
+
+        scratch.mB.setZero(numStrains, mDimension * numNodes);
+        for (size_t ip = 0; ip < rule.mWeights.size(); ++ip)
+        {
+            const Eigen::MatrixXd& derivatives = rule.mDerivatives[ip];
+            scratch.mJacobian.noalias() = scratch.mCoordinates.transpose() * derivatives;
+            const double detJ = scratch.mJacobian.determinant();
+            scratch.mGradients.noalias() = derivatives * scratch.mJacobian.inverse();
+
+            for (int node = 0; node < numNodes; ++node)
+            {
+                const int col = mDimension * node;
+                if (mDimension == 2)
+                {
+                    scratch.mB(0, col) = scratch.mB(2, col + 1) = scratch.mGradients(node, 0);
+                    scratch.mB(1, col + 1) = scratch.mB(2, col) = scratch.mGradients(node, 1);
+                }
+                else
+                {
+                    scratch.mB(0, col) = scratch.mB(4, col + 2) = scratch.mB(5, col + 1) = scratch.mGradients(node, 0);
+                    scratch.mB(1, col + 1) = scratch.mB(3, col + 2) = scratch.mB(5, col) = scratch.mGradients(node, 1);
+                    scratch.mB(2, col + 2) = scratch.mB(3, col + 1) = scratch.mB(4, col) = scratch.mGradients(node, 2);
+                }
+            }
+            scratch.mCB.noalias() = mC * scratch.mB;
+            rMatrix.noalias() += (rule.mWeights[ip] * std::abs(detJ)) * scratch.mB.transpose() * scratch.mCB;
+        }
+        rVector.noalias() = rMatrix * scratch.mDisplacements;
+    }
+
+private:
+    struct Scratch
+    {
+        Eigen::MatrixXd mCoordinates;
+        Eigen::VectorXd mDisplacements;
+        Eigen::MatrixXd mJacobian;
+        Eigen::MatrixXd mGradients;
+        Eigen::MatrixXd mB;
+        Eigen::MatrixXd mCB;
+        char mPadding[64];
+    };
+
+    const ImportContainer& mMesh;
+    int mDimension;
+    Eigen::MatrixXd mC;
+    std::vector<int> mNodeIndices;
+    std::map<eElementType, IntegrationRule> mRules;
+    Eigen::VectorXd mDisplacements;
+    std::vector<Scratch> mScratch;
+};
+
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+//! @brief numX x numY quads on 100 x 10 like MeshGenerator::Grid
+ImportContainer StructuredGrid(int numX, int numY)
+{
+    ImportContainer mesh;
+    mesh.mNodeList.reserve((numX + 1) * (numY + 1));
+    for (int row = 0; row <= numY; ++row)
+        for (int col = 0; col <= numX; ++col)
+            mesh.mNodeList.push_back(
+                    {Eigen::Vector3d(100. * col / numX, 10. * row / numY, 0.), row * (numX + 1) + col + 1});
+
+    ElementBlock& elements = mesh.mElementList;
+    for (int row = 0; row < numY; ++row)
+        for (int col = 0; col < numX; ++col)
+        {
+            const int node = row * (numX + 1) + col + 1;
+            elements.mIds.push_back(elements.size() + 1);
+            elements.mTypes.push_back(eElementType::Quad4);
+            elements.mPhysicalGroups.push_back(0);
+            for (const int id : {node, node + 1, node + numX + 2, node + numX + 1})
+                elements.mNodeIds.push_back(id);
+            elements.mOffsets.push_back(elements.mNodeIds.size());
+        }
+    return mesh;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool grid = argc > 1 and std::string(argv[1]) == "grid";
+    if (argc < 2 or (grid and argc < 4))
+    {
+        std::cout << "usage: " << argv[0] << " <mesh.msh> [<max threads>]\n";
+        std::cout << "       " << argv[0] << " grid <numX> <numY> [<max threads>]\n";
+        return EXIT_FAILURE;
+    }
+    const int threadsArgument = grid ? 4 : 2;
+    const int maxThreads = argc > threadsArgument ? std::stoi(argv[threadsArgument])
+                                                  : std::max(1u, std::thread::hardware_concurrency());
+
+    const ImportContainer mesh =
+            grid ? StructuredGrid(std::stoi(argv[2]), std::stoi(argv[3])) : ReadGmshFile(argv[1]);
+    const std::string name = grid ? "grid "s + argv[2] + " x " + argv[3] : argv[1];
+    int dimension = 2;
+    for (const auto type : mesh.mElementList.mTypes)
+        dimension = std::max(dimension, ElementDimension(type));
+
+    std::vector<int> threadCounts;
+    for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+        threadCounts.push_back(numThreads);
+    threadCounts.push_back(maxThreads);
+
+    auto start = std::chrono::steady_clock::now();
+    ElementMatrixCache cache(mesh, dimension);
+    {
+        ThreadPool pool(1);
+        ElasticityKernel kernel(mesh, dimension, 1);
+        cache.Compute(std::ref(kernel), mesh, pool);
+    }
+    const double cacheTime = Seconds(start);
+
+    std::cout << "\n" << name << ": " << mesh.mElementList.size() << " elements, " << dimension * mesh.mNodeList.size()
+              << " dofs, " << cache.NumClasses() << " classes of congruent elements computed in " << cacheTime
+              << " s\n";
+    std::cout << std::setw(8) << "threads" << std::setw(8) << "colors" << std::setw(14) << "setup [s]"
+              << std::setw(14) << "assemble [s]" << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+              << std::setw(12) << "identical" << std::setw(12) << "cached [s]" << "\n";
+
+    double singleThreadTime = 0.;
+    Eigen::SparseMatrix<double> singleThreadMatrix;
+    for (const int numThreads : threadCounts)
+    {
+        ThreadPool pool(numThreads);
+        start = std::chrono::steady_clock::now();
+        ColoredAssembler assembler(mesh, dimension, pool);
+        const double setupTime = Seconds(start);
+
+        ElasticityKernel kernel(mesh, dimension, numThreads);
+        assembler.Assemble(std::ref(kernel)); // warm up, allocates the scratch buffers
+        start = std::chrono::steady_clock::now();
+        for (int repetition = 0; repetition < numRepetitions; ++repetition)
+            assembler.Assemble(std::ref(kernel));
+        const double assembleTime = Seconds(start) / numRepetitions;
+
+        const Eigen::SparseMatrix<double>& matrix = assembler.GetMatrix();
+        if (numThreads == 1)
+        {
+            singleThreadTime = assembleTime;
+            singleThreadMatrix = matrix;
+        }
+        const bool identical =
+                std::equal(matrix.valuePtr(), matrix.valuePtr() + matrix.nonZeros(), singleThreadMatrix.valuePtr());
+
+        start = std::chrono::steady_clock::now();
+        for (int repetition = 0; repetition < numRepetitions; ++repetition)
+            assembler.AssembleMatrix(std::cref(cache));
+        const double cachedTime = Seconds(start) / numRepetitions;
+        if ((assembler.GetMatrix() - singleThreadMatrix).norm() > 1.e-10 * singleThreadMatrix.norm())
+            throw std::runtime_error("The cached element matrices assemble a different matrix");
+
+        std::cout << std::setw(8) << numThreads << std::setw(8) << assembler.GetColors().size() << std::setw(14)
+                  << std::setprecision(3) << setupTime << std::setw(14) << assembleTime << std::setw(10)
+                  << singleThreadTime / assembleTime << std::setw(12)
+                  << singleThreadTime / assembleTime / numThreads << std::setw(12) << (identical ? "yes" : "no")
+                  << std::setw(12) << cachedTime << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
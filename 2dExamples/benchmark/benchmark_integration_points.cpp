@@ -0,0 +1,135 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../../IntegrationPointHistory.h"
+
+// Constitutive update of the gradient damage law, per integration point objects against the contiguous
+// IntegrationPointHistory and its batch kernel.
+//
+// usage: ./benchmark_integration_points [<number of integration points>]
+//
+// The per integration point path mimics the static data of NuTo: every point owns a heap allocated object with
+// its history, reached through a pointer and a virtual call. Configure with -DNUTO_NATIVE_ARCH=ON to build with
+// -march=native and let the batch kernel use AVX2 or AVX-512.
+
+constexpr double youngsModulus = 30000.;
+constexpr double poissonsRatio = 0.2;
+constexpr double tensileStrength = 4.;
+constexpr double compressiveStrength = 40.;
+constexpr double fractureEnergy = 0.021;
+constexpr double alpha = 0.99;
+constexpr int numRepetitions = 20;
+
+
+struct IntegrationPointBase
+{
+    virtual ~IntegrationPointBase() = default;
+    virtual void Evaluate(const Eigen::Vector3d& rStrain, double nonlocalEqStrain, Eigen::Vector3d& rStress,
+                          double& rLocalEqStrain) = 0;
+};
+
+
+//! @brief Plane stress gradient damage of one integration point with its own history
+class GradientDamageIntegrationPoint : public IntegrationPointBase
+{
+public:
+    explicit GradientDamageIntegrationPoint(const Eigen::Matrix3d& rC)
+        : mC(rC)
+    {
+    }
+
+    void Evaluate(const Eigen::Vector3d& rStrain, double nonlocalEqStrain, Eigen::Vector3d& rStress,
+                  double& rLocalEqStrain) override
+    {
+        const double kappa0 = tensileStrength / youngsModulus, beta = tensileStrength / fractureEnergy;
+        mKappaTrial = std::max(mKappa, nonlocalEqStrain);
+        const double kappa = std::max(mKappaTrial, kappa0);
+        const double softening = std::exp(beta * (kappa0 - kappa));
+        mDamage = 1 - kappa0 / kappa * (1 - alpha + alpha * softening);
+        rStress = (1 - mDamage) * mC * rStrain;
+
+        const double k = compressiveStrength / tensileStrength, nu = poissonsRatio;
+        const double ezz = -nu / (1 - nu) * (rStrain[0] + rStrain[1]);
+        const double I1 = rStrain[0] + rStrain[1] + ezz;
+        const double J2 = (std::pow(rStrain[0] - rStrain[1], 2) + std::pow(rStrain[1] - ezz, 2) +
+                           std::pow(ezz - rStrain[0], 2)) /
+                                  6. +
+                          rStrain[2] * rStrain[2] / 4.;
+        rLocalEqStrain = (k - 1) / (2 * k * (1 - 2 * nu)) * I1 +
+                         1. / (2 * k) * std::sqrt(std::pow((k - 1) / (1 - 2 * nu), 2) * I1 * I1 +
+                                                  12 * k / std::pow(1 + nu, 2) * J2);
+    }
+
+private:
+    Eigen::Matrix3d mC;
+    double mKappa = 0.;
+    double mKappaTrial = 0.;
+    double mDamage = 0.;
+};
+
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char* argv[])
+{
+    const int numIps = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    const auto section = NuTo::eSectionType::PlaneStress;
+    const Eigen::Matrix3d C = NuTo::ElasticityMatrix(youngsModulus, poissonsRatio, section);
+    const double kappa0 = tensileStrength / youngsModulus;
+
+    const Eigen::ArrayXXd strains = 3. * kappa0 * Eigen::ArrayXXd::Random(numIps, 3);
+    const Eigen::ArrayXd nonlocal = 2. * kappa0 * (Eigen::ArrayXd::Random(numIps) + 1.);
+
+    // interleaved with other allocations like the static data created element by element
+    std::vector<std::unique_ptr<IntegrationPointBase>> integrationPoints;
+    std::vector<std::unique_ptr<double[]>> otherAllocations;
+    for (int ip = 0; ip < numIps; ++ip)
+    {
+        integrationPoints.push_back(std::make_unique<GradientDamageIntegrationPoint>(C));
+        otherAllocations.emplace_back(new double[ip % 7 + 1]);
+    }
+    std::vector<Eigen::Vector3d> stresses(numIps);
+    std::vector<double> localEqStrains(numIps);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < numRepetitions; ++repetition)
+        for (int ip = 0; ip < numIps; ++ip)
+            integrationPoints[ip]->Evaluate(strains.row(ip).transpose().matrix(), nonlocal[ip], stresses[ip],
+                                            localEqStrains[ip]);
+    const double perIpTime = Seconds(start) / numRepetitions;
+
+    NuTo::GradientDamageLaw law(youngsModulus, poissonsRatio, tensileStrength, compressiveStrength, fractureEnergy,
+                                alpha, section);
+    NuTo::IntegrationPointHistory history(numIps, 1, 3);
+    history.mStrains = strains;
+    NuTo::GradientDamageResponse response;
+    law.Evaluate(nonlocal, history, response); // allocates the response
+
+    start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < numRepetitions; ++repetition)
+        law.Evaluate(nonlocal, history, response);
+    const double batchTime = Seconds(start) / numRepetitions;
+
+    double difference = 0.;
+    for (int ip = 0; ip < numIps; ++ip)
+        difference = std::max(difference, (response.mStress.row(ip).transpose().matrix() - stresses[ip]).norm() /
+                                                  (C * strains.row(ip).transpose().matrix()).norm());
+
+    std::cout << numIps << " integration points, plane stress gradient damage, batch kernel also returns the "
+              << "derivatives\n";
+    std::cout << std::setw(24) << "" << std::setw(12) << "[s]" << std::setw(12) << "[ns / ip]" << "\n";
+    std::cout << std::setw(24) << "per integration point" << std::setw(12) << std::setprecision(3) << perIpTime
+              << std::setw(12) << 1.e9 * perIpTime / numIps << "\n";
+    std::cout << std::setw(24) << "batch" << std::setw(12) << batchTime << std::setw(12) << 1.e9 * batchTime / numIps
+              << "\n";
+    std::cout << "speedup " << perIpTime / batchTime << ", largest relative stress difference " << difference
+              << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Sparse>
+#include <eigen3/Eigen/SparseLU>
+#include "../../SparseOrdering.h"
+
+// Fill and timings of the local FETI solver, Eigen::SparseLU, for every fill-reducing ordering.
+//
+// usage: ./benchmark_orderings <mesh.msh> [<mesh.msh> ...]
+//   e.g. ./benchmark_orderings ../../meshFiles/2d/2d_L_shaped_panel.msh ../../meshFiles/3d/3d_uniaxial_matrix.msh
+//
+// The matrix couples all dofs of the nodes of every element, one dof per node and direction, numbered node by
+// node like the displacements of a subdomain. Its values make it diagonally dominant, so SparseLU keeps the
+// diagonal pivots and the fill depends on the ordering only. The natural ordering is skipped, on the numbering of
+// gmsh it fills in about ten times more than RCM.
+
+using SparseMatrix = Eigen::SparseMatrix<double>;
+using Solver = Eigen::SparseLU<SparseMatrix, NuTo::SelectableOrdering<int>>;
+
+
+SparseMatrix StiffnessPattern(const ImportContainer& rMesh)
+{
+    const ElementBlock& elements = rMesh.mElementList;
+    int dimension = 2;
+    for (const auto type : elements.mTypes)
+        dimension = std::max(dimension, ElementDimension(type));
+
+    const std::vector<int> nodeIndices = NodeIndices(rMesh).GlobalToLocal(elements.mNodeIds);
+    std::vector<Eigen::Triplet<double>> entries;
+    for (size_t element = 0; element < elements.size(); ++element)
+        for (int i = elements.mOffsets[element]; i < elements.mOffsets[element + 1]; ++i)
+            for (int j = elements.mOffsets[element]; j < elements.mOffsets[element + 1]; ++j)
+                for (int a = 0; a < dimension; ++a)
+                    for (int b = 0; b < dimension; ++b)
+                        entries.emplace_back(dimension * nodeIndices[i] + a, dimension * nodeIndices[j] + b, -1.);
+
+    const int numDofs = dimension * rMesh.mNodeList.size();
+    SparseMatrix matrix(numDofs, numDofs);
+    matrix.setFromTriplets(entries.begin(), entries.end());
+    for (int col = 0; col < numDofs; ++col)
+    {
+        double sum = 0.;
+        for (SparseMatrix::InnerIterator it(matrix, col); it; ++it)
+            sum -= it.value();
+        matrix.coeffRef(col, col) = sum + 1.;
+    }
+    matrix.makeCompressed();
+    return matrix;
+}
+
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: " << argv[0] << " <mesh.msh> [<mesh.msh> ...]\n";
+        return EXIT_FAILURE;
+    }
+
+    constexpr int numSolves = 10;
+    for (int i = 1; i < argc; ++i)
+    {
+        const SparseMatrix matrix = StiffnessPattern(ReadGmshFile(argv[i]));
+        const Eigen::VectorXd rhs = Eigen::VectorXd::Random(matrix.rows());
+
+        std::cout << "\n" << argv[i] << ": " << matrix.rows() << " dofs, " << matrix.nonZeros() << " nonzeros\n";
+        std::cout << std::setw(10) << "ordering" << std::setw(14) << "nnz(L+U)" << std::setw(10) << "fill"
+                  << std::setw(14) << "analyze [s]" << std::setw(14) << "factorize [s]" << std::setw(12)
+                  << "solve [s]" << std::setw(12) << "residual" << "\n";
+
+        for (const auto& ordering : NuTo::OrderingNames())
+        {
+            if (ordering.first == NuTo::eOrdering::Natural)
+                continue;
+            NuTo::SelectableOrdering<int>::Set(ordering.first);
+            Solver solver;
+
+            auto start = std::chrono::steady_clock::now();
+            solver.analyzePattern(matrix);
+            const double analyzeTime = Seconds(start);
+
+            start = std::chrono::steady_clock::now();
+            solver.factorize(matrix);
+            const double factorizeTime = Seconds(start);
+
+            Eigen::VectorXd x;
+            start = std::chrono::steady_clock::now();
+            for (int solve = 0; solve < numSolves; ++solve)
+                x = solver.solve(rhs);
+            const double solveTime = Seconds(start) / numSolves;
+
+            const long factorNonZeros = solver.nnzL() + solver.nnzU();
+            std::cout << std::setw(10) << ordering.second << std::setw(14) << factorNonZeros << std::setw(10)
+                      << std::setprecision(3) << double(factorNonZeros) / matrix.nonZeros() << std::setw(14)
+                      << analyzeTime << std::setw(14) << factorizeTime << std::setw(12) << solveTime << std::setw(12)
+                      << (matrix * x - rhs).norm() / rhs.norm() << std::endl;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@
 #include <mechanics/constitutive/damageLaws/DamageLawExponential.h>
 #include "mechanics/feti/NewmarkFeti.h"
 #include "../../../EnumsAndTypedefs.h"
+#include "../../../FetiLocalSolver.h"
 
 #include "mechanics/nodes/NodeBase.h"
 
@@ -23,7 +24,7 @@ using Eigen::MatrixXd;
 // using EigenSolver = Eigen::SparseQR<Eigen::SparseMatrix<double>,Eigen::COLAMDOrdering<int>>;
 // using EigenSolver = Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>>;
 // using EigenSolver = Eigen::PardisoLU<Eigen::SparseMatrix<double>>;
-using EigenSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>;
+using EigenSolver = NuTo::FetiLocalSolver;
 
 
 constexpr int dimension = 2;
@@ -7,6 +7,7 @@
 #include <chrono>
 #include "mechanics/feti/NewmarkFeti.h"
 #include "../../../EnumsAndTypedefs.h"
+#include "../../../FetiLocalSolver.h"
 
 #include "mechanics/nodes/NodeBase.h"
 #include "mechanics/constitutive/damageLaws/DamageLawExponential.h"
@@ -19,7 +20,7 @@ using namespace NuTo;
 constexpr int dim = 2;
 using Eigen::VectorXd;
 using Eigen::MatrixXd;
-using EigenSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>;
+using EigenSolver = NuTo::FetiLocalSolver;
 using FetiScaling = NewmarkFeti<EigenSolver>::eFetiScaling;
 constexpr double thickness = 1.0;
 
@@ -7,6 +7,7 @@
 #include <chrono>
 #include "mechanics/feti/NewmarkFeti.h"
 #include "../../../EnumsAndTypedefs.h"
+#include "../../../FetiLocalSolver.h"
 
 #include "mechanics/nodes/NodeBase.h"
 #include "mechanics/constitutive/damageLaws/DamageLawExponential.h"
@@ -14,11 +15,13 @@
 #include "mechanics/sections/SectionPlane.h"
 #include "mechanics/groups/Group.h"
 #include "mechanics/mesh/MeshGenerator.h"
+#include "../../../FetiBalanceReport.h"
 constexpr int dim = 2;
 using Eigen::VectorXd;
 using Eigen::MatrixXd;
 
-using EigenSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>;
+// the local factorizations and solves of the time integration are timed for the load balance report
+using EigenSolver = NuTo::TimedLocalSolver<NuTo::FetiLocalSolver>;
 
 // geometry
 constexpr double lengthX = 100;
@@ -242,6 +245,21 @@ int main(int argc, char* argv[])
                           << "*********************************** \n\n";
 
 
+    // the fill-in and solve time of the local solver usually explain the imbalance
+    NuTo::FetiBalanceReport balanceReport(world);
+    balanceReport.Local().mNumDofs = structure.GetNumTotalDofs();
+    balanceReport.Local().mNumInterfaceDofs = NuTo::NumInterfaceDofs(structure.GetConnectivityMatrix());
+    balanceReport.Local().mNumRigidBodyModes = structure.GetNumRigidBodyModes();
+    EigenSolver::Attach(&balanceReport);
+
+    const auto start = std::chrono::steady_clock::now();
     newmarkFeti.Solve(simulationTime);
+    balanceReport.Local().mTotalTime =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EigenSolver::Attach(nullptr);
+
     structure.GetLogger() << "Total number of Dofs: \t" << structure.GetNumTotalDofs() << "\n\n";
+
+    balanceReport.Print(std::cout);
+    balanceReport.AppendTable("feti_balance.txt");
 }
@@ -7,6 +7,7 @@
 #include <chrono>
 #include "mechanics/feti/NewmarkFeti.h"
 #include "../../../EnumsAndTypedefs.h"
+#include "../../../FetiLocalSolver.h"
 
 #include "mechanics/nodes/NodeBase.h"
 
@@ -20,7 +21,7 @@ using Eigen::MatrixXd;
 // using EigenSolver = Eigen::SparseQR<Eigen::SparseMatrix<double>,Eigen::COLAMDOrdering<int>>;
 // using EigenSolver = Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>>;
 // using EigenSolver = Eigen::PardisoLU<Eigen::SparseMatrix<double>>;
-using EigenSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>;
+using EigenSolver = NuTo::FetiLocalSolver;
 
 constexpr double thickness = 1.0;
 
@@ -7,6 +7,7 @@
 #include <chrono>
 #include "mechanics/feti/NewmarkFeti.h"
 #include "../../../EnumsAndTypedefs.h"
+#include "../../../FetiLocalSolver.h"
 
 #include "mechanics/nodes/NodeBase.h"
 
@@ -18,7 +19,7 @@ constexpr int dim = 2;
 using Eigen::VectorXd;
 using Eigen::MatrixXd;
 
-using EigenSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>;
+using EigenSolver = NuTo::FetiLocalSolver;
 
 // geometry
 constexpr double domainLength = 20.;
@@ -0,0 +1,76 @@
+
+#include <mpi.h>
+#include <boost/mpi.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "../MeshPartitioner.h"
+
+// Partitions a gmsh mesh into FETI subdomains and writes one JSON subdomain file per subdomain, ready for
+// StructureFeti::ImportMeshJson.
+//
+// usage: mpirun -np <ranks> ./partition_mesh <mesh.msh> <numSubdomains> [<output prefix>] [<imbalance>]
+//
+// Rank 0 partitions the dual graph of the elements and broadcasts the result, afterwards every rank writes the
+// subdomains rank, rank + size, ... The files are named <output prefix><subdomain>, the default prefix is the mesh
+// file name with the extension .mesh, e.g. three_point_bending.msh -> three_point_bending.mesh0, ...
+int main(int argc, char* argv[])
+{
+    boost::mpi::environment env(argc, argv);
+    boost::mpi::communicator world;
+
+    const int rank = world.rank();
+
+    if (argc < 3)
+    {
+        if (rank == 0)
+            std::cout << "usage: " << argv[0] << " <mesh.msh> <numSubdomains> [<output prefix>] [<imbalance>]\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::string meshFile = argv[1];
+    const int numSubdomains = std::stoi(argv[2]);
+    const std::string outputPrefix =
+            argc > 3 ? argv[3] : meshFile.substr(0, meshFile.find_last_of('.')) + ".mesh";
+
+    PartitionOptions options;
+    if (argc > 4)
+        options.mImbalance = std::stod(argv[4]);
+
+    // every rank needs the whole mesh to write its subdomains, reading it is much cheaper than sending it
+    const ImportContainer mesh = ReadGmshFile(meshFile);
+
+    std::vector<int> partition;
+    if (rank == 0)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const Graph graph = ElementDualGraph(mesh);
+        partition = GraphPartitioner(options).Partition(graph, numSubdomains);
+        const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<int> numElements(numSubdomains, 0);
+        for (const int subdomain : partition)
+            ++numElements[subdomain];
+
+        std::cout << mesh.mElementList.size() << " elements, " << numSubdomains << " subdomains, partitioned in "
+                  << time << " s\n";
+        std::cout << "edge cut: " << EdgeCut(graph, partition) << "\n";
+        for (int subdomain = 0; subdomain < numSubdomains; ++subdomain)
+            std::cout << "subdomain " << subdomain << ": " << numElements[subdomain] << " elements\n";
+    }
+    partition.resize(mesh.mElementList.size());
+    boost::mpi::broadcast(world, partition.data(), partition.size(), 0);
+
+    const SubdomainWriter writer(mesh, std::move(partition), numSubdomains, ReadGmshPhysicalNames(meshFile));
+    for (int subdomain = rank; subdomain < numSubdomains; subdomain += world.size())
+        writer.Write(subdomain, outputPrefix + std::to_string(subdomain));
+
+    world.barrier();
+    if (rank == 0)
+        std::cout << writer.Interfaces().size() << " interfaces, " << writer.NumInterfaceNodes()
+                  << " Lagrange multipliers\n"
+                  << "written to " << outputPrefix << "0 ... " << outputPrefix << numSubdomains - 1 << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@
 #include "mechanics/groups/Group.h"
 #include "mechanics/feti/NewmarkFeti.h"
 #include "../../../EnumsAndTypedefs.h"
+#include "../../../FetiLocalSolver.h"
 
 #include "boost/filesystem.hpp"
 
@@ -23,7 +24,7 @@ using Node::eDof;
 using Eigen::VectorXd;
 using Eigen::Vector2d;
 using Eigen::Matrix2d;
-using EigenSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>;
+using EigenSolver = NuTo::FetiLocalSolver;
 using FetiIterativeSolver = NewmarkFeti<EigenSolver>::eIterativeSolver;
 using FetiScaling = NewmarkFeti<EigenSolver>::eFetiScaling;
 
@@ -12,6 +12,8 @@
 #include "mechanics/groups/Group.h"
 #include "mechanics/feti/NewmarkFeti.h"
 #include "../../../EnumsAndTypedefs.h"
+#include "../../../FetiLocalSolver.h"
+#include "../../MixedPrecisionSolver.h"
 
 #include "boost/filesystem.hpp"
 
@@ -26,7 +28,8 @@ using Node::eDof;
 using Eigen::VectorXd;
 using Eigen::Vector2d;
 using Eigen::Matrix2d;
-using EigenSolver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>;
+// using EigenSolver = Eigen::MixedPrecisionSolver<Eigen::SparseLU<Eigen::SparseMatrix<float>, Eigen::COLAMDOrdering<int>>>;
+using EigenSolver = NuTo::FetiLocalSolver;
 using FetiIterativeSolver = NewmarkFeti<EigenSolver>::eIterativeSolver;
 using FetiScaling = NewmarkFeti<EigenSolver>::eFetiScaling;
 
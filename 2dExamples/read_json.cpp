@@ -1,34 +1,18 @@
-
-#include <jsoncpp/json/json.h>
 #include <iostream>
-#include <fstream>
+#include "ImportMeshJson.h"
+#include "MeshCache.h"
 
-int main()
+int main(int argc, char* argv[])
 {
-    Json::Value root;
-    Json::Reader reader;
-
-
-    std::ifstream file("mesh.json");
-
-    if (not reader.parse(file, root, false))
-        std::cout << "Oh no!" << std::endl;
-
-
-    std::cout << "Hello " << std::endl;
-
-
-    std::vector<int> vec;
-
-    for (const auto& bla : root["LocalToGlobalMap"])
-        vec.push_back(bla.asInt());
-
-    for (const auto& bla : vec)
-        std::cout << bla << std::endl;
+    const std::string fileName = argc > 1 ? argv[1] : "mesh.json";
 
+    const ImportContainer mesh = CachedImport(fileName, ImportMeshJsonFile);
 
-    std::cout << root["Elements"][0]["NodalConnectivity"][0][0] << std::endl;
+    for (const auto& globalId : mesh.mLocalToGlobalMap)
+        std::cout << globalId << std::endl;
 
+    if (not mesh.mElementList.empty())
+        std::cout << mesh.mElementList.NodeIds(0)[0] << std::endl;
 
-    std::cout << root["Elements"][0]["NodalConnectivity"].size() << std::endl;
+    std::cout << mesh.mElementList.size() << std::endl;
 }
@@ -5,6 +5,8 @@
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/LU>
 #include <fstream>
+#include "IterationObserver.h"
+#include "Preconditioners.h"
 
 namespace NuTo
 {
@@ -26,8 +28,13 @@ void WriteSimulationParameters(const std::map<std::string, std::string>& paramet
 }
 
 
-bool BiCGStab(const Eigen::MatrixXd& mat, const Eigen::VectorXd& rhs, Eigen::VectorXd& x,
-              Eigen::FullPivLU<Eigen::MatrixXd>& precond, double tol_error, int& iters)
+//! @brief Preconditioned BiCGStab for non-symmetric systems
+//! @param mat dense or sparse matrix, or any linear operator providing cols() and operator*
+//! @param precond preconditioner providing solve(), e.g. JacobiPreconditioner, ILU0Preconditioner,
+//! BlockJacobiPreconditioner or a factorization
+template <typename MatrixType, typename Preconditioner>
+bool BiCGStab(const MatrixType& mat, const Eigen::VectorXd& rhs, Eigen::VectorXd& x, const Preconditioner& precond,
+              double tol_error, int& iters, IterationObserver* observer = nullptr)
 {
 
     using std::sqrt;
@@ -65,11 +72,17 @@ bool BiCGStab(const Eigen::MatrixXd& mat, const Eigen::VectorXd& rhs, Eigen::Vec
     Index i = 0;
     Index restarts = 0;
 
+    if (observer)
+        observer->StartSolve();
+
     while (r.squaredNorm() > tol2 && i < maxIters)
     {
         Scalar rho_old = rho;
 
-        rho = r0.dot(r);
+        {
+            ScopedSolverPhase phase(observer, eSolverPhase::Reduction);
+            rho = r0.dot(r);
+        }
         if (abs(rho) < eps2 * r0_sqnorm)
         {
             // The new residual vector became too orthogonal to the arbitrarily chosen direction r0
@@ -83,24 +96,41 @@ bool BiCGStab(const Eigen::MatrixXd& mat, const Eigen::VectorXd& rhs, Eigen::Vec
         Scalar beta = (rho / rho_old) * (alpha / w);
         p = r + beta * (p - w * v);
 
-        y = precond.solve(p);
-
-        v.noalias() = mat * y;
-
-        alpha = rho / r0.dot(v);
+        {
+            ScopedSolverPhase phase(observer, eSolverPhase::Preconditioner);
+            y = precond.solve(p);
+        }
+        {
+            ScopedSolverPhase phase(observer, eSolverPhase::Operator);
+            v.noalias() = mat * y;
+        }
+        {
+            ScopedSolverPhase phase(observer, eSolverPhase::Reduction);
+            alpha = rho / r0.dot(v);
+        }
         s = r - alpha * v;
 
-        z = precond.solve(s);
-        t.noalias() = mat * z;
+        {
+            ScopedSolverPhase phase(observer, eSolverPhase::Preconditioner);
+            z = precond.solve(s);
+        }
+        {
+            ScopedSolverPhase phase(observer, eSolverPhase::Operator);
+            t.noalias() = mat * z;
+        }
 
-        RealScalar tmp = t.squaredNorm();
-        if (tmp > RealScalar(0))
-            w = t.dot(s) / tmp;
-        else
-            w = Scalar(0);
+        RealScalar tmp;
+        {
+            ScopedSolverPhase phase(observer, eSolverPhase::Reduction);
+            tmp = t.squaredNorm();
+            w = tmp > RealScalar(0) ? Scalar(t.dot(s) / tmp) : Scalar(0);
+        }
         x += alpha * y + w * z;
         r = s - w * t;
         ++i;
+
+        if (observer)
+            observer->Iteration(i, sqrt(r.squaredNorm() / rhs_sqnorm));
     }
     tol_error = sqrt(r.squaredNorm() / rhs_sqnorm);
     iters = i;
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <boost/mpi.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Sparse>
+#include <eigen3/Eigen/SparseLU>
+#include <eigen3/Eigen/SparseCholesky>
+#include "SymbolicReuseSolver.h"
+
+namespace NuTo
+{
+
+//! @brief Load balance data of the subdomain of one rank
+struct SubdomainBalance
+{
+    long mNumDofs = 0;
+    long mNumInterfaceDofs = 0; //!< dofs coupled to Lagrange multipliers
+    int mNumRigidBodyModes = 0; //!< zero for a fixed subdomain, floating ones need a pseudo inverse
+    long mFactorNonZeros = 0; //!< nonzeros of the factors of the local stiffness matrix, of the last factorization
+    double mFactorizationTime = 0.; //!< seconds, summed over all factorizations
+    int mNumFactorizations = 0;
+    double mLocalSolveTime = 0.; //!< seconds, summed over all local solves
+    int mNumLocalSolves = 0; //!< right hand sides, a solve with several columns counts once per column
+    double mTotalTime = 0.; //!< seconds, e.g. of the whole time integration
+
+    double MeanFactorizationTime() const
+    {
+        return mNumFactorizations > 0 ? mFactorizationTime / mNumFactorizations : 0.;
+    }
+
+    double MeanLocalSolveTime() const
+    {
+        return mNumLocalSolves > 0 ? mLocalSolveTime / mNumLocalSolves : 0.;
+    }
+
+    bool IsFloating() const
+    {
+        return mNumRigidBodyModes > 0;
+    }
+};
+
+
+//! @brief Number of nonzeros of the factors of a sparse LU decomposition
+template <typename MatrixType, typename Ordering>
+long FactorNonZeros(const Eigen::SparseLU<MatrixType, Ordering>& rSolver)
+{
+    return rSolver.nnzL() + rSolver.nnzU();
+}
+
+//! @brief Number of nonzeros of the factor L of a simplicial Cholesky decomposition
+template <typename MatrixType, int UpLo, typename Ordering>
+long FactorNonZeros(const Eigen::SimplicialLDLT<MatrixType, UpLo, Ordering>& rSolver)
+{
+    return rSolver.matrixL().nestedExpression().nonZeros();
+}
+
+template <typename MatrixType, int UpLo, typename Ordering>
+long FactorNonZeros(const Eigen::SimplicialLLT<MatrixType, UpLo, Ordering>& rSolver)
+{
+    return rSolver.matrixL().nestedExpression().nonZeros();
+}
+
+template <typename Solver>
+long FactorNonZeros(const SymbolicReuseSolver<Solver>& rSolver)
+{
+    return FactorNonZeros(rSolver.GetSolver());
+}
+
+
+//! @brief Number of dofs (columns) the connectivity matrix B couples to Lagrange multipliers
+template <typename SparseMatrixType>
+long NumInterfaceDofs(const SparseMatrixType& rConnectivityMatrix)
+{
+    std::set<long> dofs;
+    for (int k = 0; k < rConnectivityMatrix.outerSize(); ++k)
+        for (typename SparseMatrixType::InnerIterator it(rConnectivityMatrix, k); it; ++it)
+            if (it.value() != 0.)
+                dofs.insert(it.col());
+    return dofs.size();
+}
+
+
+//! @brief Gathers the load balance of all FETI subdomains to rank 0 and explains the critical path
+//!
+//! Every rank fills in its SubdomainBalance, the local solver times e.g. through TimedLocalSolver, then all ranks
+//! call Print. The dofs
+//! alone do not predict the time of a FETI iteration: the local solve depends on the fill-in of the factors,
+//! floating subdomains additionally take part in the coarse problem, and large interfaces make the
+//! application of the connectivity matrices expensive. The report therefore lists these quantities side by side
+//! and names the rank with the slowest local solve, which every iteration waits for.
+class FetiBalanceReport
+{
+public:
+    explicit FetiBalanceReport(const boost::mpi::communicator& rCommunicator)
+        : mCommunicator(rCommunicator)
+    {
+    }
+
+    SubdomainBalance& Local()
+    {
+        return mLocal;
+    }
+
+    const SubdomainBalance& Local() const
+    {
+        return mLocal;
+    }
+
+    //! @brief Adds the time of a successful factorization and the nonzeros of its factors
+    void AddFactorization(double seconds, long factorNonZeros)
+    {
+        mLocal.mFactorizationTime += seconds;
+        ++mLocal.mNumFactorizations;
+        mLocal.mFactorNonZeros = factorNonZeros;
+    }
+
+    //! @brief Adds the time of a local solve with \a numRhs right hand sides
+    void AddLocalSolve(double seconds, int numRhs = 1)
+    {
+        mLocal.mLocalSolveTime += seconds;
+        mLocal.mNumLocalSolves += numRhs;
+    }
+
+    //! @brief Collective, returns the balance of all ranks on rank 0 and an empty vector on all others
+    std::vector<SubdomainBalance> Gather() const
+    {
+        constexpr int numValues = 9;
+        const std::array<double, numValues> local = {
+                {double(mLocal.mNumDofs), double(mLocal.mNumInterfaceDofs), double(mLocal.mNumRigidBodyModes),
+                 double(mLocal.mFactorNonZeros), mLocal.mFactorizationTime, double(mLocal.mNumFactorizations),
+                 mLocal.mLocalSolveTime, double(mLocal.mNumLocalSolves), mLocal.mTotalTime}};
+
+        const bool isRoot = mCommunicator.rank() == 0;
+        std::vector<double> all(isRoot ? numValues * mCommunicator.size() : 0);
+        if (isRoot)
+            boost::mpi::gather(mCommunicator, local.data(), numValues, all.data(), 0);
+        else
+            boost::mpi::gather(mCommunicator, local.data(), numValues, 0);
+
+        std::vector<SubdomainBalance> balance(all.size() / numValues);
+        for (size_t rank = 0; rank < balance.size(); ++rank)
+        {
+            const double* values = &all[numValues * rank];
+            balance[rank].mNumDofs = values[0];
+            balance[rank].mNumInterfaceDofs = values[1];
+            balance[rank].mNumRigidBodyModes = values[2];
+            balance[rank].mFactorNonZeros = values[3];
+            balance[rank].mFactorizationTime = values[4];
+            balance[rank].mNumFactorizations = values[5];
+            balance[rank].mLocalSolveTime = values[6];
+            balance[rank].mNumLocalSolves = values[7];
+            balance[rank].mTotalTime = values[8];
+        }
+        return balance;
+    }
+
+    //! @brief Collective, rank 0 prints one line per rank, the imbalance ratios and the critical path
+    void Print(std::ostream& rOut) const
+    {
+        const std::vector<SubdomainBalance> balance = Gather();
+        if (balance.empty())
+            return;
+
+        rOut << "*********************************** \n"
+             << "**      FETI load balance        ** \n"
+             << "*********************************** \n\n";
+
+        rOut << std::setw(6) << "rank" << std::setw(12) << "dofs" << std::setw(12) << "interface" << std::setw(10)
+             << "floating" << std::setw(14) << "factor nnz" << std::setw(14) << "factorize [s]" << std::setw(14)
+             << "solve [s]" << std::setw(12) << "total [s]" << "\n";
+        for (size_t rank = 0; rank < balance.size(); ++rank)
+        {
+            const SubdomainBalance& b = balance[rank];
+            rOut << std::setw(6) << rank << std::setw(12) << b.mNumDofs << std::setw(12) << b.mNumInterfaceDofs
+                 << std::setw(10) << (b.IsFloating() ? "yes" : "no") << std::setw(14) << b.mFactorNonZeros
+                 << std::setw(14) << b.MeanFactorizationTime() << std::setw(14) << b.MeanLocalSolveTime()
+                 << std::setw(12) << b.mTotalTime << "\n";
+        }
+
+        rOut << "\nimbalance (max / mean)\n";
+        PrintImbalance(rOut, balance, "dofs", [](const SubdomainBalance& b) { return b.mNumDofs; });
+        PrintImbalance(rOut, balance, "interface dofs", [](const SubdomainBalance& b) { return b.mNumInterfaceDofs; });
+        PrintImbalance(rOut, balance, "factor nonzeros", [](const SubdomainBalance& b) { return b.mFactorNonZeros; });
+        PrintImbalance(rOut, balance, "factorization time",
+                       [](const SubdomainBalance& b) { return b.MeanFactorizationTime(); });
+        PrintImbalance(rOut, balance, "local solve time",
+                       [](const SubdomainBalance& b) { return b.MeanLocalSolveTime(); });
+
+        const auto slowest = std::max_element(balance.begin(), balance.end(), [](const auto& a, const auto& b) {
+            return a.MeanLocalSolveTime() < b.MeanLocalSolveTime();
+        });
+        const auto largest = std::max_element(balance.begin(), balance.end(),
+                                              [](const auto& a, const auto& b) { return a.mNumDofs < b.mNumDofs; });
+        const int numFloating = std::count_if(balance.begin(), balance.end(), [](const SubdomainBalance& b) {
+            return b.IsFloating();
+        });
+        const int numRigidBodyModes = std::accumulate(
+                balance.begin(), balance.end(), 0, [](int sum, const SubdomainBalance& b) {
+                    return sum + b.mNumRigidBodyModes;
+                });
+
+        rOut << "\ncritical path: rank " << slowest - balance.begin() << " with the slowest local solve ("
+             << slowest->MeanLocalSolveTime() << " s)";
+        if (slowest != largest)
+            rOut << ", the most dofs has rank " << largest - balance.begin();
+        rOut << "\nfloating subdomains: " << numFloating << " of " << balance.size() << ", coarse problem of size "
+             << numRigidBodyModes << "\n\n";
+    }
+
+    //! @brief Collective, rank 0 appends one line "numRanks totalTime dofs... solveTimes..." to \a rFileName
+    //!
+    //! Extends the format of meshFiles/2d/feti/benchmark/feti_benchmark.txt by the local solve times, the
+    //! total time is the one of the slowest rank.
+    void AppendTable(const std::string& rFileName) const
+    {
+        const std::vector<SubdomainBalance> balance = Gather();
+        if (balance.empty())
+            return;
+
+        double totalTime = 0.;
+        for (const auto& b : balance)
+            totalTime = std::max(totalTime, b.mTotalTime);
+
+        std::ofstream file(rFileName, std::ios::app);
+        file << balance.size() << " " << totalTime;
+        for (const auto& b : balance)
+            file << " " << b.mNumDofs;
+        for (const auto& b : balance)
+            file << " " << b.MeanLocalSolveTime();
+        file << "\n";
+    }
+
+private:
+    template <typename Value>
+    static void PrintImbalance(std::ostream& rOut, const std::vector<SubdomainBalance>& rBalance,
+                               const std::string& rName, Value value)
+    {
+        double max = 0.;
+        double sum = 0.;
+        for (const auto& b : rBalance)
+        {
+            max = std::max(max, double(value(b)));
+            sum += value(b);
+        }
+        const double mean = sum / rBalance.size();
+        rOut << "  " << std::left << std::setw(20) << rName << std::right << (mean > 0. ? max / mean : 1.) << "\n";
+    }
+
+    boost::mpi::communicator mCommunicator;
+    SubdomainBalance mLocal;
+};
+
+
+//! @brief Local solver that reports its factorizations and solves to a FetiBalanceReport
+//!
+//! NewmarkFeti constructs its local solver itself, so the report is attached to the solver type before the time
+//! integration. The times are then those of the real local solves of the FETI iterations:
+//!
+//!     using EigenSolver = NuTo::TimedLocalSolver<NuTo::FetiLocalSolver>;
+//!     EigenSolver::Attach(&balanceReport);
+template <typename Solver>
+class TimedLocalSolver
+{
+public:
+    using MatrixType = typename Solver::MatrixType;
+    using Scalar = typename MatrixType::Scalar;
+    using Index = typename MatrixType::Index;
+
+    TimedLocalSolver() = default;
+
+    explicit TimedLocalSolver(const MatrixType& rMatrix)
+    {
+        compute(rMatrix);
+    }
+
+    //! @brief All solvers of this type report to \a rReport, nullptr stops the reporting
+    static void Attach(FetiBalanceReport* rReport)
+    {
+        Report() = rReport;
+    }
+
+    TimedLocalSolver& compute(const MatrixType& rMatrix)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        mSolver.compute(rMatrix);
+        AddFactorization(start);
+        return *this;
+    }
+
+    void analyzePattern(const MatrixType& rMatrix)
+    {
+        mSolver.analyzePattern(rMatrix);
+    }
+
+    void factorize(const MatrixType& rMatrix)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        mSolver.factorize(rMatrix);
+        AddFactorization(start);
+    }
+
+    //! @brief Evaluates the solution, Eigen would otherwise defer the solve to the assignment outside the timer
+    template <typename Rhs>
+    Eigen::Matrix<Scalar, Eigen::Dynamic, Rhs::ColsAtCompileTime> solve(const Eigen::MatrixBase<Rhs>& rRhs) const
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Eigen::Matrix<Scalar, Eigen::Dynamic, Rhs::ColsAtCompileTime> x = mSolver.solve(rRhs);
+        if (Report())
+            Report()->AddLocalSolve(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+                                    rRhs.cols());
+        return x;
+    }
+
+    Eigen::ComputationInfo info() const
+    {
+        return mSolver.info();
+    }
+
+    Index rows() const
+    {
+        return mSolver.rows();
+    }
+
+    Index cols() const
+    {
+        return mSolver.cols();
+    }
+
+    const Solver& GetSolver() const
+    {
+        return mSolver;
+    }
+
+private:
+    static FetiBalanceReport*& Report()
+    {
+        static FetiBalanceReport* report = nullptr;
+        return report;
+    }
+
+    //! @brief Failed factorizations are left to the caller and not reported
+    void AddFactorization(std::chrono::steady_clock::time_point start) const
+    {
+        if (Report() and mSolver.info() == Eigen::Success)
+            Report()->AddFactorization(
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+                    FactorNonZeros(mSolver));
+    }
+
+    Solver mSolver;
+};
+
+template <typename Solver>
+long FactorNonZeros(const TimedLocalSolver<Solver>& rSolver)
+{
+    return FactorNonZeros(rSolver.GetSolver());
+}
+
+} // namespace NuTo
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <eigen3/Eigen/Sparse>
+#include <eigen3/Eigen/SparseLU>
+#include "SparseOrdering.h"
+#include "SymbolicReuseSolver.h"
+
+namespace NuTo
+{
+
+//! @brief Local solver of the FETI drivers, the EigenSolver of NewmarkFeti
+//!
+//! Sparse LU with the fill-reducing ordering selected at run time, e.g. NUTO_ORDERING=ND mpirun ..., COLAMD by
+//! default. The symbolic analysis is reused as long as the sparsity pattern of the local stiffness matrix stays
+//! the same.
+using FetiLocalSolver = SymbolicReuseSolver<Eigen::SparseLU<Eigen::SparseMatrix<double>, SelectableOrdering<int>>>;
+
+} // namespace NuTo
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <eigen3/Eigen/Core>
+
+namespace NuTo
+{
+
+enum class eSectionType
+{
+    PlaneStress,
+    PlaneStrain,
+    Volume
+};
+
+
+inline int NumStrains(eSectionType section)
+{
+    return section == eSectionType::Volume ? 6 : 3;
+}
+
+
+//! @brief Linear elastic stiffness in Voigt notation with engineering shear strains
+//!
+//! Strain order [xx, yy, xy] in 2d and [xx, yy, zz, yz, zx, xy] in 3d.
+inline Eigen::MatrixXd ElasticityMatrix(double youngsModulus, double poissonsRatio, eSectionType section)
+{
+    const double E = youngsModulus, nu = poissonsRatio;
+    if (section == eSectionType::PlaneStress)
+        return E / (1 - nu * nu) * (Eigen::MatrixXd(3, 3) << 1, nu, 0, nu, 1, 0, 0, 0, 0.5 * (1 - nu)).finished();
+
+    const double lambda = E * nu / ((1 + nu) * (1 - 2 * nu)), mu = E / (2 * (1 + nu));
+    if (section == eSectionType::PlaneStrain)
+        return (Eigen::MatrixXd(3, 3) << lambda + 2 * mu, lambda, 0, lambda, lambda + 2 * mu, 0, 0, 0, mu).finished();
+
+    Eigen::MatrixXd C = Eigen::MatrixXd::Zero(6, 6);
+    C.topLeftCorner(3, 3).setConstant(lambda);
+    C.diagonal() << Eigen::Vector3d::Constant(lambda + 2 * mu), Eigen::Vector3d::Constant(mu);
+    return C;
+}
+
+
+//! @brief History data of all integration points of an element group, one contiguous array per variable
+//!
+//! Replaces the static data objects of the single integration points. Integration point ip of element e is
+//! row Index(e, ip) of every array, so a constitutive law updates a whole group in one pass over contiguous
+//! memory instead of following a pointer per integration point. The laws write the trial history of the current
+//! iteration, Commit() accepts it once the time step converged.
+struct IntegrationPointHistory
+{
+    IntegrationPointHistory(int numElements, int numIntegrationPoints, int numStrains)
+        : mNumIntegrationPoints(numIntegrationPoints)
+        , mStrains(Eigen::ArrayXXd::Zero(numElements * numIntegrationPoints, numStrains))
+        , mKappa(Eigen::ArrayXd::Zero(numElements * numIntegrationPoints))
+        , mKappaTrial(mKappa)
+        , mDamage(mKappa)
+        , mPhaseFieldHistory(mKappa)
+        , mPhaseFieldHistoryTrial(mKappa)
+    {
+    }
+
+    int size() const
+    {
+        return mStrains.rows();
+    }
+
+    int Index(int element, int integrationPoint) const
+    {
+        return element * mNumIntegrationPoints + integrationPoint;
+    }
+
+    void Commit()
+    {
+        mKappa = mKappaTrial;
+        mPhaseFieldHistory = mPhaseFieldHistoryTrial;
+    }
+
+    int mNumIntegrationPoints;
+    Eigen::ArrayXXd mStrains; //!< engineering strains, one column per component
+    Eigen::ArrayXd mKappa; //!< largest nonlocal equivalent strain of the damage law, committed
+    Eigen::ArrayXd mKappaTrial;
+    Eigen::ArrayXd mDamage; //!< of mKappaTrial
+    Eigen::ArrayXd mPhaseFieldHistory; //!< largest elastic energy density of the phase field law, committed
+    Eigen::ArrayXd mPhaseFieldHistoryTrial;
+};
+
+
+namespace IntegrationPointKernels
+{
+//! Integration points per pass, the temporaries of a pass stay in the L1 cache and on the stack
+constexpr int blockSize = 256;
+using Block = Eigen::Array<double, Eigen::Dynamic, 1, Eigen::ColMajor, blockSize, 1>;
+
+//! @brief Component \a i of the stress C ε of the integration points [begin, begin + n)
+inline Block LinearElasticStress(const Eigen::MatrixXd& rC, int i, const Eigen::ArrayXXd& rStrains, int begin, int n)
+{
+    Block stress = Block::Zero(n);
+    for (int j = 0; j < rC.cols(); ++j)
+        if (rC(i, j) != 0.)
+            stress += rC(i, j) * rStrains.col(j).segment(begin, n);
+    return stress;
+}
+} // namespace IntegrationPointKernels
+
+
+//! @brief Output of GradientDamageLaw::Evaluate per integration point
+struct GradientDamageResponse
+{
+    Eigen::ArrayXXd mStress; //!< (1 - ω) C ε
+    Eigen::ArrayXd mStiffnessFactor; //!< 1 - ω, dσ/dε = (1 - ω) C
+    Eigen::ArrayXd mDamageDerivative; //!< dω/dẽ while loading, else 0, dσ/dẽ = -dω/dẽ C ε
+    Eigen::ArrayXd mLocalEqStrain; //!< modified Mises equivalent strain of ε
+    Eigen::ArrayXXd mLocalEqStrainDerivative; //!< d(local eq strain)/dε
+};
+
+
+//! @brief GRADIENT_DAMAGE_ENGINEERING_STRESS with DamageLawExponential, evaluated for all integration points at once
+//!
+//! κ = max(κ_committed, ẽ) of the nonlocal equivalent strain ẽ, ω = 1 - κ0 / κ (1 - α + α exp(β (κ0 - κ))) for
+//! κ > κ0 and the local equivalent strain is the modified Mises strain with k = compressive / tensile strength.
+//! The arguments of DamageLawExponential::Create are κ0 = tensileStrength / youngsModulus,
+//! β = tensileStrength / fractureEnergy and α.
+class GradientDamageLaw
+{
+public:
+    GradientDamageLaw(double youngsModulus, double poissonsRatio, double tensileStrength,
+                      double compressiveStrength, double fractureEnergy, double alpha, eSectionType section)
+        : mC(ElasticityMatrix(youngsModulus, poissonsRatio, section))
+        , mSection(section)
+        , mKappa0(tensileStrength / youngsModulus)
+        , mBeta(tensileStrength / fractureEnergy)
+        , mAlpha(alpha)
+    {
+        const double k = compressiveStrength / tensileStrength, nu = poissonsRatio;
+        mMisesA = (k - 1) / (2 * k * (1 - 2 * nu));
+        mMisesB = 1. / (2 * k);
+        mMisesD = std::pow((k - 1) / (1 - 2 * nu), 2);
+        mMisesE = 12 * k / std::pow(1 + nu, 2);
+        mOutOfPlaneStrain = section == eSectionType::PlaneStress ? -nu / (1 - nu) : 0.;
+    }
+
+    //! @brief Updates the trial history and damage of \a rHistory from its strains and \a rNonlocalEqStrain
+    void Evaluate(const Eigen::ArrayXd& rNonlocalEqStrain, IntegrationPointHistory& rHistory,
+                  GradientDamageResponse& rResponse) const
+    {
+        using namespace IntegrationPointKernels;
+        const int numIps = rHistory.size();
+        rResponse.mStress.resize(numIps, mC.rows());
+        rResponse.mStiffnessFactor.resize(numIps);
+        rResponse.mDamageDerivative.resize(numIps);
+        rResponse.mLocalEqStrain.resize(numIps);
+        rResponse.mLocalEqStrainDerivative.resize(numIps, mC.rows());
+
+        for (int begin = 0; begin < numIps; begin += blockSize)
+        {
+            const int n = std::min(blockSize, numIps - begin);
+            const auto nonlocal = rNonlocalEqStrain.segment(begin, n);
+            const auto kappaCommitted = rHistory.mKappa.segment(begin, n);
+            auto kappa = rHistory.mKappaTrial.segment(begin, n);
+            auto damage = rHistory.mDamage.segment(begin, n);
+
+            // κ below κ0 gives ω = 0 exactly, no branch needed
+            kappa = kappaCommitted.max(nonlocal);
+            const Block kappaLimited = kappa.max(mKappa0);
+            const Block inverseKappa = kappaLimited.inverse(); // the only division
+            const Block softening = (mBeta * (mKappa0 - kappaLimited)).exp();
+            const Block residual = 1 - mAlpha + mAlpha * softening;
+            const Block stiffnessFactor = mKappa0 * inverseKappa * residual;
+            damage = 1 - stiffnessFactor;
+
+            const Block dDamage = mKappa0 * inverseKappa * (residual * inverseKappa + mAlpha * mBeta * softening);
+            rResponse.mDamageDerivative.segment(begin, n) =
+                    (nonlocal > kappaCommitted && nonlocal > mKappa0).select(dDamage, 0.);
+            rResponse.mStiffnessFactor.segment(begin, n) = stiffnessFactor;
+
+            for (int i = 0; i < mC.rows(); ++i)
+                rResponse.mStress.col(i).segment(begin, n) =
+                        stiffnessFactor * LinearElasticStress(mC, i, rHistory.mStrains, begin, n);
+
+            LocalEqStrain(rHistory.mStrains, begin, n, rResponse);
+        }
+    }
+
+    double GetKappa0() const
+    {
+        return mKappa0;
+    }
+
+private:
+    //! @brief Modified Mises equivalent strain ξ = A I1 + B sqrt(D I1² + E J2) and its derivative
+    void LocalEqStrain(const Eigen::ArrayXXd& rStrains, int begin, int n, GradientDamageResponse& rResponse) const
+    {
+        using namespace IntegrationPointKernels;
+        const bool volume = mSection == eSectionType::Volume;
+        const auto exx = rStrains.col(0).segment(begin, n);
+        const auto eyy = rStrains.col(1).segment(begin, n);
+        const Block ezz = volume ? Block(rStrains.col(2).segment(begin, n)) : Block(mOutOfPlaneStrain * (exx + eyy));
+        Block shear = rStrains.col(volume ? 5 : 2).segment(begin, n).square();
+        if (volume)
+            shear += rStrains.col(3).segment(begin, n).square() + rStrains.col(4).segment(begin, n).square();
+
+        const Block I1 = exx + eyy + ezz;
+        const Block J2 = ((exx - eyy).square() + (eyy - ezz).square() + (ezz - exx).square()) * (1. / 6.) +
+                         shear * 0.25;
+        const Block root = (mMisesD * I1.square() + mMisesE * J2).sqrt();
+        rResponse.mLocalEqStrain.segment(begin, n) = mMisesA * I1 + mMisesB * root;
+
+        const Block inverseRoot = (root > 0.).select(root.inverse(), 0.);
+        const Block dI1 = mMisesA + mMisesB * mMisesD * I1 * inverseRoot;
+        const Block dJ2 = 0.5 * mMisesB * mMisesE * inverseRoot;
+        const Block dJ2dzz = (2 * ezz - exx - eyy) * (1. / 3.);
+        auto derivative = [&](int component) {
+            return rResponse.mLocalEqStrainDerivative.col(component).segment(begin, n);
+        };
+        if (volume)
+        {
+            derivative(0) = dI1 + dJ2 * (2 * exx - eyy - ezz) * (1. / 3.);
+            derivative(1) = dI1 + dJ2 * (2 * eyy - exx - ezz) * (1. / 3.);
+            derivative(2) = dI1 + dJ2 * dJ2dzz;
+            for (int component = 3; component < 6; ++component)
+                derivative(component) = 0.5 * dJ2 * rStrains.col(component).segment(begin, n);
+        }
+        else
+        {
+            // ε_zz = c (ε_xx + ε_yy) in plane stress, c = 0 in plane strain
+            const double c = mOutOfPlaneStrain;
+            derivative(0) = dI1 * (1 + c) + dJ2 * ((2 * exx - eyy - ezz) * (1. / 3.) + c * dJ2dzz);
+            derivative(1) = dI1 * (1 + c) + dJ2 * ((2 * eyy - exx - ezz) * (1. / 3.) + c * dJ2dzz);
+            derivative(2) = 0.5 * dJ2 * rStrains.col(2).segment(begin, n);
+        }
+    }
+
+    Eigen::MatrixXd mC;
+    eSectionType mSection;
+    double mKappa0;
+    double mBeta;
+    double mAlpha;
+    double mMisesA, mMisesB, mMisesD, mMisesE;
+    double mOutOfPlaneStrain;
+};
+
+
+//! @brief Output of PhaseFieldLaw::Evaluate per integration point
+struct PhaseFieldResponse
+{
+    Eigen::ArrayXXd mStress; //!< ((1 - d)² + k) C ε
+    Eigen::ArrayXd mDegradation; //!< (1 - d)² + k, dσ/dε = ((1 - d)² + k) C
+    Eigen::ArrayXXd mStressDerivative; //!< dσ/dd = -2 (1 - d) C ε
+};
+
+
+//! @brief NuTo::PhaseField with the ISOTROPIC energy decomposition, evaluated for all integration points at once
+//!
+//! The history is the largest elastic energy density ψ = ε : C ε / 2 reached so far, it drives the phase field
+//! equation. The anisotropic spectral decomposition is not covered and stays with the per integration point law.
+class PhaseFieldLaw
+{
+public:
+    PhaseFieldLaw(double youngsModulus, double poissonsRatio, eSectionType section, double residualStiffness = 1.e-10)
+        : mC(ElasticityMatrix(youngsModulus, poissonsRatio, section))
+        , mResidualStiffness(residualStiffness)
+    {
+    }
+
+    //! @brief Updates the trial history of \a rHistory from its strains, \a rPhaseField is d at the integration points
+    void Evaluate(const Eigen::ArrayXd& rPhaseField, IntegrationPointHistory& rHistory,
+                  PhaseFieldResponse& rResponse) const
+    {
+        using namespace IntegrationPointKernels;
+        const int numIps = rHistory.size();
+        rResponse.mStress.resize(numIps, mC.rows());
+        rResponse.mDegradation.resize(numIps);
+        rResponse.mStressDerivative.resize(numIps, mC.rows());
+
+        for (int begin = 0; begin < numIps; begin += blockSize)
+        {
+            const int n = std::min(blockSize, numIps - begin);
+            const auto d = rPhaseField.segment(begin, n);
+
+            const Block degradation = (1 - d).square() + mResidualStiffness;
+            rResponse.mDegradation.segment(begin, n) = degradation;
+            Block energy = Block::Zero(n);
+            for (int i = 0; i < mC.rows(); ++i)
+            {
+                const Block stress = LinearElasticStress(mC, i, rHistory.mStrains, begin, n);
+                energy += stress * rHistory.mStrains.col(i).segment(begin, n);
+                rResponse.mStress.col(i).segment(begin, n) = degradation * stress;
+                rResponse.mStressDerivative.col(i).segment(begin, n) = -2 * (1 - d) * stress;
+            }
+            rHistory.mPhaseFieldHistoryTrial.segment(begin, n) =
+                    rHistory.mPhaseFieldHistory.segment(begin, n).max(0.5 * energy);
+        }
+    }
+
+private:
+    Eigen::MatrixXd mC;
+    double mResidualStiffness;
+};
+
+} // namespace NuTo
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+namespace NuTo
+{
+
+//! @brief Parts of an iteration of the (projected) Krylov solvers that are timed separately
+enum class eSolverPhase
+{
+    Operator = 0,
+    Preconditioner = 1,
+    Projection = 2,
+    Reduction = 3
+};
+
+
+//! @brief Interface to follow the iterations of the (projected) Krylov solvers
+//!
+//! The solvers call StartPhase/StopPhase around every operator, preconditioner and projection application and
+//! every global reduction, and Iteration once per iteration. Passing no observer costs nothing.
+class IterationObserver
+{
+public:
+    virtual ~IterationObserver() = default;
+
+    //! @brief Called once before the first iteration of a solve
+    virtual void StartSolve()
+    {
+    }
+
+    virtual void StartPhase(eSolverPhase)
+    {
+    }
+
+    virtual void StopPhase(eSolverPhase)
+    {
+    }
+
+    //! @brief Called at the end of each iteration with the relative residual norm
+    virtual void Iteration(int, double)
+    {
+    }
+};
+
+
+//! @brief Times a solver phase for the lifetime of the object, does nothing if the observer is a nullptr
+class ScopedSolverPhase
+{
+public:
+    ScopedSolverPhase(IterationObserver* observer, eSolverPhase phase)
+        : mObserver(observer)
+        , mPhase(phase)
+    {
+        if (mObserver)
+            mObserver->StartPhase(mPhase);
+    }
+
+    ~ScopedSolverPhase()
+    {
+        if (mObserver)
+            mObserver->StopPhase(mPhase);
+    }
+
+private:
+    IterationObserver* mObserver;
+    eSolverPhase mPhase;
+};
+
+
+//! @brief Writes one CSV line per iteration with the residual and the time spent in each phase
+//!
+//! Columns: solve, iteration, residual, operator, preconditioner, projection, reduction. Times are in seconds
+//! and refer to the respective iteration only, the first one includes the initial search direction. Every rank
+//! writes its own file, e.g. "iterations_3.csv".
+class IterationLog : public IterationObserver
+{
+public:
+    IterationLog(const std::string& fileName)
+        : mFile(fileName)
+    {
+        mFile << "solve,iteration,residual,operator,preconditioner,projection,reduction\n";
+    }
+
+    IterationLog(const std::string& prefix, int rank)
+        : IterationLog(prefix + "_" + std::to_string(rank) + ".csv")
+    {
+    }
+
+    void StartSolve() override
+    {
+        ++mSolve;
+        mPhaseTimes.fill(0.);
+    }
+
+    void StartPhase(eSolverPhase phase) override
+    {
+        mPhaseStart[static_cast<int>(phase)] = std::chrono::steady_clock::now();
+    }
+
+    void StopPhase(eSolverPhase phase) override
+    {
+        const int id = static_cast<int>(phase);
+        mPhaseTimes[id] += std::chrono::duration<double>(std::chrono::steady_clock::now() - mPhaseStart[id]).count();
+    }
+
+    void Iteration(int iteration, double residual) override
+    {
+        mFile << mSolve << "," << iteration << "," << residual;
+        for (double time : mPhaseTimes)
+            mFile << "," << time;
+        mFile << "\n";
+        mPhaseTimes.fill(0.);
+    }
+
+private:
+    std::ofstream mFile;
+    int mSolve = 0;
+    std::array<double, 4> mPhaseTimes = {{0., 0., 0., 0.}};
+    std::array<std::chrono::steady_clock::time_point, 4> mPhaseStart;
+};
+
+} // namespace NuTo
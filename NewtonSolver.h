@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cmath>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Sparse>
+
+namespace NuTo
+{
+
+//! @brief How the equilibrium iterations use the tangent
+enum class eNewtonStrategy
+{
+    FullNewton, //!< assembles and factorizes the tangent in every iteration
+    ModifiedNewton, //!< keeps a factorized tangent for several iterations and load steps
+    LBFGS //!< limited memory BFGS updates on top of a kept factorization
+};
+
+
+struct NewtonOptions
+{
+    eNewtonStrategy mStrategy = eNewtonStrategy::FullNewton;
+    double mTolerance = 1.e-6; //!< on the norm of the residual
+    int mMaxIterations = 20;
+    int mMaxTangentAge = 5; //!< iterations a factorization is used before it is replaced
+    double mMaxContraction = 0.5; //!< the tangent is replaced once |r_k+1| / |r_k| exceeds this ratio
+    int mNumCorrectionPairs = 10; //!< memory of LBFGS
+};
+
+
+struct NewtonResult
+{
+    bool mConverged = false;
+    int mNumIterations = 0;
+    int mNumFactorizations = 0;
+    int mNumFallbacks = 0; //!< steps of a kept tangent that diverged and were redone with full Newton
+    double mResidualNorm = 0.;
+};
+
+
+//! @brief Newton iterations for R(x) = 0 that avoid refactorizing the tangent where it barely changes
+//!
+//! In the elastic parts of a load path the tangent stays nearly the same, refactorizing it in every iteration
+//! is wasted. ModifiedNewton keeps the factorization for up to mMaxTangentAge iterations, also across calls of
+//! Solve, i.e. across time steps, as long as the residual contracts by at least mMaxContraction per iteration.
+//! LBFGS additionally corrects the kept tangent with the last mNumCorrectionPairs steps (Matthies and Strang),
+//! which restores a superlinear rate. Whenever a step with a kept tangent increases the residual, it is undone
+//! and the remaining iterations of the call fall back to full Newton, e.g. once damage starts to grow. A step with
+//! a new tangent that gives a non-finite residual is undone and ends the call unconverged, since another tangent
+//! at the same state could not do better. The caller then has to e.g. reduce the load step.
+//!
+//! Solver is an Eigen sparse solver, ideally a SymbolicReuseSolver. The callbacks are
+//!     Eigen::VectorXd residual(const Eigen::VectorXd& x)
+//!     Eigen::SparseMatrix<double> tangent(const Eigen::VectorXd& x)
+template <typename Solver>
+class NewtonSolver
+{
+public:
+    explicit NewtonSolver(NewtonOptions options = NewtonOptions())
+        : mOptions(options)
+    {
+    }
+
+    //! @brief Iterates on \a rX until the residual norm is below the tolerance
+    template <typename ResidualFunction, typename TangentFunction>
+    NewtonResult Solve(ResidualFunction residual, TangentFunction tangent, Eigen::VectorXd& rX)
+    {
+        NewtonResult result;
+        bool fullNewton = mOptions.mStrategy == eNewtonStrategy::FullNewton;
+        mCorrections.clear();
+
+        Eigen::VectorXd r = residual(rX);
+        result.mResidualNorm = r.norm();
+        while (result.mResidualNorm > mOptions.mTolerance)
+        {
+            if (result.mNumIterations == mOptions.mMaxIterations)
+                return result;
+            ++result.mNumIterations;
+
+            if (fullNewton or not mHasTangent or mTangentAge >= mOptions.mMaxTangentAge)
+            {
+                Factorize(tangent(rX));
+                ++result.mNumFactorizations;
+            }
+            const bool freshTangent = mTangentAge == 0;
+
+            const Eigen::VectorXd dx = Direction(r);
+            rX += dx;
+            ++mTangentAge;
+
+            const Eigen::VectorXd rNew = residual(rX);
+            const double normNew = rNew.norm();
+            if (not std::isfinite(normNew) and freshTangent)
+            {
+                rX -= dx;
+                return result;
+            }
+            if (not freshTangent and (not std::isfinite(normNew) or normNew > result.mResidualNorm))
+            {
+                // the kept tangent is too far off, redo the step with a new one
+                rX -= dx;
+                fullNewton = true;
+                mHasTangent = false;
+                ++result.mNumFallbacks;
+                continue;
+            }
+
+            if (mOptions.mStrategy == eNewtonStrategy::LBFGS)
+                AddCorrection(dx, rNew - r);
+            if (normNew > mOptions.mMaxContraction * result.mResidualNorm)
+                mHasTangent = false;
+
+            r = rNew;
+            result.mResidualNorm = normNew;
+        }
+        result.mConverged = true;
+        return result;
+    }
+
+    //! @brief Forces a new tangent in the next iteration, e.g. after the constraints changed
+    void InvalidateTangent()
+    {
+        mHasTangent = false;
+    }
+
+    const Solver& GetSolver() const
+    {
+        return mSolver;
+    }
+
+private:
+    void Factorize(const Eigen::SparseMatrix<double>& rTangent)
+    {
+        mSolver.compute(rTangent);
+        if (mSolver.info() != Eigen::Success)
+            throw std::runtime_error("Factorization of the tangent failed");
+        mHasTangent = true;
+        mTangentAge = 0;
+        mCorrections.clear();
+    }
+
+    //! @brief -H r, H is the inverse of the kept tangent updated by the LBFGS two loop recursion
+    Eigen::VectorXd Direction(const Eigen::VectorXd& rResidual) const
+    {
+        if (mCorrections.empty())
+            return -mSolver.solve(rResidual);
+
+        Eigen::VectorXd q = rResidual;
+        std::vector<double> alpha(mCorrections.size());
+        for (int i = mCorrections.size() - 1; i >= 0; --i)
+        {
+            const Correction& c = mCorrections[i];
+            alpha[i] = c.mRho * c.mS.dot(q);
+            q -= alpha[i] * c.mY;
+        }
+        Eigen::VectorXd z = mSolver.solve(q);
+        for (size_t i = 0; i < mCorrections.size(); ++i)
+        {
+            const Correction& c = mCorrections[i];
+            const double beta = c.mRho * c.mY.dot(z);
+            z += (alpha[i] - beta) * c.mS;
+        }
+        return -z;
+    }
+
+    void AddCorrection(const Eigen::VectorXd& rS, const Eigen::VectorXd& rY)
+    {
+        const double sy = rS.dot(rY);
+        // skipping pairs with too small curvature keeps the update positive definite
+        if (sy <= 1.e-12 * rS.norm() * rY.norm())
+            return;
+        if (static_cast<int>(mCorrections.size()) == mOptions.mNumCorrectionPairs)
+            mCorrections.pop_front();
+        mCorrections.push_back({rS, rY, 1. / sy});
+    }
+
+    struct Correction
+    {
+        Eigen::VectorXd mS; //!< step
+        Eigen::VectorXd mY; //!< change of the residual
+        double mRho;
+    };
+
+    NewtonOptions mOptions;
+    Solver mSolver;
+    bool mHasTangent = false;
+    int mTangentAge = 0;
+    std::deque<Correction> mCorrections;
+};
+
+} // namespace NuTo
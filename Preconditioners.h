@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/LU>
+#include <eigen3/Eigen/Sparse>
+
+namespace NuTo
+{
+
+//! @brief Diagonal (Jacobi) preconditioner, works with dense and sparse matrices
+//!
+//! Zero diagonal entries are replaced by one, like Eigen::DiagonalPreconditioner does.
+class JacobiPreconditioner
+{
+public:
+    JacobiPreconditioner() = default;
+
+    template <typename MatrixType>
+    explicit JacobiPreconditioner(const MatrixType& rMatrix)
+    {
+        compute(rMatrix);
+    }
+
+    template <typename MatrixType>
+    JacobiPreconditioner& compute(const MatrixType& rMatrix)
+    {
+        mInverseDiagonal = rMatrix.diagonal();
+        for (int i = 0; i < mInverseDiagonal.rows(); ++i)
+            mInverseDiagonal[i] = mInverseDiagonal[i] != 0. ? 1. / mInverseDiagonal[i] : 1.;
+        return *this;
+    }
+
+    Eigen::VectorXd solve(const Eigen::VectorXd& rRhs) const
+    {
+        return mInverseDiagonal.cwiseProduct(rRhs);
+    }
+
+private:
+    Eigen::VectorXd mInverseDiagonal;
+};
+
+
+//! @brief Incomplete LU factorization without fill-in, ILU(0)
+//!
+//! The factors L (unit lower triangle) and U have exactly the sparsity pattern of the matrix and are stored
+//! together in one row major matrix. Setup and application are linear in the number of nonzeros.
+class ILU0Preconditioner
+{
+public:
+    using SparseMatrixCSR = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+    ILU0Preconditioner() = default;
+
+    template <typename MatrixType>
+    explicit ILU0Preconditioner(const MatrixType& rMatrix)
+    {
+        compute(rMatrix);
+    }
+
+    template <typename Derived>
+    ILU0Preconditioner& compute(const Eigen::SparseMatrixBase<Derived>& rMatrix)
+    {
+        mLU = rMatrix;
+        Factorize();
+        return *this;
+    }
+
+    template <typename Derived>
+    ILU0Preconditioner& compute(const Eigen::MatrixBase<Derived>& rMatrix)
+    {
+        mLU = rMatrix.sparseView();
+        for (int i = 0; i < mLU.rows(); ++i)
+            mLU.coeffRef(i, i) += 0.; // sparseView drops zero diagonal entries, the elimination may fill them
+        Factorize();
+        return *this;
+    }
+
+    Eigen::VectorXd solve(const Eigen::VectorXd& rRhs) const
+    {
+        const int n = mLU.rows();
+        const int* outer = mLU.outerIndexPtr();
+        const int* inner = mLU.innerIndexPtr();
+        const double* values = mLU.valuePtr();
+
+        // forward substitution with the unit lower triangle
+        Eigen::VectorXd x = rRhs;
+        for (int i = 0; i < n; ++i)
+            for (int k = outer[i]; k < mDiagonalIndex[i]; ++k)
+                x[i] -= values[k] * x[inner[k]];
+
+        // backward substitution with the upper triangle
+        for (int i = n - 1; i >= 0; --i)
+        {
+            for (int k = mDiagonalIndex[i] + 1; k < outer[i + 1]; ++k)
+                x[i] -= values[k] * x[inner[k]];
+            x[i] /= values[mDiagonalIndex[i]];
+        }
+        return x;
+    }
+
+private:
+    void Factorize()
+    {
+        mLU.makeCompressed();
+        const int n = mLU.rows();
+        const int* outer = mLU.outerIndexPtr();
+        const int* inner = mLU.innerIndexPtr();
+        double* values = mLU.valuePtr();
+
+        mDiagonalIndex.assign(n, -1);
+        for (int i = 0; i < n; ++i)
+            for (int k = outer[i]; k < outer[i + 1]; ++k)
+                if (inner[k] == i)
+                    mDiagonalIndex[i] = k;
+
+        // position of the entries of the current row, -1 if (i, j) is not in the pattern
+        std::vector<int> position(n, -1);
+        for (int i = 0; i < n; ++i)
+        {
+            if (mDiagonalIndex[i] < 0)
+                throw std::runtime_error("ILU0Preconditioner: no diagonal entry in row " + std::to_string(i));
+
+            for (int k = outer[i]; k < outer[i + 1]; ++k)
+                position[inner[k]] = k;
+
+            for (int k = outer[i]; k < mDiagonalIndex[i]; ++k)
+            {
+                const int row = inner[k];
+                values[k] /= values[mDiagonalIndex[row]];
+                for (int j = mDiagonalIndex[row] + 1; j < outer[row + 1]; ++j)
+                    if (position[inner[j]] >= 0)
+                        values[position[inner[j]]] -= values[k] * values[j];
+            }
+
+            // the pivot is final only after the elimination, which may fill a zero diagonal or cancel it
+            if (values[mDiagonalIndex[i]] == 0.)
+                throw std::runtime_error("ILU0Preconditioner: zero pivot in row " + std::to_string(i));
+
+            for (int k = outer[i]; k < outer[i + 1]; ++k)
+                position[inner[k]] = -1;
+        }
+    }
+
+    SparseMatrixCSR mLU;
+    std::vector<int> mDiagonalIndex;
+};
+
+
+//! @brief Block Jacobi preconditioner with dense LU factorizations of the diagonal blocks
+//!
+//! The blocks are contiguous and have a fixed size, e.g. the number of dofs per node, the last one may be
+//! smaller. Entries outside the diagonal blocks are ignored.
+class BlockJacobiPreconditioner
+{
+public:
+    explicit BlockJacobiPreconditioner(int rBlockSize = 2)
+        : mBlockSize(rBlockSize)
+    {
+    }
+
+    template <typename MatrixType>
+    BlockJacobiPreconditioner(const MatrixType& rMatrix, int rBlockSize)
+        : mBlockSize(rBlockSize)
+    {
+        compute(rMatrix);
+    }
+
+    template <typename Derived>
+    BlockJacobiPreconditioner& compute(const Eigen::SparseMatrixBase<Derived>& rMatrix)
+    {
+        const Eigen::SparseMatrix<double> matrix = rMatrix;
+        std::vector<Eigen::MatrixXd> blocks = ZeroBlocks(matrix.rows());
+        for (int col = 0; col < matrix.outerSize(); ++col)
+            for (Eigen::SparseMatrix<double>::InnerIterator it(matrix, col); it; ++it)
+                if (it.row() / mBlockSize == col / mBlockSize)
+                    blocks[col / mBlockSize](it.row() % mBlockSize, col % mBlockSize) = it.value();
+        Factorize(blocks);
+        return *this;
+    }
+
+    template <typename Derived>
+    BlockJacobiPreconditioner& compute(const Eigen::MatrixBase<Derived>& rMatrix)
+    {
+        std::vector<Eigen::MatrixXd> blocks = ZeroBlocks(rMatrix.rows());
+        for (unsigned int iBlock = 0; iBlock < blocks.size(); ++iBlock)
+            blocks[iBlock] = rMatrix.block(iBlock * mBlockSize, iBlock * mBlockSize, blocks[iBlock].rows(),
+                                           blocks[iBlock].cols());
+        Factorize(blocks);
+        return *this;
+    }
+
+    Eigen::VectorXd solve(const Eigen::VectorXd& rRhs) const
+    {
+        Eigen::VectorXd x(rRhs.rows());
+        for (unsigned int iBlock = 0; iBlock < mFactorizations.size(); ++iBlock)
+        {
+            const int size = mFactorizations[iBlock].rows();
+            x.segment(iBlock * mBlockSize, size) =
+                    mFactorizations[iBlock].solve(rRhs.segment(iBlock * mBlockSize, size));
+        }
+        return x;
+    }
+
+private:
+    std::vector<Eigen::MatrixXd> ZeroBlocks(int rNumRows) const
+    {
+        std::vector<Eigen::MatrixXd> blocks;
+        for (int start = 0; start < rNumRows; start += mBlockSize)
+        {
+            const int size = std::min(mBlockSize, rNumRows - start);
+            blocks.push_back(Eigen::MatrixXd::Zero(size, size));
+        }
+        return blocks;
+    }
+
+    void Factorize(const std::vector<Eigen::MatrixXd>& rBlocks)
+    {
+        mFactorizations.clear();
+        for (const auto& block : rBlocks)
+            mFactorizations.emplace_back(block);
+    }
+
+    int mBlockSize;
+    std::vector<Eigen::PartialPivLU<Eigen::MatrixXd>> mFactorizations;
+};
+
+} // namespace NuTo
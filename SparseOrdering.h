@@ -0,0 +1,613 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Sparse>
+#include <eigen3/Eigen/OrderingMethods>
+#include "2dExamples/MeshPartitioner.h"
+
+namespace NuTo
+{
+
+//! @brief Fill-reducing orderings of the local solvers
+enum class eOrdering
+{
+    Natural,
+    AMD, //!< approximate minimum degree of A + Aᵀ, Eigen
+    COLAMD, //!< column approximate minimum degree, Eigen, the former default of all FETI drivers
+    NestedDissection, //!< multilevel nested dissection with minimum degree on the leaves
+    RCM //!< reverse Cuthill-McKee, a bandwidth reduction
+};
+
+
+inline const std::vector<std::pair<eOrdering, std::string>>& OrderingNames()
+{
+    static const std::vector<std::pair<eOrdering, std::string>> names = {{eOrdering::Natural, "Natural"},
+                                                                          {eOrdering::AMD, "AMD"},
+                                                                          {eOrdering::COLAMD, "COLAMD"},
+                                                                          {eOrdering::NestedDissection, "ND"},
+                                                                          {eOrdering::RCM, "RCM"}};
+    return names;
+}
+
+inline std::string OrderingName(eOrdering ordering)
+{
+    for (const auto& name : OrderingNames())
+        if (name.first == ordering)
+            return name.second;
+    return "unknown";
+}
+
+//! @brief Ordering of a name of OrderingNames, e.g. "ND", throws for unknown names
+inline eOrdering OrderingFromName(const std::string& rName)
+{
+    for (const auto& name : OrderingNames())
+        if (name.second == rName)
+            return name.first;
+    throw std::runtime_error("Unknown ordering "s + rName + ", use Natural, AMD, COLAMD, ND or RCM");
+}
+
+
+//! @brief Adjacency graph of the pattern of A + Aᵀ without the diagonal, all weights are one
+template <typename MatrixType>
+::Graph SymmetricPatternGraph(const MatrixType& rMatrix)
+{
+    const int n = rMatrix.cols();
+    std::vector<std::vector<int>> neighbours(n);
+    for (int col = 0; col < rMatrix.outerSize(); ++col)
+        for (typename MatrixType::InnerIterator it(rMatrix, col); it; ++it)
+            if (it.row() != it.col())
+            {
+                neighbours[it.row()].push_back(it.col());
+                neighbours[it.col()].push_back(it.row());
+            }
+
+    ::Graph graph;
+    graph.mOffsets.reserve(n + 1);
+    for (auto& vertexNeighbours : neighbours)
+    {
+        std::sort(vertexNeighbours.begin(), vertexNeighbours.end());
+        vertexNeighbours.erase(std::unique(vertexNeighbours.begin(), vertexNeighbours.end()), vertexNeighbours.end());
+        graph.mAdjacency.insert(graph.mAdjacency.end(), vertexNeighbours.begin(), vertexNeighbours.end());
+        graph.mOffsets.push_back(graph.mAdjacency.size());
+        std::vector<int>().swap(vertexNeighbours);
+    }
+    graph.mEdgeWeights.assign(graph.mAdjacency.size(), 1);
+    graph.mVertexWeights.assign(n, 1);
+    return graph;
+}
+
+
+//! @brief Subgraph of the vertices \a rVertices, they are renumbered in the given order
+inline ::Graph InducedSubGraph(const ::Graph& rGraph, const std::vector<int>& rVertices, std::vector<int>& rLocal)
+{
+    for (size_t i = 0; i < rVertices.size(); ++i)
+        rLocal[rVertices[i]] = i;
+
+    ::Graph sub;
+    sub.mOffsets.reserve(rVertices.size() + 1);
+    sub.mVertexWeights.reserve(rVertices.size());
+    for (const int v : rVertices)
+    {
+        for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+            if (rLocal[rGraph.mAdjacency[i]] != -1)
+            {
+                sub.mAdjacency.push_back(rLocal[rGraph.mAdjacency[i]]);
+                sub.mEdgeWeights.push_back(rGraph.mEdgeWeights[i]);
+            }
+        sub.mOffsets.push_back(sub.mAdjacency.size());
+        sub.mVertexWeights.push_back(rGraph.mVertexWeights[v]);
+    }
+
+    for (const int v : rVertices)
+        rLocal[v] = -1;
+    return sub;
+}
+
+
+//! @brief Connected components, every component lists its vertices in breadth first order
+inline std::vector<std::vector<int>> ConnectedComponents(const ::Graph& rGraph)
+{
+    std::vector<std::vector<int>> components;
+    std::vector<char> visited(rGraph.size(), 0);
+    for (int start = 0; start < rGraph.size(); ++start)
+    {
+        if (visited[start])
+            continue;
+        components.emplace_back(1, start);
+        std::vector<int>& component = components.back();
+        visited[start] = 1;
+        for (size_t next = 0; next < component.size(); ++next)
+        {
+            const int v = component[next];
+            for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                if (not visited[rGraph.mAdjacency[i]])
+                {
+                    visited[rGraph.mAdjacency[i]] = 1;
+                    component.push_back(rGraph.mAdjacency[i]);
+                }
+        }
+    }
+    return components;
+}
+
+
+//! @brief Reverse Cuthill-McKee, returns the vertices in elimination order
+//!
+//! Every component starts at a pseudo-peripheral vertex of minimum degree found by repeated breadth first
+//! searches (George and Liu), neighbours are visited by increasing degree.
+inline std::vector<int> ReverseCuthillMcKee(const ::Graph& rGraph)
+{
+    const int n = rGraph.size();
+    auto degree = [&](int v) { return rGraph.mOffsets[v + 1] - rGraph.mOffsets[v]; };
+
+    std::vector<int> level(n, -1);
+    auto levelStructure = [&](int root, std::vector<int>& rVisited) {
+        for (const int v : rVisited)
+            level[v] = -1;
+        rVisited.assign(1, root);
+        level[root] = 0;
+        for (size_t next = 0; next < rVisited.size(); ++next)
+        {
+            const int v = rVisited[next];
+            for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                if (level[rGraph.mAdjacency[i]] == -1)
+                {
+                    level[rGraph.mAdjacency[i]] = level[v] + 1;
+                    rVisited.push_back(rGraph.mAdjacency[i]);
+                }
+        }
+        return level[rVisited.back()];
+    };
+
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> numbered(n, 0);
+    std::vector<int> visited;
+    for (const auto& component : ConnectedComponents(rGraph))
+    {
+        int root = *std::min_element(component.begin(), component.end(),
+                                     [&](int a, int b) { return degree(a) < degree(b); });
+        visited.clear();
+        int eccentricity = levelStructure(root, visited);
+        for (;;)
+        {
+            // vertex of minimum degree on the last level
+            int candidate = visited.back();
+            for (auto it = visited.rbegin(); it != visited.rend() and level[*it] == eccentricity; ++it)
+                if (degree(*it) < degree(candidate))
+                    candidate = *it;
+            const int candidateEccentricity = levelStructure(candidate, visited);
+            if (candidateEccentricity <= eccentricity)
+                break;
+            root = candidate;
+            eccentricity = candidateEccentricity;
+        }
+        for (const int v : visited)
+            level[v] = -1;
+
+        const size_t first = order.size();
+        order.push_back(root);
+        numbered[root] = 1;
+        std::vector<int> neighbours;
+        for (size_t next = first; next < order.size(); ++next)
+        {
+            const int v = order[next];
+            neighbours.clear();
+            for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                if (not numbered[rGraph.mAdjacency[i]])
+                {
+                    numbered[rGraph.mAdjacency[i]] = 1;
+                    neighbours.push_back(rGraph.mAdjacency[i]);
+                }
+            std::stable_sort(neighbours.begin(), neighbours.end(),
+                             [&](int a, int b) { return degree(a) < degree(b); });
+            order.insert(order.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+
+//! @brief Minimum degree on the pattern of \a rGraph by Eigen's AMD, returns the vertices in elimination order
+inline std::vector<int> MinimumDegree(const ::Graph& rGraph)
+{
+    const int n = rGraph.size();
+    Eigen::SparseMatrix<double, Eigen::ColMajor, int> pattern(n, n);
+    std::vector<int> numNonZeros(n);
+    for (int v = 0; v < n; ++v)
+        numNonZeros[v] = rGraph.mOffsets[v + 1] - rGraph.mOffsets[v] + 1;
+    pattern.reserve(numNonZeros);
+    for (int v = 0; v < n; ++v)
+    {
+        pattern.insert(v, v) = 1.;
+        for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+            pattern.insert(rGraph.mAdjacency[i], v) = 1.;
+    }
+    pattern.makeCompressed();
+
+    Eigen::AMDOrdering<int>::PermutationType permutation;
+    Eigen::AMDOrdering<int>()(pattern, permutation);
+    return std::vector<int>(permutation.indices().data(), permutation.indices().data() + n);
+}
+
+
+//! @brief Vertex separator of a bisection, a minimum vertex cover of the cut edges (König's theorem)
+//!
+//! The cut edges form a bipartite graph between the boundary vertices of both sides. A maximum matching of it
+//! gives a minimum cover: unmatched side 0 vertices and everything reachable from them by alternating paths is
+//! Z, the cover is (side 0 boundary \ Z) ∪ (side 1 boundary ∩ Z).
+inline std::vector<int> VertexSeparator(const ::Graph& rGraph, const std::vector<int>& rSide)
+{
+    const int n = rGraph.size();
+    std::vector<int> boundary0;
+    for (int v = 0; v < n; ++v)
+        if (rSide[v] == 0)
+            for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+                if (rSide[rGraph.mAdjacency[i]] == 1)
+                {
+                    boundary0.push_back(v);
+                    break;
+                }
+
+    // augmenting paths from every side 0 vertex, depth first
+    std::vector<int> mate(n, -1);
+    std::vector<int> visitedIn(n, -1);
+    std::vector<std::pair<int, int>> stack;
+    for (size_t round = 0; round < boundary0.size(); ++round)
+    {
+        stack.assign(1, {boundary0[round], rGraph.mOffsets[boundary0[round]]});
+        visitedIn[boundary0[round]] = round;
+        bool augmented = false;
+        while (not stack.empty() and not augmented)
+        {
+            auto& top = stack.back();
+            const int v = top.first;
+            if (top.second == rGraph.mOffsets[v + 1])
+            {
+                stack.pop_back();
+                continue;
+            }
+            const int u = rGraph.mAdjacency[top.second++];
+            if (rSide[u] != 1 or visitedIn[u] == static_cast<int>(round))
+                continue;
+            visitedIn[u] = round;
+            if (mate[u] == -1)
+            {
+                // flip the matching along the path
+                int free = u;
+                for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+                {
+                    const int previous = mate[it->first];
+                    mate[it->first] = free;
+                    mate[free] = it->first;
+                    free = previous;
+                }
+                augmented = true;
+            }
+            else if (visitedIn[mate[u]] != static_cast<int>(round))
+            {
+                visitedIn[mate[u]] = round;
+                stack.emplace_back(mate[u], rGraph.mOffsets[mate[u]]);
+            }
+        }
+    }
+
+    std::vector<char> inZ(n, 0);
+    std::vector<int> queue;
+    for (const int v : boundary0)
+        if (mate[v] == -1)
+        {
+            inZ[v] = 1;
+            queue.push_back(v);
+        }
+    for (size_t next = 0; next < queue.size(); ++next)
+    {
+        const int v = queue[next];
+        for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+        {
+            const int u = rGraph.mAdjacency[i];
+            if (rSide[u] != 1 or inZ[u])
+                continue;
+            inZ[u] = 1;
+            if (mate[u] != -1 and not inZ[mate[u]])
+            {
+                inZ[mate[u]] = 1;
+                queue.push_back(mate[u]);
+            }
+        }
+    }
+
+    std::vector<int> separator;
+    for (const int v : boundary0)
+        if (not inZ[v])
+            separator.push_back(v);
+    for (int v = 0; v < n; ++v)
+        if (rSide[v] == 1 and inZ[v])
+            separator.push_back(v);
+    return separator;
+}
+
+
+//! @brief Multilevel nested dissection, returns the vertices in elimination order
+//!
+//! Bisects the graph with GraphPartitioner, turns the edge cut into a minimum vertex separator and numbers the
+//! separator last, both halves recursively before it. Graphs below \a leafSize vertices are ordered by minimum
+//! degree. Vertices with identical neighbourhoods, e.g. the dofs of one node, are merged beforehand, which
+//! shrinks the graph of a 3D displacement problem by a factor of three in vertices and nine in edges.
+inline std::vector<int> NestedDissection(const ::Graph& rGraph, int leafSize = 200)
+{
+    const int n = rGraph.size();
+
+    // merge indistinguishable vertices: equal closed neighbourhoods
+    std::vector<std::pair<std::size_t, int>> keys(n);
+    for (int v = 0; v < n; ++v)
+    {
+        std::size_t hash = v;
+        for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+            hash += rGraph.mAdjacency[i];
+        keys[v] = {hash * 31 + rGraph.mOffsets[v + 1] - rGraph.mOffsets[v], v};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    auto sameClosedNeighbourhood = [&](int a, int b) {
+        const int degree = rGraph.mOffsets[a + 1] - rGraph.mOffsets[a];
+        if (degree != rGraph.mOffsets[b + 1] - rGraph.mOffsets[b])
+            return false;
+        // a and b are adjacent and their neighbourhoods agree up to swapping a and b
+        const int* na = &rGraph.mAdjacency[rGraph.mOffsets[a]];
+        const int* nb = &rGraph.mAdjacency[rGraph.mOffsets[b]];
+        if (not std::binary_search(na, na + degree, b))
+            return false;
+        for (int i = 0, j = 0; i < degree or j < degree;)
+        {
+            if (i < degree and na[i] == b)
+                ++i;
+            else if (j < degree and nb[j] == a)
+                ++j;
+            else if (i < degree and j < degree and na[i] == nb[j])
+                ++i, ++j;
+            else
+                return false;
+        }
+        return true;
+    };
+
+    std::vector<int> superVertex(n, -1);
+    std::vector<std::vector<int>> members;
+    for (size_t first = 0; first < keys.size();)
+    {
+        size_t last = first;
+        while (last < keys.size() and keys[last].first == keys[first].first)
+            ++last;
+        for (size_t i = first; i < last; ++i)
+        {
+            const int v = keys[i].second;
+            if (superVertex[v] != -1)
+                continue;
+            superVertex[v] = members.size();
+            members.emplace_back(1, v);
+            for (size_t j = i + 1; j < last; ++j)
+                if (superVertex[keys[j].second] == -1 and sameClosedNeighbourhood(v, keys[j].second))
+                {
+                    superVertex[keys[j].second] = superVertex[v];
+                    members.back().push_back(keys[j].second);
+                }
+        }
+        first = last;
+    }
+
+    // quotient graph, numbered by the smallest member to keep the locality of the input
+    std::vector<int> representatives(members.size());
+    for (size_t s = 0; s < members.size(); ++s)
+        representatives[s] = s;
+    std::sort(representatives.begin(), representatives.end(),
+              [&](int a, int b) { return members[a].front() < members[b].front(); });
+    std::vector<int> renumber(members.size());
+    for (size_t s = 0; s < representatives.size(); ++s)
+        renumber[representatives[s]] = s;
+
+    ::Graph quotient;
+    quotient.mOffsets.reserve(members.size() + 1);
+    std::vector<int> mark(members.size(), -1);
+    for (size_t s = 0; s < representatives.size(); ++s)
+    {
+        const int v = members[representatives[s]].front();
+        mark[s] = s;
+        for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+        {
+            const int t = renumber[superVertex[rGraph.mAdjacency[i]]];
+            if (mark[t] != static_cast<int>(s))
+            {
+                mark[t] = s;
+                quotient.mAdjacency.push_back(t);
+            }
+        }
+        std::sort(quotient.mAdjacency.begin() + quotient.mOffsets.back(), quotient.mAdjacency.end());
+        quotient.mOffsets.push_back(quotient.mAdjacency.size());
+        quotient.mVertexWeights.push_back(members[representatives[s]].size());
+    }
+    quotient.mEdgeWeights.assign(quotient.mAdjacency.size(), 1);
+
+    PartitionOptions options;
+    options.mImbalance = 1.2;
+    options.mNumInitialTrials = 4;
+    GraphPartitioner partitioner(options);
+
+    std::vector<int> quotientOrder;
+    quotientOrder.reserve(quotient.size());
+    std::vector<int> local(quotient.size(), -1);
+
+    // explicit stack of subgraphs and their quotient vertices
+    struct Task
+    {
+        ::Graph mGraph;
+        std::vector<int> mVertices;
+    };
+    std::vector<Task> stack(1);
+    stack.back().mGraph = std::move(quotient);
+    stack.back().mVertices.resize(stack.back().mGraph.size());
+    std::iota(stack.back().mVertices.begin(), stack.back().mVertices.end(), 0);
+
+    // the halves are pushed in reverse, so the final order is half 0, half 1, separator
+    std::vector<int> reversedOrder;
+    while (not stack.empty())
+    {
+        Task task = std::move(stack.back());
+        stack.pop_back();
+
+        if (task.mGraph.size() <= leafSize)
+        {
+            const std::vector<int> leafOrder = MinimumDegree(task.mGraph);
+            for (auto it = leafOrder.rbegin(); it != leafOrder.rend(); ++it)
+                reversedOrder.push_back(task.mVertices[*it]);
+            continue;
+        }
+
+        const auto components = ConnectedComponents(task.mGraph);
+        std::vector<int> side;
+        std::vector<int> separator;
+        if (components.size() == 1)
+        {
+            side = partitioner.Partition(task.mGraph, 2);
+            separator = VertexSeparator(task.mGraph, side);
+            for (auto it = separator.rbegin(); it != separator.rend(); ++it)
+                reversedOrder.push_back(task.mVertices[*it]);
+            for (const int v : separator)
+                side[v] = 2;
+        }
+        else
+        {
+            side.resize(task.mGraph.size());
+            for (size_t c = 0; c < components.size(); ++c)
+                for (const int v : components[c])
+                    side[v] = c;
+        }
+
+        const int numParts = std::max<int>(2, components.size());
+        std::vector<std::vector<int>> partVertices(numParts);
+        for (int v = 0; v < task.mGraph.size(); ++v)
+            if (side[v] < numParts)
+                partVertices[side[v]].push_back(v);
+
+        for (int part = 0; part < numParts; ++part)
+        {
+            if (partVertices[part].empty())
+                continue;
+            Task sub;
+            sub.mGraph = InducedSubGraph(task.mGraph, partVertices[part], local);
+            sub.mVertices.resize(partVertices[part].size());
+            for (size_t i = 0; i < partVertices[part].size(); ++i)
+                sub.mVertices[i] = task.mVertices[partVertices[part][i]];
+            stack.push_back(std::move(sub));
+        }
+    }
+    quotientOrder.assign(reversedOrder.rbegin(), reversedOrder.rend());
+
+    std::vector<int> order;
+    order.reserve(n);
+    for (const int s : quotientOrder)
+        for (const int v : members[representatives[s]])
+            order.push_back(v);
+    return order;
+}
+
+
+//! @brief Elimination order of the columns of \a rMatrix by \a ordering
+template <typename MatrixType>
+std::vector<int> EliminationOrder(const MatrixType& rMatrix, eOrdering ordering)
+{
+    const int n = rMatrix.cols();
+    std::vector<int> order(n);
+    switch (ordering)
+    {
+    case eOrdering::Natural:
+        std::iota(order.begin(), order.end(), 0);
+        break;
+    case eOrdering::AMD:
+    {
+        // Eigen's AMD returns the elimination order (new -> old)
+        Eigen::AMDOrdering<int>::PermutationType permutation;
+        Eigen::AMDOrdering<int>()(rMatrix, permutation);
+        std::copy_n(permutation.indices().data(), n, order.begin());
+        break;
+    }
+    case eOrdering::COLAMD:
+    {
+        // Eigen's COLAMD returns the position of every column (old -> new)
+        Eigen::SparseMatrix<typename MatrixType::Scalar, Eigen::ColMajor, int> compressed = rMatrix;
+        compressed.makeCompressed();
+        Eigen::COLAMDOrdering<int>::PermutationType permutation;
+        Eigen::COLAMDOrdering<int>()(compressed, permutation);
+        for (int i = 0; i < n; ++i)
+            order[permutation.indices()[i]] = i;
+        break;
+    }
+    case eOrdering::NestedDissection:
+        order = NestedDissection(SymmetricPatternGraph(rMatrix));
+        break;
+    case eOrdering::RCM:
+        order = ReverseCuthillMcKee(SymmetricPatternGraph(rMatrix));
+        break;
+    }
+    return order;
+}
+
+
+//! @brief Fill-reducing ordering selected at run time, a drop-in for the OrderingType of Eigen's SparseLU
+//!
+//! Eigen's solvers default construct their ordering, so the choice is process wide: Set() it before the local
+//! solver is analyzed, or export NUTO_ORDERING=AMD|COLAMD|ND|RCM|Natural. Without either it is COLAMD, the
+//! ordering the FETI drivers used so far.
+//!
+//! SparseLU expects the position of every column (old -> new), while the simplicial Cholesky solvers expect the
+//! elimination order (new -> old), e.g. Eigen's AMDOrdering fills in several times more in SparseLU than in
+//! SimplicialLDLT. Use SelectableOrdering for SparseLU and SelectableSymmetricOrdering for SimplicialLDLT/LLT.
+template <typename StorageIndex, bool tEliminationOrder = false>
+class SelectableOrdering
+{
+public:
+    typedef Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, StorageIndex> PermutationType;
+
+    static void Set(eOrdering ordering)
+    {
+        Selected() = ordering;
+    }
+
+    static eOrdering Get()
+    {
+        return Selected();
+    }
+
+    template <typename MatrixType>
+    void operator()(const MatrixType& rMatrix, PermutationType& rPermutation)
+    {
+        const std::vector<int> order = EliminationOrder(rMatrix, Selected());
+        rPermutation.resize(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            if (tEliminationOrder)
+                rPermutation.indices()[i] = order[i];
+            else
+                rPermutation.indices()[order[i]] = i;
+        }
+    }
+
+private:
+    static eOrdering& Selected()
+    {
+        static eOrdering ordering =
+                std::getenv("NUTO_ORDERING") ? OrderingFromName(std::getenv("NUTO_ORDERING")) : eOrdering::COLAMD;
+        return ordering;
+    }
+};
+
+template <typename StorageIndex>
+using SelectableSymmetricOrdering = SelectableOrdering<StorageIndex, true>;
+
+} // namespace NuTo
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <eigen3/Eigen/Sparse>
+
+namespace NuTo
+{
+
+//! @brief Eigen sparse solver that runs the symbolic analysis only when the sparsity pattern changes
+//!
+//! Between Newton iterations and time steps the pattern of the stiffness matrix stays the same, only its values
+//! change. compute() therefore compares the pattern with the one of the last analysis and, if it is equal, only
+//! calls factorize(). A changed dof numbering, e.g. after new constraints or a repartitioning, changes the pattern
+//! and triggers a full analysis. Drop-in for the EigenSolver of NewmarkFeti and for SolverEigen, it also wraps
+//! Eigen::MixedPrecisionSolver:
+//!
+//!     using EigenSolver = NuTo::SymbolicReuseSolver<Eigen::SparseLU<Eigen::SparseMatrix<double>>>;
+template <typename Solver>
+class SymbolicReuseSolver
+{
+public:
+    using MatrixType = typename Solver::MatrixType;
+    using Scalar = typename MatrixType::Scalar;
+    using Index = typename MatrixType::Index;
+    //! @brief Type of the stored indices, MatrixType::Index in Eigen 3.2 and MatrixType::StorageIndex from 3.3 on
+    using PatternIndex = typename std::decay<decltype(*std::declval<const MatrixType&>().outerIndexPtr())>::type;
+
+    SymbolicReuseSolver() = default;
+
+    explicit SymbolicReuseSolver(const MatrixType& rMatrix)
+    {
+        compute(rMatrix);
+    }
+
+    //! @brief Analyzes the pattern if it differs from the last one and factorizes
+    SymbolicReuseSolver& compute(const MatrixType& rMatrix)
+    {
+        if (rMatrix.isCompressed())
+            Compute(rMatrix);
+        else
+        {
+            MatrixType compressed = rMatrix;
+            compressed.makeCompressed();
+            Compute(compressed);
+        }
+        return *this;
+    }
+
+    //! @brief Forces a symbolic analysis, the next compute() only factorizes if the pattern is the same
+    void analyzePattern(const MatrixType& rMatrix)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        mSolver.analyzePattern(rMatrix);
+        mAnalyzeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++mNumAnalyses;
+
+        mOuterIndices.assign(rMatrix.outerIndexPtr(), rMatrix.outerIndexPtr() + rMatrix.outerSize() + 1);
+        mInnerIndices.assign(rMatrix.innerIndexPtr(), rMatrix.innerIndexPtr() + rMatrix.nonZeros());
+        mRows = rMatrix.rows();
+    }
+
+    void factorize(const MatrixType& rMatrix)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        mSolver.factorize(rMatrix);
+        mFactorizeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++mNumFactorizations;
+    }
+
+    template <typename Rhs>
+    auto solve(const Eigen::MatrixBase<Rhs>& rRhs) const
+    {
+        return mSolver.solve(rRhs);
+    }
+
+    Eigen::ComputationInfo info() const
+    {
+        return mSolver.info();
+    }
+
+    Index rows() const
+    {
+        return mSolver.rows();
+    }
+
+    Index cols() const
+    {
+        return mSolver.cols();
+    }
+
+    //! @brief Wrapped solver, e.g. for its factors
+    const Solver& GetSolver() const
+    {
+        return mSolver;
+    }
+
+    int GetNumAnalyses() const
+    {
+        return mNumAnalyses;
+    }
+
+    int GetNumFactorizations() const
+    {
+        return mNumFactorizations;
+    }
+
+    //! @brief Seconds spent in the symbolic analysis
+    double GetAnalyzeTime() const
+    {
+        return mAnalyzeTime;
+    }
+
+    //! @brief Seconds spent in the numerical factorization
+    double GetFactorizeTime() const
+    {
+        return mFactorizeTime;
+    }
+
+private:
+    void Compute(const MatrixType& rMatrix)
+    {
+        if (not HasSamePattern(rMatrix))
+            analyzePattern(rMatrix);
+        factorize(rMatrix);
+
+        // a failed factorization may leave the symbolic data of a solver unusable, start over next time
+        if (mSolver.info() != Eigen::Success)
+            mOuterIndices.clear();
+    }
+
+    bool HasSamePattern(const MatrixType& rMatrix) const
+    {
+        return not mOuterIndices.empty() and rMatrix.rows() == mRows and
+               rMatrix.outerSize() + 1 == static_cast<Index>(mOuterIndices.size()) and
+               rMatrix.nonZeros() == static_cast<Index>(mInnerIndices.size()) and
+               std::equal(mOuterIndices.begin(), mOuterIndices.end(), rMatrix.outerIndexPtr()) and
+               std::equal(mInnerIndices.begin(), mInnerIndices.end(), rMatrix.innerIndexPtr());
+    }
+
+    Solver mSolver;
+    std::vector<PatternIndex> mOuterIndices; //!< pattern of the last analysis, empty if there was none
+    std::vector<PatternIndex> mInnerIndices;
+    Index mRows = 0;
+
+    int mNumAnalyses = 0;
+    int mNumFactorizations = 0;
+    double mAnalyzeTime = 0.;
+    double mFactorizeTime = 0.;
+};
+
+} // namespace NuTo
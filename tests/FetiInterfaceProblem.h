@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/QR>
+#include <eigen3/Eigen/Sparse>
+#include <eigen3/unsupported/Eigen/SparseExtra>
+
+//! @brief Interface problem of a FETI decomposition: F λ - G α = d, Gᵀ λ = e
+struct FetiInterfaceProblem
+{
+    Eigen::MatrixXd F;
+    Eigen::MatrixXd G;
+    Eigen::VectorXd d;
+    Eigen::VectorXd e;
+};
+
+
+//! @brief Poisson problem on a row of square subdomains with numNodes x numNodes nodes each
+//!
+//! Only the leftmost subdomain is fixed, all others are floating. Neighbouring subdomains are glued along
+//! their common edge by one Lagrange multiplier per node.
+inline FetiInterfaceProblem CreateFetiInterfaceProblem(int numSubdomains, int numNodes)
+{
+    const int numDofs = numNodes * numNodes;
+    const double h = 1. / (numNodes - 1);
+
+    // graph laplacian of the subdomain grid, singular with the constant vector as kernel
+    Eigen::MatrixXd K = Eigen::MatrixXd::Zero(numDofs, numDofs);
+    auto connect = [&](int i, int j) {
+        K(i, i) += 1.;
+        K(j, j) += 1.;
+        K(i, j) -= 1.;
+        K(j, i) -= 1.;
+    };
+    for (int row = 0; row < numNodes; ++row)
+        for (int col = 0; col < numNodes; ++col)
+        {
+            const int node = row * numNodes + col;
+            if (col + 1 < numNodes)
+                connect(node, node + 1);
+            if (row + 1 < numNodes)
+                connect(node, node + numNodes);
+        }
+
+    Eigen::MatrixXd KFixed = K;
+    for (int row = 0; row < numNodes; ++row)
+        KFixed(row * numNodes, row * numNodes) += 1.e3;
+
+    const Eigen::MatrixXd KPseudoInverse = K.completeOrthogonalDecomposition().pseudoInverse();
+    const Eigen::MatrixXd KFixedInverse = KFixed.inverse();
+    const Eigen::VectorXd R = Eigen::VectorXd::Ones(numDofs);
+
+    const int numMultipliers = (numSubdomains - 1) * numNodes;
+    FetiInterfaceProblem problem;
+    problem.F = Eigen::MatrixXd::Zero(numMultipliers, numMultipliers);
+    problem.G = Eigen::MatrixXd::Zero(numMultipliers, numSubdomains - 1);
+    problem.d = Eigen::VectorXd::Zero(numMultipliers);
+    problem.e = Eigen::VectorXd::Zero(numSubdomains - 1);
+
+    for (int subdomain = 0; subdomain < numSubdomains; ++subdomain)
+    {
+        // connectivity matrix, +1 on the right edge, -1 on the left edge
+        Eigen::MatrixXd B = Eigen::MatrixXd::Zero(numMultipliers, numDofs);
+        for (int row = 0; row < numNodes; ++row)
+        {
+            if (subdomain + 1 < numSubdomains)
+                B(subdomain * numNodes + row, row * numNodes + numNodes - 1) = 1.;
+            if (subdomain > 0)
+                B((subdomain - 1) * numNodes + row, row * numNodes) = -1.;
+        }
+
+        // load varying between the subdomains and along the interfaces
+        Eigen::VectorXd f(numDofs);
+        for (int node = 0; node < numDofs; ++node)
+            f[node] = h * h * (1. + subdomain) * (1. + node / numNodes);
+
+        const Eigen::MatrixXd& KInverse = subdomain == 0 ? KFixedInverse : KPseudoInverse;
+        problem.F += B * KInverse * B.transpose();
+        problem.d += B * KInverse * f;
+        if (subdomain > 0)
+        {
+            problem.G.col(subdomain - 1) = B * R;
+            problem.e[subdomain - 1] = R.dot(f);
+        }
+    }
+    return problem;
+}
+
+
+//! @brief Loads a saved interface problem prefixF.mtx, prefixG.mtx, prefixd.mtx and prefixe.mtx
+inline FetiInterfaceProblem LoadFetiInterfaceProblem(const std::string& prefix)
+{
+    Eigen::SparseMatrix<double> F, G;
+    FetiInterfaceProblem problem;
+    if (not Eigen::loadMarket(F, prefix + "F.mtx") or not Eigen::loadMarket(G, prefix + "G.mtx") or
+        not Eigen::loadMarketVector(problem.d, prefix + "d.mtx") or
+        not Eigen::loadMarketVector(problem.e, prefix + "e.mtx"))
+        throw std::runtime_error("Could not read the interface problem " + prefix);
+    problem.F = F;
+    problem.G = G;
+    return problem;
+}
+
+
+//! @brief Symmetric application P M⁻¹ P of a preconditioner M, keeps CPG consistent with the projection
+template <typename Preconditioner, typename ProjectionType = Eigen::MatrixXd>
+class ProjectedPreconditioner
+{
+public:
+    using VectorType = Eigen::Matrix<typename ProjectionType::Scalar, Eigen::Dynamic, 1>;
+
+    ProjectedPreconditioner(const ProjectionType& projection, const Preconditioner& precond)
+        : mProjection(projection)
+        , mPrecond(precond)
+    {
+    }
+
+    VectorType solve(const VectorType& rhs) const
+    {
+        return mProjection * mPrecond.solve(VectorType(mProjection * rhs));
+    }
+
+private:
+    const ProjectionType& mProjection;
+    const Preconditioner& mPrecond;
+};
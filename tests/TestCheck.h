@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//! @brief Number of failed checks of the test executable
+inline int& NumFailures()
+{
+    static int numFailures = 0;
+    return numFailures;
+}
+
+
+//! @brief Prints the result of a single check and counts it if it failed
+inline void Check(bool condition, const std::string& message)
+{
+    std::cout << (condition ? "[passed] " : "[FAILED] ") << message << std::endl;
+    if (not condition)
+        ++NumFailures();
+}
+
+
+//! @brief Prints the number of failed checks, returns the exit code of the test executable
+inline int TestResult()
+{
+    std::cout << "\n" << NumFailures() << " failures" << std::endl;
+    return NumFailures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,156 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "../2dExamples/ColoredAssembly.h"
+#include "TestCheck.h"
+
+
+//! @brief numX x numY quads, every second one split into two triangles, node ids are not contiguous
+ImportContainer MixedMesh(int numX, int numY)
+{
+    ImportContainer mesh;
+    auto nodeId = [&](int col, int row) { return 3 * (row * (numX + 1) + col) + 7; };
+    for (int row = 0; row <= numY; ++row)
+        for (int col = 0; col <= numX; ++col)
+            mesh.mNodeList.push_back({Eigen::Vector3d(col, row, 0.), nodeId(col, row)});
+
+    ElementBlock& elements = mesh.mElementList;
+    auto addElement = [&](eElementType type, std::vector<int> nodes) {
+        elements.mIds.push_back(elements.size() + 1);
+        elements.mTypes.push_back(type);
+        elements.mPhysicalGroups.push_back(0);
+        elements.mNodeIds.insert(elements.mNodeIds.end(), nodes.begin(), nodes.end());
+        elements.mOffsets.push_back(elements.mNodeIds.size());
+    };
+    for (int row = 0; row < numY; ++row)
+        for (int col = 0; col < numX; ++col)
+        {
+            const int a = nodeId(col, row), b = nodeId(col + 1, row), c = nodeId(col + 1, row + 1),
+                      d = nodeId(col, row + 1);
+            if ((row + col) % 2 == 0)
+                addElement(eElementType::Quad4, {a, b, c, d});
+            else
+            {
+                addElement(eElementType::Triangle3, {a, b, c});
+                addElement(eElementType::Triangle3, {a, c, d});
+            }
+        }
+    return mesh;
+}
+
+
+//! @brief Deterministic element contributions that differ per element and entry
+void ElementKernel(int element, Eigen::MatrixXd& rMatrix, Eigen::VectorXd& rVector)
+{
+    for (int j = 0; j < rMatrix.cols(); ++j)
+    {
+        for (int i = 0; i < rMatrix.rows(); ++i)
+            rMatrix(i, j) = std::sin(0.1 * element + i) * std::cos(0.3 * j + element) + (i == j ? 10. : 0.);
+        rVector[j] = 1. / (1. + element + j);
+    }
+}
+
+
+int main()
+{
+    const ImportContainer mesh = MixedMesh(40, 30);
+    const int numDofsPerNode = 2;
+
+    // no two elements of a color share a node
+    {
+        const auto colors = ElementColors(mesh);
+        std::vector<int> lastElement(10 * mesh.mNodeList.size(), -1);
+        bool independent = true;
+        size_t numColored = 0;
+        for (size_t color = 0; color < colors.size(); ++color)
+            for (const int element : colors[color])
+            {
+                ++numColored;
+                for (const int node : mesh.mElementList.NodeIds(element))
+                {
+                    independent = independent and lastElement[node] != static_cast<int>(color);
+                    lastElement[node] = color;
+                }
+            }
+        std::cout << "\n" << colors.size() << " colors\n";
+        Check(independent and numColored == mesh.mElementList.size(), "colors are independent sets of all elements");
+        Check(colors.size() <= 8, "greedy coloring of a 2d mesh needs few colors");
+    }
+
+    // reference by triplets
+    Eigen::SparseMatrix<double> referenceMatrix;
+    Eigen::VectorXd referenceVector;
+    {
+        ThreadPool pool(1);
+        ColoredAssembler assembler(mesh, numDofsPerNode, pool);
+        std::vector<Eigen::Triplet<double>> entries;
+        referenceVector = Eigen::VectorXd::Zero(assembler.GetMatrix().rows());
+        for (size_t element = 0; element < mesh.mElementList.size(); ++element)
+        {
+            const std::vector<int> dofs = assembler.ElementDofs(element);
+            Eigen::MatrixXd elementMatrix(dofs.size(), dofs.size());
+            Eigen::VectorXd elementVector(dofs.size());
+            ElementKernel(element, elementMatrix, elementVector);
+            for (size_t j = 0; j < dofs.size(); ++j)
+            {
+                for (size_t i = 0; i < dofs.size(); ++i)
+                    entries.emplace_back(dofs[i], dofs[j], elementMatrix(i, j));
+                referenceVector[dofs[j]] += elementVector[j];
+            }
+        }
+        referenceMatrix.resize(referenceVector.size(), referenceVector.size());
+        referenceMatrix.setFromTriplets(entries.begin(), entries.end());
+    }
+
+    Eigen::SparseMatrix<double> singleThreaded;
+    for (const int numThreads : {1, 2, 4, 7})
+    {
+        ThreadPool pool(numThreads);
+        ColoredAssembler assembler(mesh, numDofsPerNode, pool);
+        std::atomic<bool> invalidThread(false);
+        for (int repetition = 0; repetition < 3; ++repetition)
+            assembler.Assemble([&](int element, int thread, Eigen::MatrixXd& rMatrix, Eigen::VectorXd& rVector) {
+                if (thread < 0 or thread >= numThreads)
+                    invalidThread = true;
+                ElementKernel(element, rMatrix, rVector);
+            });
+
+        const Eigen::SparseMatrix<double>& matrix = assembler.GetMatrix();
+        const std::string name = std::to_string(numThreads) + " threads";
+        Check(not invalidThread and (matrix - referenceMatrix).norm() < 1.e-12 * referenceMatrix.norm() and
+                      (assembler.GetVector() - referenceVector).norm() < 1.e-12 * referenceVector.norm(),
+              name + " assemble the reference");
+        if (numThreads == 1)
+            singleThreaded = matrix;
+        else
+            Check(std::equal(matrix.valuePtr(), matrix.valuePtr() + matrix.nonZeros(), singleThreaded.valuePtr()),
+                  name + " give bitwise the same matrix as one thread");
+    }
+
+    // an exception of a kernel reaches the caller and the pool stays usable
+    {
+        ThreadPool pool(4);
+        ColoredAssembler assembler(mesh, numDofsPerNode, pool);
+        bool thrown = false;
+        try
+        {
+            assembler.Assemble([](int element, int, Eigen::MatrixXd&, Eigen::VectorXd&) {
+                if (element == 100)
+                    throw std::runtime_error("material failure");
+            });
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        assembler.Assemble([](int element, int, Eigen::MatrixXd& rMatrix, Eigen::VectorXd& rVector) {
+            ElementKernel(element, rMatrix, rVector);
+        });
+        Check(thrown and (assembler.GetMatrix() - referenceMatrix).norm() < 1.e-12 * referenceMatrix.norm(),
+              "kernel exceptions are passed to the caller");
+    }
+
+    return TestResult();
+}
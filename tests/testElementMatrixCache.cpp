@@ -0,0 +1,107 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../2dExamples/ElementMatrixCache.h"
+#include "TestCheck.h"
+
+
+//! @brief numX x numY quads like MeshGenerator::Grid, the columns have the given widths in turn
+ImportContainer Grid(int numX, int numY, std::vector<double> widths = {0.1})
+{
+    ImportContainer mesh;
+    double x = 0.;
+    std::vector<double> columns;
+    for (int col = 0; col <= numX; ++col, x += widths[col % widths.size()])
+        columns.push_back(x);
+    for (int row = 0; row <= numY; ++row)
+        for (int col = 0; col <= numX; ++col)
+            mesh.mNodeList.push_back({Eigen::Vector3d(columns[col], 0.2 * row, 0.), row * (numX + 1) + col + 1});
+
+    ElementBlock& elements = mesh.mElementList;
+    for (int row = 0; row < numY; ++row)
+        for (int col = 0; col < numX; ++col)
+        {
+            const int node = row * (numX + 1) + col + 1;
+            elements.mIds.push_back(elements.size() + 1);
+            elements.mTypes.push_back(eElementType::Quad4);
+            elements.mPhysicalGroups.push_back(1);
+            for (const int id : {node, node + 1, node + numX + 2, node + numX + 1})
+                elements.mNodeIds.push_back(id);
+            elements.mOffsets.push_back(elements.mNodeIds.size());
+        }
+    return mesh;
+}
+
+
+//! @brief Element contributions that depend on the shape of the element only
+struct ShapeKernel
+{
+    void operator()(int element, int, Eigen::MatrixXd& rMatrix, Eigen::VectorXd&) const
+    {
+        const ElementNodes nodes = mMesh.mElementList.NodeIds(element);
+        const Eigen::Vector3d origin = mMesh.mNodeList[mNodeIndices.at(nodes[0])].mCoordinates;
+        for (int i = 0; i < nodes.size(); ++i)
+            for (int j = 0; j < nodes.size(); ++j)
+            {
+                const Eigen::Vector3d a = mMesh.mNodeList[mNodeIndices.at(nodes[i])].mCoordinates - origin;
+                const Eigen::Vector3d b = mMesh.mNodeList[mNodeIndices.at(nodes[j])].mCoordinates - origin;
+                for (int direction = 0; direction < 2; ++direction)
+                    rMatrix(2 * i + direction, 2 * j + direction) =
+                            a.dot(b) + (i == j ? 1. : 0.) + 0.1 * mMesh.mElementList.mPhysicalGroups[element];
+            }
+    }
+
+    const ImportContainer& mMesh;
+    FlatIdMap mNodeIndices;
+};
+
+
+//! @brief Assembles \a rMesh with the kernel and from the cache, returns the number of classes
+int CheckCache(const ImportContainer& rMesh, const std::string& rName)
+{
+    ThreadPool pool(4);
+    const ShapeKernel kernel{rMesh, NodeIndices(rMesh)};
+    ColoredAssembler assembler(rMesh, 2, pool);
+    assembler.Assemble(kernel);
+    const Eigen::SparseMatrix<double> reference = assembler.GetMatrix();
+
+    ElementMatrixCache cache(rMesh, 2);
+    cache.Compute(kernel, rMesh, pool);
+    assembler.AssembleMatrix(std::cref(cache));
+    Check((assembler.GetMatrix() - reference).norm() <= 1.e-12 * reference.norm(),
+          rName + ": the cached matrices assemble the same matrix");
+    return cache.NumClasses();
+}
+
+
+int main()
+{
+    {
+        const ImportContainer mesh = Grid(60, 40);
+        Check(CheckCache(mesh, "grid") == 1, "all elements of a uniform grid share one matrix");
+    }
+    {
+        ImportContainer mesh = Grid(60, 40);
+        for (auto& node : mesh.mNodeList)
+            node.mCoordinates += 1.e-14 * Eigen::Vector3d::Random();
+        Check(CheckCache(mesh, "round off") == 1, "round off of the coordinates keeps the grid in one class");
+    }
+    {
+        const ImportContainer mesh = Grid(60, 40, {0.1, 0.2, 0.3});
+        Check(CheckCache(mesh, "graded") == 3, "three column widths give three classes");
+    }
+    {
+        ImportContainer mesh = Grid(60, 40);
+        for (size_t element = 0; element < mesh.mElementList.size(); element += 2)
+            mesh.mElementList.mPhysicalGroups[element] = 2;
+        Check(CheckCache(mesh, "two materials") == 2, "each material is a class of its own");
+    }
+    {
+        ImportContainer mesh = Grid(60, 40);
+        mesh.mNodeList[20 * 61 + 30].mCoordinates += Eigen::Vector3d(0.01, 0.02, 0.);
+        Check(CheckCache(mesh, "distorted") == 5, "moving one node gives its four elements classes of their own");
+    }
+
+    return TestResult();
+}
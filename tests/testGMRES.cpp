@@ -2,19 +2,180 @@
 // Created by phuschke on 3/16/17.
 //
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 #include <eigen3/Eigen/Sparse>
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/QR>
 
+#include "../2dExamples/ConjugateProjectedGradient.h"
+#include "../2dExamples/ProjectedGMRES.h"
+#include "FetiInterfaceProblem.h"
+#include "TestCheck.h"
 
-int main()
+//! @brief Variable preconditioner, alternates between Jacobi and no preconditioning
+class AlternatingPreconditioner
 {
+public:
+    explicit AlternatingPreconditioner(const Eigen::MatrixXd& matrix)
+        : mInverseDiagonal(matrix.diagonal().cwiseInverse())
+    {
+    }
 
-    int dim = 3;
-    Eigen::MatrixXd A(dim, dim);
-    A.setRandom();
+    Eigen::VectorXd solve(const Eigen::VectorXd& rhs) const
+    {
+        return (mCount++ % 2 == 0) ? Eigen::VectorXd(mInverseDiagonal.cwiseProduct(rhs)) : rhs;
+    }
 
-    Eigen::DiagonalPreconditioner<double> precond(A);
+private:
+    Eigen::VectorXd mInverseDiagonal;
+    mutable int mCount = 0;
+};
+
+
+void RunTests(const FetiInterfaceProblem& problem, const std::string& name)
+{
+    const int n = problem.F.rows();
+    std::cout << "\n" << name << ": " << n << " multipliers, " << problem.G.cols() << " rigid body modes\n";
+
+    // projection onto ker(Gᵀ) and particular solution λ0 = G (GᵀG)⁻¹ e
+    const Eigen::LDLT<Eigen::MatrixXd> GtG(problem.G.transpose() * problem.G);
+    const Eigen::MatrixXd P = Eigen::MatrixXd::Identity(n, n) - problem.G * GtG.solve(problem.G.transpose());
+    const Eigen::VectorXd lambda0 = problem.G * GtG.solve(problem.e);
+
+    // consistent system P F P μ = P (d - F λ0) for the correction μ in range(P)
+    const Eigen::MatrixXd PFP = P * problem.F * P;
+    const Eigen::VectorXd rhs = P * (problem.d - problem.F * lambda0);
+    const Eigen::SparseMatrix<double> FSparse = problem.F.sparseView();
+    const Eigen::DiagonalPreconditioner<double> jacobi(FSparse);
+    const ProjectedPreconditioner<Eigen::DiagonalPreconditioner<double>> precond(P, jacobi);
+
+    const double tolerance = 1.e-10;
+
+    // reference solution by CPG
+    Eigen::VectorXd muCpg = Eigen::VectorXd::Zero(n);
+    int itersCpg = 10 * n;
+    double errorCpg = tolerance;
+    auto start = std::chrono::steady_clock::now();
+    Eigen::internal::conjugate_projected_gradient(PFP, rhs, muCpg, P, precond, itersCpg, errorCpg);
+    const double timeCpg = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Check(errorCpg < tolerance, "CPG converges");
+
+    // the projected residual of the interface problem vanishes
+    const Eigen::VectorXd lambdaCpg = lambda0 + muCpg;
+    Check((P * (problem.d - problem.F * lambdaCpg)).norm() < 1.e-8 * problem.d.norm(),
+          "CPG solves the interface problem");
+    Check((problem.G.transpose() * lambdaCpg - problem.e).norm() < 1.e-10 * (1. + problem.e.norm()),
+          "CPG satisfies the compatibility condition");
+
+    // reorthogonalization against a window of previous directions, with the Jacobi preconditioner
+    for (int window : {5, 20, n})
+    {
+        Eigen::VectorXd mu = Eigen::VectorXd::Zero(n);
+        int iters = 10 * n;
+        double error = tolerance;
+        Eigen::internal::conjugate_projected_gradient(PFP, rhs, mu, P, precond, iters, error, window);
+        Check(error < tolerance and (mu - muCpg).norm() < 1.e-6 * muCpg.norm(),
+              "CPG with reorthogonalization window " + std::to_string(window) + " converges (" +
+                      std::to_string(iters) + " iterations)");
+    }
+
+    // consecutive solves recycling the directions: a cold solve, the same system with a looser tolerance, like
+    // the first Newton iterations of a load step, which converges on the warm start, and a perturbed system
+    const Eigen::VectorXd perturbedRhs = rhs + 0.05 * (PFP * Eigen::VectorXd::LinSpaced(n, 0., 1.));
+    Eigen::VectorXd muPerturbed = Eigen::VectorXd::Zero(n);
+    int itersPerturbed = 10 * n;
+    double errorPerturbed = tolerance;
+    Eigen::internal::conjugate_projected_gradient(PFP, perturbedRhs, muPerturbed, P, precond, itersPerturbed,
+                                                  errorPerturbed);
+    for (int window : {0, 20})
+    {
+        const std::string name = window == 0 ? "recycling CPG" : "recycling CPG with reorthogonalization";
+        Eigen::SearchDirectionWindow<double> recycled(0, n);
+        const Eigen::VectorXd* rhsOfSolve[3] = {&rhs, &rhs, &perturbedRhs};
+        const double toleranceOfSolve[3] = {tolerance, 1.e-6, tolerance};
+        Eigen::VectorXd mu[3];
+        int iters[3];
+        double error[3];
+        int numRecycled[3];
+        for (int solve = 0; solve < 3; ++solve)
+        {
+            mu[solve] = Eigen::VectorXd::Zero(n);
+            iters[solve] = 10 * n;
+            error[solve] = toleranceOfSolve[solve];
+            Eigen::internal::conjugate_projected_gradient(PFP, *rhsOfSolve[solve], mu[solve], P, precond,
+                                                          iters[solve], error[solve], window, &recycled);
+            numRecycled[solve] = recycled.count();
+        }
+        Check(error[0] < tolerance and (mu[0] - muCpg).norm() < 1.e-6 * muCpg.norm(), name + " converges cold");
+        Check(iters[1] == 0 and error[1] < 1.e-6, name + " converges on the warm start");
+        Check(numRecycled[0] > 0 and numRecycled[1] == numRecycled[0],
+              name + " keeps the directions if the warm start converges");
+        Check(error[2] < tolerance and (mu[2] - muPerturbed).norm() < 1.e-6 * muPerturbed.norm(),
+              name + " converges for a perturbed right hand side");
+        Check(iters[2] < itersPerturbed, name + " saves iterations for a perturbed right hand side (" +
+                                                 std::to_string(iters[2]) + " instead of " +
+                                                 std::to_string(itersPerturbed) + ")");
+    }
+
+    std::cout << "  solver   restart  iterations  error        time [s]\n";
+    std::cout << "  CPG      -        " << itersCpg << "  " << errorCpg << "  " << timeCpg << "\n";
+
+    for (int restart : {5, 10, 30, n})
+    {
+        Eigen::VectorXd mu = Eigen::VectorXd::Zero(n);
+        int iters = 10 * n;
+        double error = tolerance;
+        start = std::chrono::steady_clock::now();
+        Eigen::internal::projected_fgmres(PFP, rhs, mu, P, precond, iters, error, restart);
+        const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  GMRES    " << restart << "  " << iters << "  " << error << "  " << time << "\n";
+
+        Check(error < tolerance, "GMRES(" + std::to_string(restart) + ") converges");
+        Check((mu - muCpg).norm() < 1.e-6 * muCpg.norm(), "GMRES(" + std::to_string(restart) + ") matches CPG");
+        Check(((P * mu) - mu).norm() < 1.e-10 * mu.norm(), "GMRES(" + std::to_string(restart) + ") stays in range(P)");
+        Check((rhs - PFP * mu).norm() < 2. * tolerance * rhs.norm(),
+              "GMRES(" + std::to_string(restart) + ") residual estimate is reliable");
+    }
+
+    // a preconditioner that changes between applications requires the flexible variant
+    {
+        Eigen::VectorXd mu = Eigen::VectorXd::Zero(n);
+        int iters = 10 * n;
+        double error = tolerance;
+        const AlternatingPreconditioner variablePrecond(problem.F);
+        Eigen::internal::projected_fgmres(PFP, rhs, mu, P, variablePrecond, iters, error, 30);
+        Check(error < tolerance and (mu - muCpg).norm() < 1.e-6 * muCpg.norm(),
+              "flexible GMRES converges with a variable preconditioner (" + std::to_string(iters) + " iterations)");
+    }
+
+    // the initial guess is taken into account
+    {
+        Eigen::VectorXd mu = muCpg;
+        int iters = 10 * n;
+        double error = tolerance;
+        Eigen::internal::projected_fgmres(PFP, rhs, mu, P, precond, iters, error, 30);
+        Check(iters == 0, "GMRES returns immediately for the exact initial guess");
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        // saved interface problems, e.g. ./testGMRES feti_0_ feti_1_
+        for (int i = 1; i < argc; ++i)
+            RunTests(LoadFetiInterfaceProblem(argv[i]), argv[i]);
+    }
+    else
+    {
+        RunTests(CreateFetiInterfaceProblem(4, 8), "4 subdomains, 8x8 nodes");
+        RunTests(CreateFetiInterfaceProblem(8, 12), "8 subdomains, 12x12 nodes");
+    }
+
+    return TestResult();
 }
@@ -0,0 +1,304 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "../2dExamples/ImportMesh.h"
+#include "../2dExamples/MeshCache.h"
+#include "TestCheck.h"
+
+
+//! @brief Straightforward stream based reader, serves as reference
+ImportContainer ImportMeshFileWithStreams(const std::string& rFileName)
+{
+    std::ifstream file(rFileName);
+    ImportContainer importContainer;
+    std::string line;
+
+    while (std::getline(file, line) and line != "Nodes")
+        ;
+    int num = 0;
+    file >> num;
+    importContainer.mNodeList.resize(num);
+    for (auto& node : importContainer.mNodeList)
+        file >> node.mId >> node.mCoordinates[0] >> node.mCoordinates[1] >> node.mCoordinates[2];
+
+    while (std::getline(file, line) and line != "Elements")
+        ;
+    file >> num;
+    for (int i = 0; i < num; ++i)
+    {
+        int id = 0;
+        file >> id;
+        importContainer.mElementList.mIds.push_back(id);
+        importContainer.mElementList.mTypes.push_back(eElementType::Quad4);
+        for (int j = 0; j < 4; ++j)
+        {
+            file >> id;
+            importContainer.mElementList.mNodeIds.push_back(id);
+        }
+        importContainer.mElementList.mOffsets.push_back(importContainer.mElementList.mNodeIds.size());
+    }
+
+    while (std::getline(file, line) and line != "Interfaces")
+        ;
+    file >> num;
+    importContainer.mInterfaceList.resize(num);
+    for (auto& interface : importContainer.mInterfaceList)
+    {
+        int num_nodes = 0;
+        file >> num_nodes;
+        std::map<int, int> nodeIdsMap;
+        for (int i = 0; i < num_nodes; ++i)
+        {
+            int globalId = 0;
+            int localId = 0;
+            file >> globalId >> localId;
+            nodeIdsMap.emplace(globalId, localId);
+        }
+        interface.mNodeIdsMap.Assign(std::vector<FlatIdMap::value_type>(nodeIdsMap.begin(), nodeIdsMap.end()));
+        file >> interface.mValue;
+    }
+    return importContainer;
+}
+
+
+//! @brief Writes a structured mesh of numElements x numElements quads in the ImportMesh format
+void WriteStructuredMesh(const std::string& rFileName, int numElements)
+{
+    std::ofstream file(rFileName);
+    file << std::setprecision(16);
+    const int numNodes = numElements + 1;
+
+    file << "Nodes\n" << numNodes * numNodes << "\n";
+    for (int row = 0; row < numNodes; ++row)
+        for (int col = 0; col < numNodes; ++col)
+            file << row * numNodes + col + 1 << " " << col / 3. << " " << -row * 1.e-7 / 7. << " 0\n";
+
+    file << "Elements\n" << numElements * numElements << "\n";
+    for (int row = 0; row < numElements; ++row)
+        for (int col = 0; col < numElements; ++col)
+        {
+            const int node = row * numNodes + col + 1;
+            file << row * numElements + col + 1 << " " << node << " " << node + 1 << " " << node + numNodes + 1
+                 << " " << node + numNodes << "\n";
+        }
+
+    file << "Boundaries\n1\n" << numNodes << "\n";
+    for (int row = 0; row < numNodes; ++row)
+        file << row << " " << row * numNodes + 1 << "\n";
+    file << "0.0 0.0 0.0\n";
+
+    file << "Interfaces\n1\n" << numNodes << "\n";
+    for (int row = 0; row < numNodes; ++row)
+        file << row << " " << row * numNodes + numNodes << "\n";
+    file << "-1\n";
+}
+
+
+//! @brief Writes a mesh with triangles, quads and second order elements
+void WriteMixedMesh(const std::string& rFileName, double z)
+{
+    std::ofstream file(rFileName);
+    file << "Nodes\n9\n";
+    for (int node = 0; node < 9; ++node)
+        file << node + 1 << " " << node % 3 << " " << node / 3 << " " << (node == 4 ? z : 0.) << "\n";
+    file << "Elements\n4\n"
+         << "1 1 2 4\n"
+         << "2 2 3 6 5\n"
+         << "\n"
+         << "3 4 5 8 7 1 2 3 6\n"
+         << "4 5 6 9 8 1 2 3 4 7\n";
+    file << "Boundaries\n0\nInterfaces\n0\n";
+}
+
+
+bool IsEqual(const ImportContainer& rA, const ImportContainer& rB)
+{
+    bool equal = rA.mNodeList.size() == rB.mNodeList.size();
+    for (size_t i = 0; equal and i < rA.mNodeList.size(); ++i)
+        equal = rA.mNodeList[i].mId == rB.mNodeList[i].mId and
+                rA.mNodeList[i].mCoordinates == rB.mNodeList[i].mCoordinates;
+
+    equal = equal and rA.mElementList.mIds == rB.mElementList.mIds and
+            rA.mElementList.mTypes == rB.mElementList.mTypes and
+            rA.mElementList.mPhysicalGroups == rB.mElementList.mPhysicalGroups and
+            rA.mElementList.mOffsets == rB.mElementList.mOffsets and
+            rA.mElementList.mNodeIds == rB.mElementList.mNodeIds;
+
+    equal = equal and rA.mBoundaryList.size() == rB.mBoundaryList.size();
+    for (size_t i = 0; equal and i < rA.mBoundaryList.size(); ++i)
+        equal = rA.mBoundaryList[i].mNodeIdsMap == rB.mBoundaryList[i].mNodeIdsMap and
+                rA.mBoundaryList[i].mValues == rB.mBoundaryList[i].mValues;
+
+    equal = equal and rA.mInterfaceList.size() == rB.mInterfaceList.size();
+    for (size_t i = 0; equal and i < rA.mInterfaceList.size(); ++i)
+        equal = rA.mInterfaceList[i].mNodeIdsMap == rB.mInterfaceList[i].mNodeIdsMap and
+                rA.mInterfaceList[i].mValue == rB.mInterfaceList[i].mValue;
+    return equal;
+}
+
+
+void CompareWithReference(const std::string& rFileName)
+{
+    auto start = std::chrono::steady_clock::now();
+    const ImportContainer reference = ImportMeshFileWithStreams(rFileName);
+    const double timeStreams = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    const ImportContainer mesh = ImportMeshFile(rFileName);
+    const double timeMapped = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\n" << rFileName << ": " << mesh.mNodeList.size() << " nodes, " << mesh.mElementList.size()
+              << " elements\n";
+    std::cout << "  streams " << timeStreams << " s, memory mapped " << timeMapped << " s\n";
+
+    bool nodesEqual = mesh.mNodeList.size() == reference.mNodeList.size();
+    for (size_t i = 0; nodesEqual and i < mesh.mNodeList.size(); ++i)
+        nodesEqual = mesh.mNodeList[i].mId == reference.mNodeList[i].mId and
+                     mesh.mNodeList[i].mCoordinates == reference.mNodeList[i].mCoordinates;
+    Check(nodesEqual, "nodes are identical to the stream reader, bit by bit");
+
+    const bool elementsEqual = mesh.mElementList.mIds == reference.mElementList.mIds and
+                               mesh.mElementList.mTypes == reference.mElementList.mTypes and
+                               mesh.mElementList.mOffsets == reference.mElementList.mOffsets and
+                               mesh.mElementList.mNodeIds == reference.mElementList.mNodeIds;
+    Check(elementsEqual, "elements are identical to the stream reader");
+
+    bool interfacesEqual = mesh.mInterfaceList.size() == reference.mInterfaceList.size();
+    for (size_t i = 0; interfacesEqual and i < mesh.mInterfaceList.size(); ++i)
+        interfacesEqual = mesh.mInterfaceList[i].mNodeIdsMap == reference.mInterfaceList[i].mNodeIdsMap and
+                          mesh.mInterfaceList[i].mValue == reference.mInterfaceList[i].mValue;
+    Check(interfacesEqual, "interfaces are identical to the stream reader");
+}
+
+
+std::string ReadFile(const std::string& rFileName)
+{
+    std::ifstream file(rFileName, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+//! @brief Overwrites the bytes at \a position of an existing file
+void PatchFile(const std::string& rFileName, size_t position, const std::string& rBytes)
+{
+    std::fstream file(rFileName, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(position);
+    file.write(rBytes.data(), rBytes.size());
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        // e.g. ./testImportMesh ../meshFiles/2d/feti/feti.msh_00000*
+        for (int i = 1; i < argc; ++i)
+            CompareWithReference(argv[i]);
+    }
+    else
+    {
+        const std::string fileName = "testImportMesh.msh";
+        WriteStructuredMesh(fileName, 1000);
+        CompareWithReference(fileName);
+
+        const ImportContainer mesh = ImportMeshFile(fileName);
+        Check(mesh.mBoundaryList.size() == 1 and mesh.mBoundaryList[0].mNodeIdsMap.size() == 1001 and
+                      mesh.mBoundaryList[0].mNodeIdsMap.at(1000) == 1000 * 1001 + 1,
+              "boundaries are read");
+
+        // the first import writes the snapshot, the second one reads it
+        const std::string cacheFileName = MeshCacheFileName(fileName);
+        std::remove(cacheFileName.c_str());
+        ImportMeshFileCached(fileName);
+        auto start = std::chrono::steady_clock::now();
+        const ImportContainer cached = ImportMeshFileCached(fileName);
+        const double timeCached = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  binary snapshot " << timeCached << " s\n";
+        Check(IsEqual(cached, mesh), "mesh from the binary snapshot is identical");
+
+        // a modified mesh file invalidates the snapshot
+        WriteStructuredMesh(fileName, 10);
+        Check(ImportMeshFileCached(fileName).mElementList.size() == 100, "stale snapshots are replaced");
+
+        std::ofstream(cacheFileName, std::ios::in | std::ios::out) << "garbage";
+        Check(ImportMeshFileCached(fileName).mElementList.size() == 100, "damaged snapshots are ignored");
+
+        // a count beyond the file size must not be allocated
+        const std::uint64_t hugeCount = std::uint64_t(1) << 62;
+        PatchFile(cacheFileName, offsetof(MeshCacheHeader, mNumNodes),
+                  std::string(reinterpret_cast<const char*>(&hugeCount), sizeof(hugeCount)));
+        Check(ImportMeshFileCached(fileName).mElementList.size() == 100, "snapshots with corrupted counts are ignored");
+
+        // swapped offsets of the first two elements
+        const std::vector<int> offsets = ImportMeshFile(fileName).mElementList.mOffsets;
+        const std::string offsetBytes(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(int));
+        const std::string cache = ReadFile(cacheFileName);
+        const size_t offsetPosition = cache.find(offsetBytes);
+        const int swapped[2] = {offsets[2], offsets[1]};
+        PatchFile(cacheFileName, offsetPosition + sizeof(int),
+                  std::string(reinterpret_cast<const char*>(swapped), sizeof(swapped)));
+        Check(offsetPosition != std::string::npos and ImportMeshFileCached(fileName).mElementList.mOffsets == offsets,
+              "snapshots with inconsistent element offsets are ignored");
+
+        std::remove(fileName.c_str());
+        std::remove(cacheFileName.c_str());
+    }
+
+    {
+        const std::string fileName = "testImportMeshMixed.msh";
+        WriteMixedMesh(fileName, 0.);
+        const ElementBlock elements = ImportMeshFile(fileName).mElementList;
+        Check(elements.size() == 4 and elements.mOffsets == std::vector<int>({0, 3, 7, 15, 24}),
+              "elements with different numbers of nodes are stored contiguously");
+        Check(elements.mTypes == std::vector<eElementType>({eElementType::Triangle3, eElementType::Quad4,
+                                                            eElementType::Quad8, eElementType::Quad9}),
+              "element types of a planar mesh");
+        const ElementNodes nodes = elements.NodeIds(2);
+        Check(nodes.size() == 8 and nodes[0] == 4 and nodes[7] == 6 and *(nodes.end() - 1) == 6,
+              "node ids of a single element");
+
+        WriteMixedMesh(fileName, 1.);
+        Check(ImportMeshFile(fileName).mElementList.mTypes[1] == eElementType::Tetrahedron4,
+              "element types of a three dimensional mesh");
+        std::remove(fileName.c_str());
+    }
+
+    {
+        const FlatIdMap map({{7, 0}, {3, 1}, {11, 2}, {3, 5}, {5, 3}});
+        Check(map.size() == 4 and map.at(3) == 1 and map.at(11) == 2 and map.count(4) == 0,
+              "flat map keeps the first of duplicate ids");
+        Check(map.GlobalToLocal({3, 5, 11}) == std::vector<int>({1, 3, 2}) and
+                      map.GlobalToLocal({11, 3, 7}) == std::vector<int>({2, 1, 0}),
+              "bulk translation of sorted and unsorted ids");
+        bool missing = false;
+        try
+        {
+            map.GlobalToLocal({3, 4});
+        }
+        catch (std::out_of_range&)
+        {
+            missing = true;
+        }
+        Check(missing, "bulk translation throws for unknown ids");
+    }
+
+    bool thrown = false;
+    try
+    {
+        ImportMeshFile("does_not_exist.msh");
+    }
+    catch (std::runtime_error&)
+    {
+        thrown = true;
+    }
+    Check(thrown, "missing files throw");
+
+    return TestResult();
+}
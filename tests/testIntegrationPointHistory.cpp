@@ -0,0 +1,167 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../IntegrationPointHistory.h"
+#include "TestCheck.h"
+
+
+constexpr double youngsModulus = 30000.;
+constexpr double poissonsRatio = 0.2;
+constexpr double tensileStrength = 4.;
+constexpr double compressiveStrength = 40.;
+constexpr double fractureEnergy = 0.021;
+constexpr double alpha = 0.99;
+
+
+//! @brief Damage of one integration point, written out like the per integration point law
+double Damage(double kappa)
+{
+    const double kappa0 = tensileStrength / youngsModulus, beta = tensileStrength / fractureEnergy;
+    if (kappa <= kappa0)
+        return 0.;
+    return 1. - kappa0 / kappa * (1. - alpha + alpha * std::exp(beta * (kappa0 - kappa)));
+}
+
+
+//! @brief Modified Mises strain of one integration point from the full 3d strain tensor
+double ModifiedMises(const Eigen::Matrix3d& rStrain)
+{
+    const double k = compressiveStrength / tensileStrength, nu = poissonsRatio;
+    const double I1 = rStrain.trace();
+    const Eigen::Matrix3d deviator = rStrain - I1 / 3. * Eigen::Matrix3d::Identity();
+    const double J2 = 0.5 * (deviator.array() * deviator.array()).sum();
+    return (k - 1) / (2 * k * (1 - 2 * nu)) * I1 +
+           1. / (2 * k) * std::sqrt(std::pow((k - 1) / (1 - 2 * nu), 2) * I1 * I1 + 12 * k / std::pow(1 + nu, 2) * J2);
+}
+
+
+Eigen::Matrix3d StrainTensor(const Eigen::VectorXd& rVoigt, NuTo::eSectionType section)
+{
+    Eigen::Matrix3d strain = Eigen::Matrix3d::Zero();
+    if (section == NuTo::eSectionType::Volume)
+    {
+        strain.diagonal() = rVoigt.head(3);
+        strain(1, 2) = strain(2, 1) = rVoigt[3] / 2;
+        strain(0, 2) = strain(2, 0) = rVoigt[4] / 2;
+        strain(0, 1) = strain(1, 0) = rVoigt[5] / 2;
+        return strain;
+    }
+    strain(0, 0) = rVoigt[0];
+    strain(1, 1) = rVoigt[1];
+    strain(0, 1) = strain(1, 0) = rVoigt[2] / 2;
+    if (section == NuTo::eSectionType::PlaneStress)
+        strain(2, 2) = -poissonsRatio / (1 - poissonsRatio) * (rVoigt[0] + rVoigt[1]);
+    return strain;
+}
+
+
+void CheckGradientDamage(NuTo::eSectionType section, const std::string& rName)
+{
+    const int numElements = 300, numIps = 4, numStrains = NuTo::NumStrains(section);
+    NuTo::GradientDamageLaw law(youngsModulus, poissonsRatio, tensileStrength, compressiveStrength, fractureEnergy,
+                                alpha, section);
+    const double kappa0 = law.GetKappa0();
+    NuTo::IntegrationPointHistory history(numElements, numIps, numStrains);
+    NuTo::GradientDamageResponse response;
+
+    // first step loads all points, the second unloads every third one and loads the others further
+    history.mStrains = 5. * kappa0 * Eigen::ArrayXXd::Random(history.size(), numStrains);
+    Eigen::ArrayXd nonlocal = 4. * kappa0 * (Eigen::ArrayXd::Random(history.size()) + 1.);
+    law.Evaluate(nonlocal, history, response);
+    history.Commit();
+    const Eigen::ArrayXd committed = history.mKappa;
+    for (int ip = 0; ip < history.size(); ++ip)
+        nonlocal[ip] *= ip % 3 == 0 ? 0.5 : 1.1;
+    law.Evaluate(nonlocal, history, response);
+
+    const Eigen::MatrixXd C = NuTo::ElasticityMatrix(youngsModulus, poissonsRatio, section);
+    double damageError = 0., stressError = 0., mises = 0., misesDerivative = 0., damageDerivative = 0.;
+    bool kappaMonotonic = true;
+    for (int ip = 0; ip < history.size(); ++ip)
+    {
+        const double kappa = std::max(committed[ip], nonlocal[ip]);
+        kappaMonotonic = kappaMonotonic and history.mKappaTrial[ip] == kappa;
+        damageError = std::max(damageError, std::abs(history.mDamage[ip] - Damage(kappa)));
+
+        const Eigen::VectorXd strain = history.mStrains.row(ip).transpose();
+        const Eigen::VectorXd stress = (1. - Damage(kappa)) * C * strain;
+        stressError = std::max(stressError, (response.mStress.row(ip).transpose().matrix() - stress).norm() /
+                                                    (C * strain).norm());
+        mises = std::max(mises, std::abs(response.mLocalEqStrain[ip] - ModifiedMises(StrainTensor(strain, section))) /
+                                        kappa0);
+
+        // central differences of the equivalent strain and, while loading, of the damage
+        const double h = 1.e-7 * kappa0;
+        for (int component = 0; component < numStrains; ++component)
+        {
+            Eigen::VectorXd plus = strain, minus = strain;
+            plus[component] += h;
+            minus[component] -= h;
+            const double difference = (ModifiedMises(StrainTensor(plus, section)) -
+                                       ModifiedMises(StrainTensor(minus, section))) /
+                                      (2 * h);
+            misesDerivative = std::max(
+                    misesDerivative, std::abs(response.mLocalEqStrainDerivative(ip, component) - difference));
+        }
+        const bool loading = nonlocal[ip] > committed[ip] and nonlocal[ip] > kappa0 + h;
+        const double difference = loading ? (Damage(nonlocal[ip] + h) - Damage(nonlocal[ip] - h)) / (2 * h) : 0.;
+        damageDerivative = std::max(damageDerivative, std::abs(response.mDamageDerivative[ip] - difference) * kappa0);
+    }
+    std::cout << "\n" << rName << ": damage " << damageError << ", stress " << stressError << ", Mises " << mises
+              << ", dMises " << misesDerivative << ", dDamage " << damageDerivative << "\n";
+    Check(kappaMonotonic, rName + " κ only grows and starts from the committed history");
+    Check(damageError < 1.e-14 and stressError < 1.e-14, rName + " damage and stress equal the scalar law");
+    Check(mises < 1.e-12, rName + " modified Mises strain equals the tensor formula");
+    Check(misesDerivative < 1.e-6 and damageDerivative < 1.e-6, rName + " derivatives match central differences");
+}
+
+
+void CheckPhaseField()
+{
+    const auto section = NuTo::eSectionType::PlaneStrain;
+    const double residualStiffness = 1.e-6;
+    NuTo::PhaseFieldLaw law(youngsModulus, poissonsRatio, section, residualStiffness);
+    NuTo::IntegrationPointHistory history(1000, 3, 3);
+    NuTo::PhaseFieldResponse response;
+
+    history.mStrains = 1.e-4 * Eigen::ArrayXXd::Random(history.size(), 3);
+    const Eigen::ArrayXd phaseField = 0.5 * (Eigen::ArrayXd::Random(history.size()) + 1.);
+    law.Evaluate(phaseField, history, response);
+    history.Commit();
+    const Eigen::ArrayXd committed = history.mPhaseFieldHistory;
+    history.mStrains *= 0.5;
+    law.Evaluate(phaseField, history, response);
+
+    const Eigen::MatrixXd C = NuTo::ElasticityMatrix(youngsModulus, poissonsRatio, section);
+    double error = 0.;
+    bool historyKept = true;
+    for (int ip = 0; ip < history.size(); ++ip)
+    {
+        const Eigen::VectorXd strain = history.mStrains.row(ip).transpose();
+        const double degradation = std::pow(1 - phaseField[ip], 2) + residualStiffness;
+        const Eigen::VectorXd stress = C * strain;
+        historyKept = historyKept and history.mPhaseFieldHistoryTrial[ip] == committed[ip] and
+                      committed[ip] >= 0.5 * strain.dot(stress);
+        error = std::max(error, (response.mStress.row(ip).transpose().matrix() - degradation * stress).norm() /
+                                        stress.norm());
+        error = std::max(error, (response.mStressDerivative.row(ip).transpose().matrix() +
+                                 2 * (1 - phaseField[ip]) * stress)
+                                                .norm() /
+                                        stress.norm());
+    }
+    std::cout << "\nphase field: stress " << error << "\n";
+    Check(historyKept, "phase field history keeps the maximum energy while unloading");
+    Check(error < 1.e-14, "phase field stress and its derivative equal the scalar law");
+}
+
+
+int main()
+{
+    CheckGradientDamage(NuTo::eSectionType::PlaneStress, "plane stress");
+    CheckGradientDamage(NuTo::eSectionType::PlaneStrain, "plane strain");
+    CheckGradientDamage(NuTo::eSectionType::Volume, "3d");
+    CheckPhaseField();
+
+    return TestResult();
+}
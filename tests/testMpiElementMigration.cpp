@@ -0,0 +1,98 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+
+#include "../2dExamples/MpiElementMigration.h"
+#include "TestCheck.h"
+
+// Element state migration after a repartitioning, e.g.
+// mpirun -np 3 ./testMpiElementMigration
+
+
+//! @brief Value ip of the element with id \a id, the same on every rank
+double Value(int id, int ip)
+{
+    return id + 0.25 * ip;
+}
+
+
+int main(int argc, char* argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank, numRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+
+    // rank r owns r + 3 elements with consecutive ids, the element with id i moves to rank i % numRanks
+    const int valuesPerElement = 3;
+    int firstId = 0;
+    for (int r = 0; r < rank; ++r)
+        firstId += r + 3;
+    const int numTotal = numRanks * (numRanks + 5) / 2;
+
+    ElementState local;
+    local.mValuesPerElement = valuesPerElement;
+    std::vector<int> newRank;
+    for (int id = firstId; id < firstId + rank + 3; ++id)
+    {
+        local.mIds.push_back(id);
+        for (int ip = 0; ip < valuesPerElement; ++ip)
+            local.mValues.push_back(Value(id, ip));
+        newRank.push_back(id % numRanks);
+    }
+
+    const ElementState received = MigrateElementState(local, newRank);
+
+    // expected: the staying elements in their old order, then those of the ranks rank + 1, rank + 2, ...
+    std::vector<int> expectedIds;
+    for (int i = 0; i < numRanks; ++i)
+    {
+        const int source = (rank + i) % numRanks;
+        int sourceFirstId = 0;
+        for (int r = 0; r < source; ++r)
+            sourceFirstId += r + 3;
+        for (int id = sourceFirstId; id < sourceFirstId + source + 3; ++id)
+            if (id % numRanks == rank)
+                expectedIds.push_back(id);
+    }
+
+    bool valuesMatch = received.mValuesPerElement == valuesPerElement and
+                       received.mValues.size() == received.size() * valuesPerElement;
+    for (size_t i = 0; valuesMatch and i < received.size(); ++i)
+        for (int ip = 0; ip < valuesPerElement; ++ip)
+            valuesMatch = valuesMatch and received.mValues[i * valuesPerElement + ip] == Value(received.mIds[i], ip);
+
+    int numReceived = received.size();
+    int numReceivedTotal = 0;
+    MPI_Allreduce(&numReceived, &numReceivedTotal, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    int allOk = received.mIds == expectedIds and valuesMatch;
+    MPI_Allreduce(MPI_IN_PLACE, &allOk, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+
+    // nothing moves if the partition stays the same
+    const ElementState kept = MigrateElementState(local, std::vector<int>(local.size(), rank));
+    int keptOk = kept.mIds == local.mIds and kept.mValues == local.mValues;
+    MPI_Allreduce(MPI_IN_PLACE, &keptOk, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+
+    // elements without values, e.g. a purely elastic model, only move their ids
+    ElementState idsOnly;
+    idsOnly.mIds = local.mIds;
+    const ElementState receivedIds = MigrateElementState(idsOnly, newRank);
+    int idsOnlyOk = receivedIds.mIds == expectedIds and receivedIds.mValues.empty();
+    MPI_Allreduce(MPI_IN_PLACE, &idsOnlyOk, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+
+    if (rank == 0)
+    {
+        std::cout << numRanks << " ranks, " << numTotal << " elements\n";
+        Check(numReceivedTotal == numTotal, "every element arrives exactly once");
+        Check(allOk, "every rank receives its elements with their values, its own first");
+        Check(keptOk, "an unchanged partition keeps the state as it is");
+        Check(idsOnlyOk, "elements without values are migrated");
+    }
+
+    const int result = rank == 0 ? TestResult() : EXIT_SUCCESS;
+    MPI_Finalize();
+    return result;
+}
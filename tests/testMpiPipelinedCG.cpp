@@ -0,0 +1,132 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mpi.h>
+#include <eigen3/Eigen/Core>
+
+#include "../2dExamples/ConjugateProjectedGradient.h"
+#include "../2dExamples/MpiNonBlockingSum.h"
+#include "FetiInterfaceProblem.h"
+#include "TestCheck.h"
+
+// Pipelined projected CG with the interface vectors distributed over the ranks, e.g.
+// mpirun -np 3 ./testMpiPipelinedCG
+
+
+//! @brief Rows of the replicated matrix that belong to this rank, applied to a vector distributed the same way
+class DistributedRows
+{
+public:
+    DistributedRows(const Eigen::MatrixXd& rMatrix, const std::vector<int>& rCounts, const std::vector<int>& rOffsets,
+                    int rank)
+        : mLocalRows(rMatrix.middleRows(rOffsets[rank], rCounts[rank]))
+        , mCounts(rCounts)
+        , mOffsets(rOffsets)
+    {
+    }
+
+    int cols() const
+    {
+        return mLocalRows.rows();
+    }
+
+    template <typename Derived>
+    Eigen::VectorXd operator*(const Eigen::MatrixBase<Derived>& rLocal) const
+    {
+        const Eigen::VectorXd local = rLocal;
+        Eigen::VectorXd global(mLocalRows.cols());
+        MPI_Allgatherv(local.data(), local.rows(), MPI_DOUBLE, global.data(), mCounts.data(), mOffsets.data(),
+                       MPI_DOUBLE, MPI_COMM_WORLD);
+        return mLocalRows * global;
+    }
+
+private:
+    Eigen::MatrixXd mLocalRows;
+    std::vector<int> mCounts;
+    std::vector<int> mOffsets;
+};
+
+
+//! @brief Jacobi preconditioner of the rows of this rank
+class LocalJacobi
+{
+public:
+    explicit LocalJacobi(const Eigen::VectorXd& rDiagonal)
+        : mInverseDiagonal(rDiagonal.cwiseInverse())
+    {
+    }
+
+    Eigen::VectorXd solve(const Eigen::VectorXd& rRhs) const
+    {
+        return mInverseDiagonal.cwiseProduct(rRhs);
+    }
+
+private:
+    Eigen::VectorXd mInverseDiagonal;
+};
+
+
+int main(int argc, char* argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank, numRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+
+    // every rank sets up the whole problem, but only keeps its rows of the vectors
+    const FetiInterfaceProblem problem = CreateFetiInterfaceProblem(8, 12);
+    const int n = problem.F.rows();
+    const Eigen::LDLT<Eigen::MatrixXd> GtG(problem.G.transpose() * problem.G);
+    const Eigen::MatrixXd P = Eigen::MatrixXd::Identity(n, n) - problem.G * GtG.solve(problem.G.transpose());
+    const Eigen::MatrixXd PFP = P * problem.F * P;
+    const Eigen::VectorXd rhs = P * (problem.d - problem.F * problem.G * GtG.solve(problem.e));
+    const double tolerance = 1.e-10;
+
+    // serial reference
+    Eigen::LocalReduction localReduction;
+    Eigen::VectorXd muSerial = Eigen::VectorXd::Zero(n);
+    int itersSerial = 10 * n;
+    double errorSerial = tolerance;
+    Eigen::internal::pipelined_conjugate_projected_gradient(PFP, rhs, muSerial, P, LocalJacobi(problem.F.diagonal()),
+                                                            localReduction, itersSerial, errorSerial);
+
+    // contiguous blocks of rows, the first ranks get one more
+    std::vector<int> counts(numRanks), offsets(numRanks);
+    for (int i = 0, offset = 0; i < numRanks; ++i)
+    {
+        counts[i] = n / numRanks + (i < n % numRanks ? 1 : 0);
+        offsets[i] = offset;
+        offset += counts[i];
+    }
+    const int begin = offsets[rank], size = counts[rank];
+
+    Eigen::MpiNonBlockingSum reduction;
+    Eigen::VectorXd mu = Eigen::VectorXd::Zero(size);
+    int iters = 10 * n;
+    double error = tolerance;
+    Eigen::internal::pipelined_conjugate_projected_gradient(
+            DistributedRows(PFP, counts, offsets, rank), Eigen::VectorXd(rhs.segment(begin, size)), mu,
+            DistributedRows(P, counts, offsets, rank), LocalJacobi(problem.F.diagonal().segment(begin, size)),
+            reduction, iters, error);
+
+    Eigen::VectorXd muGlobal(n);
+    MPI_Allgatherv(mu.data(), size, MPI_DOUBLE, muGlobal.data(), counts.data(), offsets.data(), MPI_DOUBLE,
+                   MPI_COMM_WORLD);
+
+    if (rank == 0)
+    {
+        std::cout << numRanks << " ranks, " << n << " multipliers\n";
+        Check(errorSerial < tolerance, "serial pipelined CPG converges (" + std::to_string(itersSerial) +
+                                               " iterations)");
+        Check(error < tolerance and (rhs - PFP * muGlobal).norm() < 2. * tolerance * rhs.norm(),
+              "distributed pipelined CPG converges (" + std::to_string(iters) + " iterations)");
+        Check(iters == itersSerial and (muGlobal - muSerial).norm() < 1.e-10 * muSerial.norm(),
+              "distributed pipelined CPG repeats the serial run");
+    }
+
+    const int result = rank == 0 ? TestResult() : EXIT_SUCCESS;
+    MPI_Finalize();
+    return result;
+}
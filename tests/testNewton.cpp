@@ -0,0 +1,184 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <eigen3/Eigen/SparseLU>
+#include "../NewtonSolver.h"
+#include "../SymbolicReuseSolver.h"
+#include "TestCheck.h"
+
+
+//! @brief Bar of n nonlinear springs fixed at the left end and pulled at the right end
+//!
+//! The force of spring i is k (Δu + c Δu³), hardening for c > 0. Its load path is elastic for small loads
+//! and turns nonlinear for large ones.
+struct SpringChain
+{
+    int mNumNodes;
+    double mC;
+    double mLoad = 0.;
+
+    double Force(double du) const
+    {
+        return du + mC * du * du * du;
+    }
+
+    double Stiffness(double du) const
+    {
+        return 1. + 3. * mC * du * du;
+    }
+
+    Eigen::VectorXd Residual(const Eigen::VectorXd& u) const
+    {
+        Eigen::VectorXd r = Eigen::VectorXd::Zero(mNumNodes);
+        for (int spring = 0; spring < mNumNodes; ++spring)
+        {
+            const double du = u[spring] - (spring > 0 ? u[spring - 1] : 0.);
+            r[spring] += Force(du);
+            if (spring > 0)
+                r[spring - 1] -= Force(du);
+        }
+        r[mNumNodes - 1] -= mLoad;
+        return r;
+    }
+
+    Eigen::SparseMatrix<double> Tangent(const Eigen::VectorXd& u) const
+    {
+        std::vector<Eigen::Triplet<double>> entries;
+        for (int spring = 0; spring < mNumNodes; ++spring)
+        {
+            const double k = Stiffness(u[spring] - (spring > 0 ? u[spring - 1] : 0.));
+            entries.emplace_back(spring, spring, k);
+            if (spring > 0)
+            {
+                entries.emplace_back(spring - 1, spring - 1, k);
+                entries.emplace_back(spring - 1, spring, -k);
+                entries.emplace_back(spring, spring - 1, -k);
+            }
+        }
+        Eigen::SparseMatrix<double> tangent(mNumNodes, mNumNodes);
+        tangent.setFromTriplets(entries.begin(), entries.end());
+        return tangent;
+    }
+};
+
+
+using Solver = NuTo::SymbolicReuseSolver<Eigen::SparseLU<Eigen::SparseMatrix<double>>>;
+
+
+//! @brief Runs numSteps load steps up to maxLoad, returns the sums over all steps
+NuTo::NewtonResult LoadPath(NuTo::eNewtonStrategy strategy, double c, double maxLoad, int numSteps,
+                            Eigen::VectorXd& u)
+{
+    SpringChain chain{100, c};
+    NuTo::NewtonOptions options;
+    options.mStrategy = strategy;
+    options.mTolerance = 1.e-10;
+    options.mMaxIterations = 50;
+    NuTo::NewtonSolver<Solver> newton(options);
+
+    NuTo::NewtonResult total;
+    total.mConverged = true;
+    u = Eigen::VectorXd::Zero(chain.mNumNodes);
+    for (int step = 1; step <= numSteps; ++step)
+    {
+        chain.mLoad = maxLoad * step / numSteps;
+        const auto result = newton.Solve([&](const Eigen::VectorXd& x) { return chain.Residual(x); },
+                                         [&](const Eigen::VectorXd& x) { return chain.Tangent(x); }, u);
+        total.mConverged = total.mConverged and result.mConverged;
+        total.mNumIterations += result.mNumIterations;
+        total.mNumFactorizations += result.mNumFactorizations;
+        total.mNumFallbacks += result.mNumFallbacks;
+    }
+    return total;
+}
+
+
+int main()
+{
+    const std::vector<std::pair<NuTo::eNewtonStrategy, std::string>> strategies = {
+            {NuTo::eNewtonStrategy::FullNewton, "full Newton"},
+            {NuTo::eNewtonStrategy::ModifiedNewton, "modified Newton"},
+            {NuTo::eNewtonStrategy::LBFGS, "LBFGS"}};
+
+    for (const auto& loadPath : {std::make_pair(0.02, "nearly elastic"), std::make_pair(50., "strongly nonlinear")})
+    {
+        std::cout << "\n" << loadPath.second << " load path\n";
+        std::vector<NuTo::NewtonResult> results;
+        Eigen::VectorXd reference;
+        for (const auto& strategy : strategies)
+        {
+            Eigen::VectorXd u;
+            results.push_back(LoadPath(strategy.first, 0.1, loadPath.first, 10, u));
+            if (reference.size() == 0)
+                reference = u;
+            const auto& result = results.back();
+            std::cout << strategy.second << ": " << result.mNumIterations << " iterations, "
+                      << result.mNumFactorizations << " factorizations, " << result.mNumFallbacks << " fallbacks\n";
+            Check(result.mConverged and (u - reference).norm() < 1.e-8 * reference.norm(),
+                  strategy.second + " converges to the same solution");
+        }
+        const int full = results[0].mNumFactorizations;
+        Check(results[1].mNumFactorizations < full and results[2].mNumFactorizations < full,
+              "modified Newton and LBFGS factorize less often");
+        Check(results[2].mNumIterations <= results[1].mNumIterations,
+              "LBFGS needs no more iterations than modified Newton");
+    }
+
+    // a sudden large load step after a converged small one: the kept, nearly linear tangent overshoots the
+    // hardening springs and the step falls back to full Newton
+    {
+        SpringChain chain{100, 10.};
+        NuTo::NewtonOptions options;
+        options.mStrategy = NuTo::eNewtonStrategy::ModifiedNewton;
+        options.mTolerance = 1.e-10;
+        options.mMaxIterations = 50;
+        NuTo::NewtonSolver<Solver> newton(options);
+        auto residual = [&](const Eigen::VectorXd& x) { return chain.Residual(x); };
+        auto tangent = [&](const Eigen::VectorXd& x) { return chain.Tangent(x); };
+
+        Eigen::VectorXd u = Eigen::VectorXd::Zero(chain.mNumNodes);
+        chain.mLoad = 0.01;
+        const auto small = newton.Solve(residual, tangent, u);
+        chain.mLoad = 100.;
+        const auto large = newton.Solve(residual, tangent, u);
+        std::cout << "\nlarge step: " << large.mNumIterations << " iterations, " << large.mNumFactorizations
+                  << " factorizations, " << large.mNumFallbacks << " fallbacks\n";
+        Check(small.mConverged and large.mConverged and large.mNumFallbacks > 0,
+              "a diverging step falls back to full Newton");
+        Check(large.mResidualNorm < options.mTolerance and (residual(u).norm() < options.mTolerance),
+              "the fallback converges to equilibrium");
+    }
+
+    // a residual that is not finite after a step with a new tangent, e.g. an element turned inside out: the step
+    // is undone and the call returns instead of refactorizing the same state until mMaxIterations
+    for (const auto& strategy : strategies)
+    {
+        SpringChain chain{100, 10.};
+        NuTo::NewtonOptions options;
+        options.mStrategy = strategy.first;
+        options.mTolerance = 1.e-10;
+        options.mMaxIterations = 50;
+        NuTo::NewtonSolver<Solver> newton(options);
+        auto residual = [&](const Eigen::VectorXd& x) {
+            return x.cwiseAbs().maxCoeff() > 10. ? Eigen::VectorXd::Constant(x.rows(), NAN) : chain.Residual(x);
+        };
+        auto tangent = [&](const Eigen::VectorXd& x) { return chain.Tangent(x); };
+
+        Eigen::VectorXd u = Eigen::VectorXd::Zero(chain.mNumNodes);
+        chain.mLoad = 0.01;
+        const auto small = newton.Solve(residual, tangent, u);
+        const Eigen::VectorXd uSmall = u;
+        chain.mLoad = 100.;
+        const auto large = newton.Solve(residual, tangent, u);
+        std::cout << "\n" << strategy.second << ", non-finite residual: " << large.mNumIterations << " iterations, "
+                  << large.mNumFactorizations << " factorizations\n";
+        Check(small.mConverged and not large.mConverged and large.mNumFactorizations == 1 and
+                      large.mNumIterations <= 2 and (u - uSmall).norm() < 1.e-12 * uSmall.norm() and
+                      std::isfinite(large.mResidualNorm),
+              strategy.second + " returns unconverged after a non-finite residual with a new tangent");
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,137 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+#include <eigen3/Eigen/SparseLU>
+#include <eigen3/Eigen/SparseCholesky>
+#include "../SparseOrdering.h"
+#include "TestCheck.h"
+
+
+//! @brief Pattern of trilinear hexahedra on a grid of n x n x n nodes, three dofs per node, diagonally dominant
+Eigen::SparseMatrix<double> GridMatrix(int n)
+{
+    auto node = [n](int x, int y, int z) { return (z * n + y) * n + x; };
+    std::vector<Eigen::Triplet<double>> entries;
+    for (int z = 0; z < n; ++z)
+        for (int y = 0; y < n; ++y)
+            for (int x = 0; x < n; ++x)
+                for (int dz = -1; dz <= 1; ++dz)
+                    for (int dy = -1; dy <= 1; ++dy)
+                        for (int dx = -1; dx <= 1; ++dx)
+                        {
+                            if (x + dx < 0 or x + dx >= n or y + dy < 0 or y + dy >= n or z + dz < 0 or
+                                z + dz >= n)
+                                continue;
+                            const bool diagonal = dx == 0 and dy == 0 and dz == 0;
+                            for (int a = 0; a < 3; ++a)
+                                for (int b = 0; b < 3; ++b)
+                                    entries.emplace_back(3 * node(x, y, z) + a, 3 * node(x + dx, y + dy, z + dz) + b,
+                                                         diagonal and a == b ? 100. : -1.);
+                        }
+    Eigen::SparseMatrix<double> matrix(3 * n * n * n, 3 * n * n * n);
+    matrix.setFromTriplets(entries.begin(), entries.end());
+    matrix.makeCompressed();
+    return matrix;
+}
+
+
+bool IsPermutation(std::vector<int> order, int n)
+{
+    std::sort(order.begin(), order.end());
+    for (int i = 0; i < n; ++i)
+        if (order.size() != static_cast<size_t>(n) or order[i] != i)
+            return false;
+    return true;
+}
+
+
+int main()
+{
+    const int gridSize = 12;
+    const Eigen::SparseMatrix<double> matrix = GridMatrix(gridSize);
+    const int n = matrix.rows();
+    const Eigen::VectorXd rhs = Eigen::VectorXd::Random(n);
+
+    for (const auto& ordering : NuTo::OrderingNames())
+        Check(IsPermutation(NuTo::EliminationOrder(matrix, ordering.first), n), ordering.second + " is a permutation");
+
+    // a separator of the bisection leaves no edge between the halves
+    {
+        const Graph graph = NuTo::SymmetricPatternGraph(matrix);
+        std::vector<int> side = GraphPartitioner().Partition(graph, 2);
+        const std::vector<int> separator = NuTo::VertexSeparator(graph, side);
+        for (const int v : separator)
+            side[v] = 2;
+        bool separated = true;
+        for (int v = 0; v < graph.size(); ++v)
+            for (int i = graph.mOffsets[v]; i < graph.mOffsets[v + 1]; ++i)
+                separated = separated and (side[v] == 2 or side[graph.mAdjacency[i]] == 2 or
+                                           side[v] == side[graph.mAdjacency[i]]);
+        std::cout << "\nseparator of " << separator.size() << " dofs, a plane has " << 3 * gridSize * gridSize << "\n";
+        Check(separated and separator.size() <= 1.5 * 3 * gridSize * gridSize, "vertex separator splits the grid");
+    }
+
+    std::cout << "\n";
+    std::map<NuTo::eOrdering, long> fill;
+    for (const auto& ordering : NuTo::OrderingNames())
+    {
+        NuTo::SelectableOrdering<int>::Set(ordering.first);
+        Eigen::SparseLU<Eigen::SparseMatrix<double>, NuTo::SelectableOrdering<int>> solver(matrix);
+        const Eigen::VectorXd x = solver.solve(rhs);
+        fill[ordering.first] = solver.nnzL() + solver.nnzU();
+        std::cout << ordering.second << ": nnz(L+U) " << fill[ordering.first] << "\n";
+        Check(solver.info() == Eigen::Success and (matrix * x - rhs).norm() < 1.e-10 * rhs.norm(),
+              "SparseLU solves with " + ordering.second);
+    }
+    Check(fill[NuTo::eOrdering::NestedDissection] < 0.8 * fill[NuTo::eOrdering::COLAMD] and
+                  fill[NuTo::eOrdering::NestedDissection] < fill[NuTo::eOrdering::AMD],
+          "nested dissection fills in less than the minimum degree orderings");
+
+    // RCM recovers a band from a random numbering of the grid nodes
+    {
+        std::vector<int> shuffle(n / 3);
+        std::iota(shuffle.begin(), shuffle.end(), 0);
+        std::shuffle(shuffle.begin(), shuffle.end(), std::mt19937(1));
+        Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> permutation(n);
+        for (int i = 0; i < n; ++i)
+            permutation.indices()[i] = 3 * shuffle[i / 3] + i % 3;
+        const Eigen::SparseMatrix<double> shuffled = permutation * matrix * permutation.transpose();
+
+        auto bandwidth = [&](const std::vector<int>& rOrder) {
+            std::vector<int> position(n);
+            for (int i = 0; i < n; ++i)
+                position[rOrder[i]] = i;
+            int width = 0;
+            for (int col = 0; col < n; ++col)
+                for (Eigen::SparseMatrix<double>::InnerIterator it(shuffled, col); it; ++it)
+                    width = std::max(width, std::abs(position[it.row()] - position[it.col()]));
+            return width;
+        };
+        const int randomBandwidth = bandwidth(NuTo::EliminationOrder(shuffled, NuTo::eOrdering::Natural));
+        const int rcmBandwidth = bandwidth(NuTo::EliminationOrder(shuffled, NuTo::eOrdering::RCM));
+        std::cout << "bandwidth " << randomBandwidth << " of a random numbering, " << rcmBandwidth << " after RCM\n";
+        Check(rcmBandwidth < 0.3 * randomBandwidth, "RCM reduces the bandwidth of a random numbering");
+    }
+
+    // the simplicial solvers expect the inverse convention
+    {
+        NuTo::SelectableOrdering<int, true>::Set(NuTo::eOrdering::AMD);
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>, Eigen::Lower, NuTo::SelectableSymmetricOrdering<int>>
+                selectable(matrix);
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> reference(matrix);
+        Check(selectable.matrixL().nestedExpression().nonZeros() ==
+                              reference.matrixL().nestedExpression().nonZeros() and
+                      (matrix * selectable.solve(rhs) - rhs).norm() < 1.e-10 * rhs.norm(),
+              "SimplicialLDLT with the symmetric convention equals Eigen's AMD");
+
+        Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::AMDOrdering<int>> eigenAmd(matrix);
+        std::cout << "Eigen's AMDOrdering in SparseLU: nnz(L+U) " << eigenAmd.nnzL() + eigenAmd.nnzU() << "\n";
+        Check(fill[NuTo::eOrdering::AMD] < eigenAmd.nnzL() + eigenAmd.nnzU(),
+              "AMD in the SparseLU convention fills in less than Eigen's AMDOrdering");
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../2dExamples/ImportMeshJson.h"
+#include "../2dExamples/MeshPartitioner.h"
+#include "TestCheck.h"
+
+
+//! @brief Writes a gmsh file of numX x numY quads with line elements on the left edge
+void WriteStructuredGmshMesh(const std::string& rFileName, int numX, int numY)
+{
+    std::ofstream file(rFileName);
+    file << "$MeshFormat\n2.2 0 8\n$EndMeshFormat\n";
+    file << "$PhysicalNames\n2\n1 1 \"Left\"\n2 2 \"Domain\"\n$EndPhysicalNames\n";
+
+    file << "$Nodes\n" << (numX + 1) * (numY + 1) << "\n";
+    for (int row = 0; row <= numY; ++row)
+        for (int col = 0; col <= numX; ++col)
+            file << row * (numX + 1) + col + 1 << " " << col * 0.5 << " " << row * 0.25 << " 0\n";
+    file << "$EndNodes\n";
+
+    file << "$Elements\n" << numY + numX * numY << "\n";
+    for (int row = 0; row < numY; ++row)
+        file << row + 1 << " 1 2 1 1 " << row * (numX + 1) + 1 << " " << (row + 1) * (numX + 1) + 1 << "\n";
+    for (int row = 0; row < numY; ++row)
+        for (int col = 0; col < numX; ++col)
+        {
+            const int node = row * (numX + 1) + col + 1;
+            file << numY + row * numX + col + 1 << " 3 2 2 5 " << node << " " << node + 1 << " "
+                 << node + numX + 2 << " " << node + numX + 1 << "\n";
+        }
+    file << "$EndElements\n";
+}
+
+
+//! @brief Number of connected components of every part
+std::vector<int> NumComponents(const Graph& rGraph, const std::vector<int>& rPartition, int numParts)
+{
+    std::vector<int> numComponents(numParts, 0);
+    std::vector<char> visited(rGraph.size(), 0);
+    for (int start = 0; start < rGraph.size(); ++start)
+    {
+        if (visited[start])
+            continue;
+        ++numComponents[rPartition[start]];
+        std::vector<int> stack(1, start);
+        visited[start] = 1;
+        while (not stack.empty())
+        {
+            const int v = stack.back();
+            stack.pop_back();
+            for (int i = rGraph.mOffsets[v]; i < rGraph.mOffsets[v + 1]; ++i)
+            {
+                const int u = rGraph.mAdjacency[i];
+                if (not visited[u] and rPartition[u] == rPartition[v])
+                {
+                    visited[u] = 1;
+                    stack.push_back(u);
+                }
+            }
+        }
+    }
+    return numComponents;
+}
+
+
+void CheckPartition(const ImportContainer& rMesh, int numParts, const std::string& rName)
+{
+    const Graph graph = ElementDualGraph(rMesh);
+    GraphPartitioner partitioner;
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<int> partition = partitioner.Partition(graph, numParts);
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<long> weights(numParts, 0);
+    for (const int part : partition)
+        ++weights[part];
+    const double average = double(graph.size()) / numParts;
+    const long heaviest = *std::max_element(weights.begin(), weights.end());
+
+    const SubdomainWriter writer(rMesh, partition, numParts);
+    std::cout << "\n" << rName << ", " << numParts << " parts: cut " << EdgeCut(graph, partition) << ", "
+              << writer.NumInterfaceNodes() << " interface nodes, heaviest part " << heaviest / average
+              << " x average, " << time << " s\n";
+
+    Check(*std::min_element(weights.begin(), weights.end()) > 0, "no part is empty");
+    Check(heaviest <= PartitionOptions().mImbalance * average + 1, "parts are balanced");
+    const std::vector<int> numComponents = NumComponents(graph, partition, numParts);
+    Check(std::all_of(numComponents.begin(), numComponents.end(), [](int n) { return n == 1; }),
+          "parts are connected");
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        // gmsh files and numbers of parts, e.g. ./testPartitioner ../meshFiles/2d/feti/feti_4_point_bending_test.msh 6
+        for (int i = 1; i + 1 < argc; i += 2)
+            CheckPartition(ReadGmshFile(argv[i]), std::stoi(argv[i + 1]), argv[i]);
+    }
+    else
+    {
+        const std::string fileName = "testPartitioner.msh";
+        const int numX = 120;
+        const int numY = 40;
+        WriteStructuredGmshMesh(fileName, numX, numY);
+
+        const ImportContainer mesh = ReadGmshFile(fileName);
+        Check(mesh.mNodeList.size() == (numX + 1) * (numY + 1) and mesh.mElementList.size() == numX * numY and
+                      mesh.mElementList.mIds[0] == numY + 1 and mesh.mElementList.mPhysicalGroups[0] == 2 and
+                      mesh.mElementList.mTypes[0] == eElementType::Quad4,
+              "gmsh file is read without the line elements");
+        Check(ReadGmshPhysicalNames(fileName).at(2) == "Domain", "physical names are read");
+
+        const Graph graph = ElementDualGraph(mesh);
+        Check(graph.size() == numX * numY and graph.mAdjacency.size() == 2 * ((numX - 1) * numY + numX * (numY - 1)),
+              "dual graph connects elements sharing an edge");
+
+        for (int numParts : {2, 3, 4, 7, 16})
+            CheckPartition(mesh, numParts, "structured mesh");
+
+        // four parts of 30 x 40 elements would be the strip partition with 3 x 41 interface nodes
+        const std::vector<int> partition = GraphPartitioner().Partition(graph, 4);
+        const SubdomainWriter writer(mesh, partition, 4, ReadGmshPhysicalNames(fileName));
+        Check(writer.NumInterfaceNodes() <= 1.1 * 3 * (numY + 1),
+              "interfaces are at most 10% larger than those of the strip partition");
+
+        // write the subdomain files and read them back
+        std::vector<ImportContainer> subdomains;
+        for (int subdomain = 0; subdomain < 4; ++subdomain)
+        {
+            const std::string subdomainFileName = "testPartitioner.mesh" + std::to_string(subdomain);
+            writer.Write(subdomain, subdomainFileName);
+            subdomains.push_back(ImportMeshJsonFile(subdomainFileName));
+            std::remove(subdomainFileName.c_str());
+        }
+
+        size_t numElements = 0;
+        bool elementsEqual = true;
+        bool nodesEqual = true;
+        for (int subdomain = 0; subdomain < 4; ++subdomain)
+        {
+            const ImportContainer& sub = subdomains[subdomain];
+            numElements += sub.mElementList.size();
+            for (size_t i = 0; i < sub.mElementList.size(); ++i)
+            {
+                const int element = sub.mElementList.mIds[i] - numY - 1;
+                elementsEqual = elementsEqual and partition[element] == subdomain and
+                                std::equal(sub.mElementList.NodeIds(i).begin(), sub.mElementList.NodeIds(i).end(),
+                                           mesh.mElementList.NodeIds(element).begin());
+            }
+            for (const auto& node : sub.mNodeList)
+                nodesEqual = nodesEqual and node.mCoordinates == mesh.mNodeList[node.mId - 1].mCoordinates;
+        }
+        Check(numElements == mesh.mElementList.size() and elementsEqual, "subdomain files contain all elements");
+        Check(nodesEqual, "subdomain nodes keep their ids and coordinates");
+
+        bool interfacesMatch = true;
+        for (int subdomain = 0; subdomain < 4; ++subdomain)
+        {
+            const ImportContainer& sub = subdomains[subdomain];
+            interfacesMatch = interfacesMatch and sub.mNumInterfaceNodes.size() == 1 and
+                              sub.mNumInterfaceNodes[0] == writer.NumInterfaceNodes();
+            for (const auto& interface : sub.mInterfaceList)
+            {
+                const int other = (interface.mMaster == subdomain + 1 ? interface.mSlave : interface.mMaster) - 1;
+                const auto& otherInterfaces = subdomains[other].mInterfaceList;
+                const auto match =
+                        std::find_if(otherInterfaces.begin(), otherInterfaces.end(), [&](const Interface& i) {
+                            return i.mMaster == interface.mMaster and i.mSlave == interface.mSlave;
+                        });
+                interfacesMatch = interfacesMatch and match != otherInterfaces.end() and
+                                  match->mNodeIdsMap == interface.mNodeIdsMap and
+                                  match->mGlobalStartId == interface.mGlobalStartId and
+                                  match->mValue == -interface.mValue and
+                                  interface.mValue == (interface.mMaster == subdomain + 1 ? 1 : -1);
+            }
+        }
+        Check(interfacesMatch, "both sides of every interface agree");
+
+        std::remove(fileName.c_str());
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,147 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <eigen3/Eigen/Sparse>
+#include "../AuxFunctions.h"
+#include "TestCheck.h"
+
+
+//! @brief Upwind convection-diffusion of two coupled fields on n x n nodes, the two dofs of a node are adjacent
+Eigen::SparseMatrix<double> ConvectionDiffusion(int n)
+{
+    std::vector<Eigen::Triplet<double>> entries;
+    for (int y = 0; y < n; ++y)
+        for (int x = 0; x < n; ++x)
+        {
+            const int node = y * n + x;
+            for (int field = 0; field < 2; ++field)
+            {
+                const int i = 2 * node + field;
+                entries.emplace_back(i, i, 4. + 1.5);
+                entries.emplace_back(i, 2 * node + 1 - field, field == 0 ? 2. : -2.); // strong node coupling
+                if (x > 0)
+                    entries.emplace_back(i, i - 2, -1. - 1.5); // upwind
+                if (x + 1 < n)
+                    entries.emplace_back(i, i + 2, -1.);
+                if (y > 0)
+                    entries.emplace_back(i, i - 2 * n, -1.);
+                if (y + 1 < n)
+                    entries.emplace_back(i, i + 2 * n, -1.);
+            }
+        }
+    Eigen::SparseMatrix<double> matrix(2 * n * n, 2 * n * n);
+    matrix.setFromTriplets(entries.begin(), entries.end());
+    return matrix;
+}
+
+
+template <typename Preconditioner>
+int CheckBiCGStab(const Eigen::SparseMatrix<double>& rMatrix, const Preconditioner& rPrecond,
+                  const std::string& rName)
+{
+    const Eigen::VectorXd rhs = Eigen::VectorXd::LinSpaced(rMatrix.rows(), 1., 2.);
+    Eigen::VectorXd x = Eigen::VectorXd::Zero(rMatrix.rows());
+    int iters = 1000;
+    NuTo::BiCGStab(rMatrix, rhs, x, rPrecond, 1.e-10, iters);
+    Check((rhs - rMatrix * x).norm() < 1.e-9 * rhs.norm(),
+          "BiCGStab with " + rName + " converges (" + std::to_string(iters) + " iterations)");
+    return iters;
+}
+
+
+template <typename Preconditioner, typename MatrixType>
+bool Throws(const MatrixType& rMatrix)
+{
+    try
+    {
+        Preconditioner precond(rMatrix);
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+
+Eigen::SparseMatrix<double> FromDense(const Eigen::MatrixXd& rMatrix)
+{
+    // keeps explicit zeros, unlike sparseView
+    std::vector<Eigen::Triplet<double>> entries;
+    for (int row = 0; row < rMatrix.rows(); ++row)
+        for (int col = 0; col < rMatrix.cols(); ++col)
+            entries.emplace_back(row, col, rMatrix(row, col));
+    Eigen::SparseMatrix<double> matrix(rMatrix.rows(), rMatrix.cols());
+    matrix.setFromTriplets(entries.begin(), entries.end());
+    return matrix;
+}
+
+
+int main()
+{
+    // all preconditioners inside BiCGStab
+    {
+        const Eigen::SparseMatrix<double> A = ConvectionDiffusion(30);
+        const int itersJacobi = CheckBiCGStab(A, NuTo::JacobiPreconditioner(A), "Jacobi");
+        const int itersBlockJacobi = CheckBiCGStab(A, NuTo::BlockJacobiPreconditioner(A, 2), "block Jacobi");
+        const int itersILU = CheckBiCGStab(A, NuTo::ILU0Preconditioner(A), "ILU(0)");
+        Check(itersBlockJacobi < itersJacobi, "block Jacobi beats Jacobi for coupled dofs of a node");
+        Check(itersILU < itersBlockJacobi, "ILU(0) beats block Jacobi");
+
+        // dense matrices and the FullPivLU preconditioner of the original interface still work
+        const Eigen::MatrixXd dense = A.topLeftCorner(50, 50);
+        CheckBiCGStab(A.topLeftCorner(50, 50), Eigen::FullPivLU<Eigen::MatrixXd>(dense), "FullPivLU");
+        Eigen::VectorXd x = Eigen::VectorXd::Zero(50);
+        int iters = 100;
+        NuTo::BiCGStab(dense, Eigen::VectorXd::Ones(50), x, NuTo::ILU0Preconditioner(dense), 1.e-10, iters);
+        Check((dense * x - Eigen::VectorXd::Ones(50)).norm() < 1.e-9, "BiCGStab with a dense matrix converges");
+    }
+
+    // without dropped entries the preconditioners are exact
+    {
+        Eigen::MatrixXd A = Eigen::MatrixXd::Random(6, 6);
+        A.diagonal().array() += 6.;
+        const Eigen::VectorXd rhs = Eigen::VectorXd::LinSpaced(6, -1., 1.);
+        const Eigen::VectorXd exact = A.partialPivLu().solve(rhs);
+        Check((NuTo::ILU0Preconditioner(A).solve(rhs) - exact).norm() < 1.e-12 * exact.norm(),
+              "ILU(0) of a full pattern is the exact LU");
+        Check((NuTo::ILU0Preconditioner(FromDense(A)).solve(rhs) - exact).norm() < 1.e-12 * exact.norm(),
+              "ILU(0) of a sparse matrix with a full pattern is the exact LU");
+        Check((NuTo::BlockJacobiPreconditioner(A, 6).solve(rhs) - exact).norm() < 1.e-12 * exact.norm(),
+              "block Jacobi with a single block is exact");
+        Check((NuTo::BlockJacobiPreconditioner(FromDense(A), 4).solve(rhs) -
+               NuTo::BlockJacobiPreconditioner(A, 4).solve(rhs))
+                              .norm() < 1.e-14 * exact.norm(),
+              "block Jacobi of dense and sparse matrices agree, the last block is smaller");
+        Check((NuTo::JacobiPreconditioner(A).solve(rhs) - rhs.cwiseQuotient(A.diagonal())).norm() < 1.e-14,
+              "Jacobi divides by the diagonal");
+    }
+
+    // the pivot of ILU(0) is checked after the elimination of its row
+    {
+        const Eigen::Matrix2d cancelled = (Eigen::Matrix2d() << 1., 1., 1., 1.).finished();
+        Check(Throws<NuTo::ILU0Preconditioner>(FromDense(cancelled)),
+              "ILU(0) throws if the elimination cancels a pivot");
+        Check(Throws<NuTo::ILU0Preconditioner>(Eigen::MatrixXd(cancelled)),
+              "ILU(0) of a dense matrix throws if the elimination cancels a pivot");
+
+        const Eigen::Matrix2d filled = (Eigen::Matrix2d() << 1., 1., 1., 0.).finished();
+        const Eigen::VectorXd rhs = Eigen::Vector2d(1., 2.);
+        const Eigen::VectorXd exact = filled.inverse() * rhs;
+        const bool factorized = not Throws<NuTo::ILU0Preconditioner>(FromDense(filled)) and
+                          not Throws<NuTo::ILU0Preconditioner>(Eigen::MatrixXd(filled));
+        Check(factorized and (NuTo::ILU0Preconditioner(FromDense(filled)).solve(rhs) - exact).norm() < 1.e-14 and
+                      (NuTo::ILU0Preconditioner(Eigen::MatrixXd(filled)).solve(rhs) - exact).norm() < 1.e-14,
+              "ILU(0) accepts a zero diagonal that the elimination fills");
+
+        Eigen::SparseMatrix<double> noDiagonal(2, 2);
+        noDiagonal.insert(0, 1) = 1.;
+        noDiagonal.insert(1, 0) = 1.;
+        Check(Throws<NuTo::ILU0Preconditioner>(noDiagonal), "ILU(0) throws without a diagonal entry in the pattern");
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Sparse>
+
+#include "../2dExamples/ConjugateProjectedGradient.h"
+#include "../2dExamples/ProjectedBiCGStabL.h"
+#include "../2dExamples/ProjectedGMRES.h"
+#include "../2dExamples/ProjectedIDRS.h"
+#include "FetiInterfaceProblem.h"
+#include "TestCheck.h"
+
+constexpr double tolerance = 1.e-10;
+
+
+//! @brief Consistent system P F P μ = P (d - F λ0) of an interface problem and its reference solution by CPG
+struct ProjectedSystem
+{
+    explicit ProjectedSystem(const FetiInterfaceProblem& rProblem)
+        : problem(rProblem)
+        , n(rProblem.F.rows())
+        , FSparse(rProblem.F.sparseView())
+        , jacobi(FSparse)
+    {
+        const Eigen::LDLT<Eigen::MatrixXd> GtG(problem.G.transpose() * problem.G);
+        P = Eigen::MatrixXd::Identity(n, n) - problem.G * GtG.solve(problem.G.transpose());
+        lambda0 = problem.G * GtG.solve(problem.e);
+        PFP = P * problem.F * P;
+        rhs = P * (problem.d - problem.F * lambda0);
+
+        muCpg = Eigen::VectorXd::Zero(n);
+        itersCpg = 10 * n;
+        double error = tolerance;
+        Eigen::internal::conjugate_projected_gradient(PFP, rhs, muCpg, P, Preconditioner(), itersCpg, error);
+        Check(error < tolerance, "reference CPG converges (" + std::to_string(itersCpg) + " iterations)");
+    }
+
+    //! @brief P M⁻¹ P with the Jacobi preconditioner M of F
+    ProjectedPreconditioner<Eigen::DiagonalPreconditioner<double>> Preconditioner() const
+    {
+        return ProjectedPreconditioner<Eigen::DiagonalPreconditioner<double>>(P, jacobi);
+    }
+
+    //! @brief μ solves the system for \a rRhs and lies in range(P)
+    bool IsSolution(const Eigen::VectorXd& rMu, const Eigen::VectorXd& rRhs) const
+    {
+        return (rRhs - PFP * rMu).norm() < 2. * tolerance * rRhs.norm() and
+               (P * rMu - rMu).norm() < 1.e-10 * rMu.norm();
+    }
+
+    FetiInterfaceProblem problem;
+    int n;
+    Eigen::SparseMatrix<double> FSparse;
+    Eigen::DiagonalPreconditioner<double> jacobi;
+    Eigen::MatrixXd P;
+    Eigen::VectorXd lambda0;
+    Eigen::MatrixXd PFP;
+    Eigen::VectorXd rhs;
+    Eigen::VectorXd muCpg;
+    int itersCpg;
+};
+
+
+//! @brief The operator and the projection only known through their action give the results of the matrices
+void CheckMatrixFree(const ProjectedSystem& rSystem)
+{
+    int numApplications = 0;
+    const auto op = Eigen::makeMatrixFreeOperator(
+            [&](const Eigen::VectorXd& rV) -> Eigen::VectorXd {
+                ++numApplications;
+                return rSystem.PFP * rV;
+            },
+            rSystem.n);
+    const auto projection =
+            Eigen::makeMatrixFreeOperator([&](const Eigen::VectorXd& rV) -> Eigen::VectorXd { return rSystem.P * rV; },
+                                          rSystem.n);
+
+    Eigen::VectorXd mu = Eigen::VectorXd::Zero(rSystem.n);
+    int iters = 10 * rSystem.n;
+    double error = tolerance;
+    Eigen::internal::conjugate_projected_gradient(op, rSystem.rhs, mu, projection, rSystem.Preconditioner(), iters,
+                                                  error);
+    Check(rSystem.IsSolution(mu, rSystem.rhs) and iters == rSystem.itersCpg and
+                  (mu - rSystem.muCpg).norm() < 1.e-12 * rSystem.muCpg.norm(),
+          "matrix-free CPG repeats the assembled CPG");
+    Check(numApplications == iters + 2, "matrix-free CPG applies the operator once per iteration");
+}
+
+
+//! @brief Block CG for several right hand sides, including a duplicate and a zero column
+void CheckBlock(const ProjectedSystem& rSystem)
+{
+    const int n = rSystem.n;
+    Eigen::MatrixXd B(n, 4);
+    B.col(0) = rSystem.rhs;
+    B.col(1) = rSystem.PFP * Eigen::VectorXd::LinSpaced(n, 0., 1.);
+    B.col(2) = rSystem.rhs;
+    B.col(3).setZero();
+
+    int itersSingle = 0;
+    Eigen::MatrixXd muSingle = Eigen::MatrixXd::Zero(n, 4);
+    for (int j = 0; j < 2; ++j)
+    {
+        Eigen::VectorXd mu = Eigen::VectorXd::Zero(n);
+        int iters = 10 * n;
+        double error = tolerance;
+        Eigen::internal::conjugate_projected_gradient(rSystem.PFP, B.col(j), mu, rSystem.P, rSystem.Preconditioner(),
+                                                      iters, error);
+        muSingle.col(j) = mu;
+        itersSingle += iters;
+    }
+    muSingle.col(2) = muSingle.col(0);
+
+    for (const int numRhs : {2, 4})
+    {
+        const std::string name = "block CPG with " + std::to_string(numRhs) + " right hand sides";
+        Eigen::MatrixXd mu = Eigen::MatrixXd::Constant(n, numRhs, 1.);
+        mu = rSystem.P * mu; // a non-zero initial guess in range(P)
+        int iters = 10 * n;
+        double error = tolerance;
+        Eigen::internal::block_conjugate_projected_gradient(rSystem.PFP, B.leftCols(numRhs), mu, rSystem.P,
+                                                            rSystem.Preconditioner(), iters, error);
+
+        bool solved = error < tolerance and mu.allFinite();
+        for (int j = 0; j < std::min(numRhs, 3); ++j)
+            solved = solved and rSystem.IsSolution(mu.col(j), B.col(j)) and
+                     (mu.col(j) - muSingle.col(j)).norm() < 1.e-6 * muSingle.col(j).norm();
+        Check(solved, name + " converges and matches CPG (" + std::to_string(iters) + " iterations)");
+        if (numRhs == 2)
+            Check(iters < itersSingle, name + " needs fewer operator applications than single solves (" +
+                                               std::to_string(iters) + " instead of " +
+                                               std::to_string(itersSingle) + ")");
+        else
+            Check(mu.col(3).isZero(0.), name + " returns zero for a zero right hand side");
+    }
+
+    // MatrixFreeOperator applies its functor column by column
+    const auto op = Eigen::makeMatrixFreeOperator(
+            [&](const Eigen::VectorXd& rV) -> Eigen::VectorXd { return rSystem.PFP * rV; }, n);
+    Eigen::MatrixXd muMatrixFree = Eigen::MatrixXd::Zero(n, 2);
+    Eigen::MatrixXd muAssembled = Eigen::MatrixXd::Zero(n, 2);
+    int itersMatrixFree = 10 * n, itersAssembled = 10 * n;
+    double errorMatrixFree = tolerance, errorAssembled = tolerance;
+    Eigen::internal::block_conjugate_projected_gradient(op, B.leftCols(2), muMatrixFree, rSystem.P,
+                                                        rSystem.Preconditioner(), itersMatrixFree, errorMatrixFree);
+    Eigen::internal::block_conjugate_projected_gradient(rSystem.PFP, B.leftCols(2), muAssembled, rSystem.P,
+                                                        rSystem.Preconditioner(), itersAssembled, errorAssembled);
+    Check(itersMatrixFree == itersAssembled and (muMatrixFree - muAssembled).norm() < 1.e-12 * muAssembled.norm(),
+          "matrix-free block CPG repeats the assembled block CPG");
+}
+
+
+//! @brief Pipelined CG, serial, the distributed run is covered by testMpiPipelinedCG
+void CheckPipelined(const ProjectedSystem& rSystem)
+{
+    Eigen::LocalReduction reduction;
+    Eigen::VectorXd mu = Eigen::VectorXd::Zero(rSystem.n);
+    int iters = 10 * rSystem.n;
+    double error = tolerance;
+    Eigen::internal::pipelined_conjugate_projected_gradient(rSystem.PFP, rSystem.rhs, mu, rSystem.P, rSystem.jacobi,
+                                                            reduction, iters, error);
+    Check(error < tolerance and rSystem.IsSolution(mu, rSystem.rhs) and
+                  (mu - rSystem.muCpg).norm() < 1.e-8 * rSystem.muCpg.norm(),
+          "pipelined CPG converges and matches CPG (" + std::to_string(iters) + " iterations)");
+    // the convergence check lags one iteration behind
+    Check(iters <= rSystem.itersCpg + 1, "pipelined CPG needs at most one iteration more than CPG");
+
+    iters = 10 * rSystem.n;
+    error = tolerance;
+    Eigen::internal::pipelined_conjugate_projected_gradient(rSystem.PFP, rSystem.rhs, mu, rSystem.P, rSystem.jacobi,
+                                                            reduction, iters, error);
+    Check(iters == 0, "pipelined CPG returns immediately for the exact initial guess");
+}
+
+
+//! @brief The implicit projection against the assembled one, for dense and sparse G
+template <typename GMatrixType>
+void CheckProjector(const ProjectedSystem& rSystem, const GMatrixType& rG, const std::string& rName)
+{
+    const Eigen::NaturalCoarseSpaceProjector<GMatrixType> projector(rG);
+    const Eigen::MatrixXd block = Eigen::MatrixXd::Random(rSystem.n, 3);
+    const Eigen::VectorXd lambda0 = projector.particularSolution(rSystem.problem.e);
+
+    Check(projector.rows() == rSystem.n and projector.coarseSize() == rSystem.problem.G.cols(),
+          rName + " projector has the size of the interface and the coarse space");
+    Check((projector * block.col(0) - rSystem.P * block.col(0)).norm() < 1.e-12 * block.col(0).norm() and
+                  (projector * block - rSystem.P * block).norm() < 1.e-12 * block.norm(),
+          rName + " projector applies the assembled P to vectors and blocks");
+    Check((lambda0 - rSystem.lambda0).norm() < 1.e-12 * rSystem.lambda0.norm() and
+                  (rSystem.problem.G.transpose() * lambda0 - rSystem.problem.e).norm() <
+                          1.e-12 * rSystem.problem.e.norm(),
+          rName + " projector gives the particular solution");
+
+    Eigen::VectorXd mu = Eigen::VectorXd::Zero(rSystem.n);
+    int iters = 10 * rSystem.n;
+    double error = tolerance;
+    Eigen::internal::conjugate_projected_gradient(rSystem.PFP, rSystem.rhs, mu, projector, rSystem.Preconditioner(),
+                                                  iters, error);
+    Check(rSystem.IsSolution(mu, rSystem.rhs) and iters == rSystem.itersCpg and
+                  (mu - rSystem.muCpg).norm() < 1.e-10 * rSystem.muCpg.norm(),
+          "CPG with the " + rName + " projector repeats CPG with the assembled P");
+}
+
+
+//! @brief CG iterations in float refined in double reach the double tolerance, plain float CG does not
+void CheckMixedPrecision(const ProjectedSystem& rSystem)
+{
+    const Eigen::MatrixXf PFPLow = rSystem.PFP.cast<float>();
+    const Eigen::MatrixXf PLow = rSystem.P.cast<float>();
+    const Eigen::SparseMatrix<float> FLow = rSystem.FSparse.cast<float>();
+    const Eigen::DiagonalPreconditioner<float> jacobiLow(FLow);
+    const ProjectedPreconditioner<Eigen::DiagonalPreconditioner<float>, Eigen::MatrixXf> precondLow(PLow, jacobiLow);
+
+    Eigen::VectorXd mu = Eigen::VectorXd::Zero(rSystem.n);
+    int iters = 10 * rSystem.n;
+    double error = tolerance;
+    Eigen::internal::mixed_precision_conjugate_projected_gradient(rSystem.PFP, PFPLow, rSystem.rhs, mu, rSystem.P,
+                                                                  PLow, precondLow, iters, error);
+    Check(error < tolerance and rSystem.IsSolution(mu, rSystem.rhs) and
+                  (mu - rSystem.muCpg).norm() < 1.e-8 * rSystem.muCpg.norm(),
+          "mixed precision CPG reaches the double tolerance, stays in range(P) and matches CPG (" +
+                  std::to_string(iters) + " inner iterations)");
+
+    Eigen::VectorXf muLow = Eigen::VectorXf::Zero(rSystem.n);
+    int itersLow = 10 * rSystem.n;
+    float errorLow = tolerance;
+    Eigen::internal::conjugate_projected_gradient(PFPLow, Eigen::VectorXf(rSystem.rhs.cast<float>()), muLow, PLow,
+                                                  precondLow, itersLow, errorLow);
+    const Eigen::VectorXd residualLow = rSystem.rhs - rSystem.PFP * muLow.cast<double>();
+    Check(residualLow.norm() > 1.e3 * tolerance * rSystem.rhs.norm(),
+          "float CPG alone stalls above the double tolerance");
+}
+
+
+//! @brief IDR(s) and BiCGStab(l) on the symmetric system and on a non-symmetric one, checked against GMRES
+void CheckNonSymmetricSolvers(const ProjectedSystem& rSystem)
+{
+    const int n = rSystem.n;
+    Eigen::MatrixXd skew = Eigen::MatrixXd::Random(n, n);
+    skew = 0.1 * rSystem.problem.F.diagonal().mean() * (skew - skew.transpose());
+    const Eigen::MatrixXd nonSymmetric = rSystem.PFP + rSystem.P * skew * rSystem.P;
+
+    Eigen::VectorXd muGmres = Eigen::VectorXd::Zero(n);
+    int itersGmres = 10 * n;
+    double errorGmres = tolerance;
+    Eigen::internal::projected_fgmres(nonSymmetric, rSystem.rhs, muGmres, rSystem.P, rSystem.Preconditioner(),
+                                      itersGmres, errorGmres, n);
+    Check(errorGmres < tolerance, "GMRES solves the non-symmetric system");
+
+    const Eigen::MatrixXd* operators[2] = {&rSystem.PFP, &nonSymmetric};
+    const Eigen::VectorXd* references[2] = {&rSystem.muCpg, &muGmres};
+    for (int i = 0; i < 2; ++i)
+    {
+        const std::string system = i == 0 ? " on the symmetric system" : " on the non-symmetric system";
+        const Eigen::MatrixXd& op = *operators[i];
+        const Eigen::VectorXd& reference = *references[i];
+        const auto solved = [&](const Eigen::VectorXd& rMu, double rError) {
+            return rError < tolerance and (rSystem.rhs - op * rMu).norm() < 2. * tolerance * rSystem.rhs.norm() and
+                   (rSystem.P * rMu - rMu).norm() < 1.e-10 * rMu.norm() and
+                   (rMu - reference).norm() < 1.e-6 * reference.norm();
+        };
+
+        for (int s : {1, 4})
+        {
+            Eigen::VectorXd mu = Eigen::VectorXd::Zero(n);
+            int iters = 10 * n;
+            double error = tolerance;
+            Eigen::internal::projected_idrs(op, rSystem.rhs, mu, rSystem.P, rSystem.Preconditioner(), iters, error, s);
+            Check(solved(mu, error), "IDR(" + std::to_string(s) + ") converges, stays in range(P) and matches the "
+                                     "reference" + system + " (" + std::to_string(iters) + " iterations)");
+        }
+        for (int l : {1, 2})
+        {
+            Eigen::VectorXd mu = Eigen::VectorXd::Zero(n);
+            int iters = 10 * n;
+            double error = tolerance;
+            Eigen::internal::projected_bicgstabl(op, rSystem.rhs, mu, rSystem.P, rSystem.Preconditioner(), iters,
+                                                 error, l);
+            Check(solved(mu, error), "BiCGStab(" + std::to_string(l) + ") converges, stays in range(P) and matches "
+                                     "the reference" + system + " (" + std::to_string(iters) + " iterations)");
+        }
+    }
+}
+
+
+//! @brief Counts the phases between two reported iterations
+class RecordingObserver : public NuTo::IterationObserver
+{
+public:
+    void StartSolve() override
+    {
+        ++mNumSolves;
+        mPhases.fill(0);
+    }
+
+    void StartPhase(NuTo::eSolverPhase phase) override
+    {
+        ++mPhases[static_cast<int>(phase)];
+    }
+
+    void Iteration(int iteration, double residual) override
+    {
+        mRows.push_back(mPhases);
+        mPhases.fill(0);
+        mLastIteration = iteration;
+        mLastResidual = residual;
+    }
+
+    int mNumSolves = 0;
+    std::array<int, 4> mPhases = {{0, 0, 0, 0}};
+    std::vector<std::array<int, 4>> mRows;
+    int mLastIteration = 0;
+    double mLastResidual = 0.;
+};
+
+
+//! @brief Every phase of an iteration is reported with it, including those of the initial search direction
+void CheckObserver(const ProjectedSystem& rSystem)
+{
+    constexpr int op = static_cast<int>(NuTo::eSolverPhase::Operator);
+    constexpr int precond = static_cast<int>(NuTo::eSolverPhase::Preconditioner);
+    constexpr int projection = static_cast<int>(NuTo::eSolverPhase::Projection);
+
+    RecordingObserver observer;
+    Eigen::VectorXd mu = Eigen::VectorXd::Zero(rSystem.n);
+    int iters = 10 * rSystem.n;
+    double error = tolerance;
+    Eigen::internal::conjugate_projected_gradient(rSystem.PFP, rSystem.rhs, mu, rSystem.P, rSystem.jacobi, iters,
+                                                  error, 0, 0, &observer);
+
+    bool oneOperatorPerRow = true;
+    int numPreconditioners = 0, numProjections = 0;
+    for (const auto& row : observer.mRows)
+    {
+        oneOperatorPerRow = oneOperatorPerRow and row[op] == 1;
+        numPreconditioners += row[precond];
+        numProjections += row[projection];
+    }
+    const int numRows = observer.mRows.size();
+    Check(observer.mNumSolves == 1 and numRows == iters + 1 and observer.mLastIteration == numRows and
+                  std::abs(observer.mLastResidual - error) < 1.e-12 * error,
+          "CPG reports every iteration and the final residual");
+    Check(oneOperatorPerRow and numPreconditioners == numRows and numProjections == numRows and
+                  observer.mPhases == std::array<int, 4>{{0, 0, 0, 0}},
+          "CPG reports the phases with their iteration, the initial direction with the first one");
+
+    // BiCGStab(2) applies the operator twice per step, the MR update of a cycle is reported with its last step
+    constexpr int reduction = static_cast<int>(NuTo::eSolverPhase::Reduction);
+    RecordingObserver bicgObserver;
+    mu.setZero();
+    iters = 10 * rSystem.n;
+    error = tolerance;
+    Eigen::internal::projected_bicgstabl(rSystem.PFP, rSystem.rhs, mu, rSystem.P, rSystem.Preconditioner(), iters,
+                                         error, 2, &bicgObserver);
+    bool reductionPerRow = true;
+    for (const auto& row : bicgObserver.mRows)
+        reductionPerRow = reductionPerRow and row[op] == 2 and row[reduction] >= 2;
+    const int numSteps = bicgObserver.mRows.size();
+    Check(reductionPerRow and 2 * numSteps == iters and bicgObserver.mLastIteration == iters and
+                  std::abs(bicgObserver.mLastResidual - error) < 1.e-12 * error,
+          "BiCGStab(l) reports every step with its dot products and the final residual");
+
+    const Eigen::MatrixXf PFPLow = rSystem.PFP.cast<float>();
+    const Eigen::MatrixXf PLow = rSystem.P.cast<float>();
+    const Eigen::SparseMatrix<float> FLow = rSystem.FSparse.cast<float>();
+    const Eigen::DiagonalPreconditioner<float> jacobiLow(FLow);
+    RecordingObserver mixedObserver;
+    mu.setZero();
+    iters = 10 * rSystem.n;
+    error = tolerance;
+    Eigen::internal::mixed_precision_conjugate_projected_gradient(rSystem.PFP, PFPLow, rSystem.rhs, mu, rSystem.P,
+                                                                  PLow, jacobiLow, iters, error, 1.e-4,
+                                                                  &mixedObserver);
+    Check(mixedObserver.mNumSolves > 1 and mixedObserver.mRows.size() >= static_cast<size_t>(iters),
+          "mixed precision CPG reports the iterations of every refinement step");
+}
+
+
+void RunTests(const FetiInterfaceProblem& rProblem, const std::string& rName)
+{
+    std::cout << "\n" << rName << ": " << rProblem.F.rows() << " multipliers, " << rProblem.G.cols()
+              << " rigid body modes\n";
+    const ProjectedSystem system(rProblem);
+    CheckMatrixFree(system);
+    CheckBlock(system);
+    CheckPipelined(system);
+    CheckProjector(system, rProblem.G, "dense");
+    CheckProjector(system, Eigen::SparseMatrix<double>(rProblem.G.sparseView()), "sparse");
+    CheckMixedPrecision(system);
+    CheckNonSymmetricSolvers(system);
+    CheckObserver(system);
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        // saved interface problems, e.g. ./testProjectedSolvers feti_0_ feti_1_
+        for (int i = 1; i < argc; ++i)
+            RunTests(LoadFetiInterfaceProblem(argv[i]), argv[i]);
+    }
+    else
+    {
+        RunTests(CreateFetiInterfaceProblem(4, 8), "4 subdomains, 8x8 nodes");
+        RunTests(CreateFetiInterfaceProblem(8, 12), "8 subdomains, 12x12 nodes");
+    }
+
+    return TestResult();
+}
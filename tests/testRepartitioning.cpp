@@ -0,0 +1,154 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <string>
+
+#include "../2dExamples/Repartitioning.h"
+#include "TestCheck.h"
+
+
+//! @brief Dual graph of numX x numY quads, element row * numX + col
+Graph StructuredDualGraph(int numX, int numY)
+{
+    Graph graph;
+    for (int row = 0; row < numY; ++row)
+        for (int col = 0; col < numX; ++col)
+        {
+            if (row > 0)
+                graph.mAdjacency.push_back((row - 1) * numX + col);
+            if (col > 0)
+                graph.mAdjacency.push_back(row * numX + col - 1);
+            if (col + 1 < numX)
+                graph.mAdjacency.push_back(row * numX + col + 1);
+            if (row + 1 < numY)
+                graph.mAdjacency.push_back((row + 1) * numX + col);
+            graph.mOffsets.push_back(graph.mAdjacency.size());
+        }
+    graph.mEdgeWeights.assign(graph.mAdjacency.size(), 2);
+    graph.mVertexWeights.assign(numX * numY, 1);
+    return graph;
+}
+
+
+int main()
+{
+    // two costs, recovered from the times of three ranks
+    {
+        const std::vector<int> numElements = {1000, 1200, 800};
+        const std::vector<int> numActive = {0, 50, 300};
+        std::vector<double> times;
+        for (int rank = 0; rank < 3; ++rank)
+            times.push_back(2.e-3 * numElements[rank] + 3.e-2 * numActive[rank]);
+        const ElementCostModel model = ElementCostModel::Fit(times, numElements, numActive);
+        Check(std::abs(model.mCostPerElement - 2.e-3) < 1.e-12 and
+                      std::abs(model.mCostPerActiveElement - 3.e-2) < 1.e-12,
+              "cost model is fitted to the measured times");
+
+        const ElementCostModel undamaged = ElementCostModel::Fit(times, numElements, {0, 0, 0});
+        Check(undamaged.mCostPerActiveElement == 0. and
+                      std::abs(undamaged.mCostPerElement - (times[0] + times[1] + times[2]) / 3000.) < 1.e-12,
+              "cost model without active elements is the mean cost per element");
+    }
+
+    Check(CostWeights({1., 2.5, 1.}) == std::vector<int>({10, 25, 10}), "costs are scaled to integer weights");
+
+    // strips of 30 x 40 elements, the damage is localized in the first one
+    const int numX = 120;
+    const int numY = 40;
+    const int numParts = 4;
+    const Graph graph = StructuredDualGraph(numX, numY);
+    std::vector<int> oldPartition(graph.size());
+    std::vector<double> costs(graph.size(), 1.);
+    for (int row = 0; row < numY; ++row)
+        for (int col = 0; col < numX; ++col)
+        {
+            oldPartition[row * numX + col] = 3 - col / 30;
+            if (col < 10)
+                costs[row * numX + col] = 6.;
+        }
+
+    {
+        std::vector<int> relabelled(oldPartition.size());
+        for (size_t i = 0; i < oldPartition.size(); ++i)
+            relabelled[i] = (oldPartition[i] + 1) % numParts;
+        MatchPartLabels(oldPartition, relabelled, numParts);
+        Check(relabelled == oldPartition, "permuted labels are matched to the old ones");
+    }
+
+    const std::vector<double> uniform(graph.size(), 1.);
+    const RepartitionResult unchanged = Repartition(graph, oldPartition, uniform, numParts);
+    Check(unchanged.mPartition == oldPartition and unchanged.mNumMigratedElements == 0,
+          "balanced partition is kept");
+
+    const RepartitionResult result = Repartition(graph, oldPartition, costs, numParts);
+    std::cout << "\nimbalance " << result.mImbalanceBefore << " -> " << result.mImbalanceAfter << ", "
+              << result.mNumMigratedElements << " of " << graph.size() << " elements migrate\n";
+    Check(result.mImbalanceBefore > 1.8 and result.mImbalanceAfter < 1.1, "damaged part is balanced by cost");
+    long numStaying = 0;
+    for (int i = 0; i < graph.size(); ++i)
+        numStaying += oldPartition[i] == result.mPartition[i];
+    // the best labelling keeps at least a quarter of the elements, a random one about a quarter
+    Check(numStaying > graph.size() / 3, "most elements stay on their rank");
+
+    // restart files of the old partition read back by the new one
+    {
+        const int valuesPerElement = 4;
+        std::vector<ElementState> states(numParts);
+        for (int i = 0; i < graph.size(); ++i)
+        {
+            ElementState& state = states[oldPartition[i]];
+            state.mValuesPerElement = valuesPerElement;
+            state.mIds.push_back(i + 1);
+            for (int ip = 0; ip < valuesPerElement; ++ip)
+                state.mValues.push_back(i + 0.25 * ip);
+        }
+        for (int part = 0; part < numParts; ++part)
+            WriteElementState(states[part], "testRepartitioning.state" + std::to_string(part));
+
+        bool equal = true;
+        size_t numRead = 0;
+        for (int part = 0; part < numParts; ++part)
+        {
+            std::vector<int> ids;
+            for (int i = 0; i < graph.size(); ++i)
+                if (result.mPartition[i] == part)
+                    ids.push_back(i + 1);
+            const ElementState state = ReadElementState("testRepartitioning.state", numParts, ids);
+            numRead += state.size();
+            for (size_t i = 0; i < state.size(); ++i)
+                for (int ip = 0; ip < valuesPerElement; ++ip)
+                    equal = equal and state.mValues[i * valuesPerElement + ip] == state.mIds[i] - 1 + 0.25 * ip;
+        }
+        Check(numRead == static_cast<size_t>(graph.size()) and equal,
+              "element state is restarted on the new partition");
+
+        bool thrown = false;
+        try
+        {
+            ReadElementState("testRepartitioning.state", numParts, {graph.size() + 1});
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        Check(thrown, "missing element is reported");
+
+        // elements without values, only their ids are restarted
+        for (int part = 0; part < numParts; ++part)
+        {
+            states[part].mValuesPerElement = 0;
+            states[part].mValues.clear();
+            WriteElementState(states[part], "testRepartitioning.state" + std::to_string(part));
+        }
+        std::vector<int> allIds(graph.size());
+        std::iota(allIds.begin(), allIds.end(), 1);
+        const ElementState idsOnly = ReadElementState("testRepartitioning.state", numParts, allIds);
+        Check(idsOnly.mIds == allIds and idsOnly.mValues.empty(), "element state without values is restarted");
+
+        for (int part = 0; part < numParts; ++part)
+            std::remove(("testRepartitioning.state" + std::to_string(part)).c_str());
+    }
+
+    return TestResult();
+}
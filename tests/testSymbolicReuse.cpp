@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <eigen3/Eigen/SparseLU>
+#include <eigen3/Eigen/SparseCholesky>
+#include <eigen3/Eigen/Eigenvalues>
+#include "../SymbolicReuseSolver.h"
+#include "../SparseOrdering.h"
+#include "../2dExamples/MixedPrecisionSolver.h"
+#include "TestCheck.h"
+
+
+//! @brief Five point stencil on n x n nodes, the diagonal is scaled by \a damage like a degrading stiffness
+Eigen::SparseMatrix<double> Laplacian(int n, double damage)
+{
+    std::vector<Eigen::Triplet<double>> entries;
+    for (int y = 0; y < n; ++y)
+        for (int x = 0; x < n; ++x)
+        {
+            const int i = y * n + x;
+            entries.emplace_back(i, i, (4.5 - damage) * (1. + 0.1 * ((x + y) % 3)));
+            if (x + 1 < n)
+            {
+                entries.emplace_back(i, i + 1, -1.);
+                entries.emplace_back(i + 1, i, -1.);
+            }
+            if (y + 1 < n)
+            {
+                entries.emplace_back(i, i + n, -1.);
+                entries.emplace_back(i + n, i, -1.);
+            }
+        }
+    Eigen::SparseMatrix<double> matrix(n * n, n * n);
+    matrix.setFromTriplets(entries.begin(), entries.end());
+    return matrix;
+}
+
+
+template <typename Solver>
+void CheckReuse(const std::string& rName)
+{
+    const int n = 150;
+    const Eigen::VectorXd rhs = Eigen::VectorXd::Random(n * n);
+    NuTo::SymbolicReuseSolver<Solver> solver;
+
+    bool solved = true;
+    for (int iteration = 0; iteration < 5; ++iteration)
+    {
+        const Eigen::SparseMatrix<double> matrix = Laplacian(n, 0.1 * iteration);
+        solver.compute(matrix);
+        solved = solved and solver.info() == Eigen::Success and
+                 (matrix * solver.solve(rhs) - rhs).norm() < 1.e-10 * rhs.norm();
+    }
+    std::cout << "\n" << rName << ": analysis " << solver.GetAnalyzeTime() << " s, " << solver.GetNumFactorizations()
+              << " factorizations " << solver.GetFactorizeTime() << " s\n";
+    Check(solved, rName + " solves with the reused analysis");
+    Check(solver.GetNumAnalyses() == 1 and solver.GetNumFactorizations() == 5, rName + " analyzes the pattern once");
+
+    // a different numbering, e.g. after a repartitioning
+    const Eigen::SparseMatrix<double> larger = Laplacian(n + 1, 0.);
+    const Eigen::VectorXd largerRhs = Eigen::VectorXd::Random((n + 1) * (n + 1));
+    solver.compute(larger);
+    solved = (larger * solver.solve(largerRhs) - largerRhs).norm() < 1.e-10 * largerRhs.norm();
+    Check(solver.GetNumAnalyses() == 2 and solved, rName + " analyzes a new pattern");
+
+    // same size, one entry less
+    Eigen::SparseMatrix<double> pruned = larger;
+    pruned.coeffRef(0, 1) = 0.;
+    pruned.coeffRef(1, 0) = 0.;
+    pruned.prune(0.);
+    solver.compute(pruned);
+    solved = (pruned * solver.solve(largerRhs) - largerRhs).norm() < 1.e-10 * largerRhs.norm();
+    Check(solver.GetNumAnalyses() == 3 and solved, rName + " analyzes a pattern of the same size again");
+}
+
+
+//! @brief The refinement in double precision recovers the accuracy a float factorization alone cannot reach
+void CheckMixedPrecisionAccuracy()
+{
+    const Eigen::SparseMatrix<double> matrix = Laplacian(100, 2.);
+    Eigen::MatrixXd rhs = Eigen::MatrixXd::Random(matrix.rows(), 3);
+    rhs.col(1).setZero();
+
+    Eigen::SparseLU<Eigen::SparseMatrix<float>> lowPrecision(matrix.cast<float>());
+    const Eigen::VectorXf xLow = lowPrecision.solve(Eigen::VectorXf(rhs.col(0).cast<float>()));
+    const double errorLow = (matrix * xLow.cast<double>() - rhs.col(0)).norm() / rhs.col(0).norm();
+
+    Eigen::MixedPrecisionSolver<Eigen::SparseLU<Eigen::SparseMatrix<float>>> solver(matrix);
+    const Eigen::MatrixXd x = solver.solve(rhs);
+    const double error = std::max((matrix * x.col(0) - rhs.col(0)).norm() / rhs.col(0).norm(),
+                                  (matrix * x.col(2) - rhs.col(2)).norm() / rhs.col(2).norm());
+
+    std::cout << "\nMixedPrecisionSolver: relative residual " << error << ", float SparseLU " << errorLow << "\n";
+    Check(solver.info() == Eigen::Success and error < 1.e-12 and x.col(1).isZero(0.),
+          "MixedPrecisionSolver reaches 1e-12 for several right hand sides");
+    Check(errorLow > 1.e-10, "SparseLU in float alone does not reach double accuracy");
+
+    // shifted close to its smallest eigenvalue, the condition number of about 1e9 is too large for float factors
+    const Eigen::SparseMatrix<double> small = Laplacian(10, 0.);
+    const Eigen::VectorXd eigenvalues =
+            Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>(Eigen::MatrixXd(small)).eigenvalues();
+    Eigen::SparseMatrix<double> illConditioned = small;
+    for (int i = 0; i < small.rows(); ++i)
+        illConditioned.coeffRef(i, i) -= eigenvalues[0] - 1.e-9 * eigenvalues[small.rows() - 1];
+
+    solver.compute(illConditioned);
+    const Eigen::VectorXd illRhs = Eigen::VectorXd::Ones(small.rows());
+    const Eigen::VectorXd illX = solver.solve(illRhs);
+    const double illError = (illConditioned * illX - illRhs).norm() / illRhs.norm();
+    std::cout << "ill conditioned: relative residual " << illError << ", error() " << solver.error() << "\n";
+    Check(solver.info() == Eigen::NoConvergence and solver.error() > solver.tolerance() and
+                  std::abs(solver.error() - illError) < 1.e-6 * illError,
+          "MixedPrecisionSolver reports NoConvergence if the refinement stalls");
+
+    solver.compute(matrix);
+    solver.solve(rhs);
+    Check(solver.info() == Eigen::Success and solver.error() < 1.e-12,
+          "MixedPrecisionSolver reports Success again for a well conditioned matrix");
+}
+
+
+int main()
+{
+    CheckReuse<Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>>("SparseLU");
+    NuTo::SelectableOrdering<int>::Set(NuTo::eOrdering::NestedDissection);
+    CheckReuse<Eigen::SparseLU<Eigen::SparseMatrix<double>, NuTo::SelectableOrdering<int>>>("SparseLU, ND");
+    CheckReuse<Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>>>("SimplicialLDLT");
+    CheckReuse<Eigen::MixedPrecisionSolver<Eigen::SparseLU<Eigen::SparseMatrix<float>>>>("MixedPrecisionSolver");
+    CheckMixedPrecisionAccuracy();
+
+    return TestResult();
+}